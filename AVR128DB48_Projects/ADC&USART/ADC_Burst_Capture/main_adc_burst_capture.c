@@ -0,0 +1,92 @@
+/*
+ * main_adc_burst_capture.c
+ *
+ * Block capture of the potentiometer with the ADC_Burst module.
+ *
+ * TCB2 starts a conversion every 1/SAMPLE_RATE_HZ s through the Event System,
+ * the RESRDY ISR fills two buffers of BLOCK_SIZE samples in turns. Main gets
+ * every full block in on_block() and shows its mean and peak-to-peak noise,
+ * the number of blocks and the overruns on the LCD while the next block is
+ * being captured.
+ */
+
+#define F_CPU 4000000UL													// Set CPU Frequency to 4MHz
+#define SAMPLE_RATE_HZ 1000												// Conversions per second
+#define BLOCK_SIZE 128													// Samples per block (128ms at 1kHz)
+
+#include <avr/io.h>
+#include <avr/interrupt.h>												// Required for ISR usage
+#include <stdio.h>														// Used for handling the strings
+#include <stdbool.h>													// Used for bool variables
+#include "I2C_LCD.h"
+#include "ADC_Driver.h"
+#include "ADC_Trigger.h"
+#include "ADC_Burst.h"
+
+// Potentiometer on AIN19 (PF3): single 12-bit conversions, so the block shows the real noise
+static const adc_channel_t Pot_Channel = {
+	ADC_MUXPOS_AIN19_gc, VREF_REFSEL_VDD_gc, ADC_RESSEL_12BIT_gc, ADC_SAMPNUM_ACC1_gc, 0, 0
+};
+
+// Both blocks: one is filled by the ISR while main works on the other
+static uint16_t Burst_Buffer[2 * BLOCK_SIZE];
+
+void ADC0_init(void)
+{
+	// Disable the digital input buffer of PF3
+	PORTF.PIN3CTRL = PORT_ISC_INPUT_DISABLE_gc;
+
+	// ADC Clock = 4MHz / 4 = 1MHz, Result Ready Interrupt enabled
+	adc_driver_init(ADC_PRESC_DIV4_gc, true);
+}
+
+// Interrupt Service Routine: store the result in the current block
+ISR(ADC0_RESRDY_vect)
+{
+	adc_burst_on_result();
+}
+
+/**
+ * @brief Gets every complete block (from adc_burst_service() in main).
+ * @param samples BLOCK_SIZE contiguous samples, valid until the function returns
+ */
+static void on_block(const uint16_t *samples, uint16_t count)
+{
+	char Text[17];
+	uint32_t Sum = 0;
+	uint16_t Min = UINT16_MAX;
+	uint16_t Max = 0;
+
+	for (uint16_t i = 0; i < count; i++)
+	{
+		Sum += samples[i];
+		if (samples[i] < Min) Min = samples[i];
+		if (samples[i] > Max) Max = samples[i];
+	}
+
+	sprintf(Text, "Avg:%4lu PP:%3u  ", Sum / count, Max - Min);
+	lcd_moveCursor(0, 0);
+	lcd_putString(Text);
+
+	sprintf(Text, "Blk:%5u Ovr:%u ", adc_burst_blocks(), adc_burst_overruns());
+	lcd_moveCursor(0, 1);
+	lcd_putString(Text);
+}
+
+int main(void)
+{
+	lcd_init();
+	lcd_clear();
+
+	ADC0_init();
+	adc_burst_init(&Pot_Channel, Burst_Buffer, BLOCK_SIZE, on_block);
+	sei();
+
+	// From now on a block is complete every BLOCK_SIZE / SAMPLE_RATE_HZ s
+	adc_burst_start(ADC_TRIGGER_TCB2, SAMPLE_RATE_HZ);
+
+	while (1)
+	{
+		adc_burst_service();
+	}
+}
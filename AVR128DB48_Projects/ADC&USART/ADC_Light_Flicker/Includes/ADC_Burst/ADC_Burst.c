@@ -0,0 +1,143 @@
+/*
+ * ADC_Burst.c
+ *
+ * Each buffer has a "full" flag: the ISR sets it when the block is complete,
+ * main clears it after the callback. The ISR never writes into a buffer
+ * whose flag is set, so main can read it without locking.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "ADC_Burst.h"
+
+// VARIABLES //
+static const adc_channel_t *Burst_Channel = 0;
+static uint16_t *Burst_Buffer[2] = { 0, 0 };
+static uint16_t Burst_Size = 0;
+static adc_burst_callback_t Burst_Callback = 0;
+
+static uint8_t Fill = 0;						// Buffer the ISR writes to
+static uint16_t Fill_Pos = 0;					// Next sample in that buffer
+static volatile bool Full[2] = { false, false };
+static volatile uint16_t Blocks = 0;			// Blocks handed to main
+static volatile uint16_t Overruns = 0;			// Blocks thrown away
+
+// PRIVATE FUNCTIONS //
+
+static uint16_t read_counter(volatile uint16_t *counter)
+{
+	uint8_t sreg = SREG;
+	cli();
+	uint16_t value = *counter;
+	SREG = sreg;
+	return value;
+}
+
+// PUBLIC FUNCTIONS //
+
+/*
+	Selects the channel and sets up the buffers. Call after adc_driver_init().
+
+	@param buffer Storage for both blocks, 2 * block_size samples
+	@param block_size Samples per block
+	@param callback Gets every complete block (from adc_burst_service())
+	@return false if a parameter is missing or the channel could overflow RES
+*/
+bool adc_burst_init(const adc_channel_t *channel, uint16_t *buffer, uint16_t block_size, adc_burst_callback_t callback)
+{
+	if (buffer == 0 || block_size == 0 || callback == 0 || !adc_driver_select(channel))
+		return false;
+
+	Burst_Channel = channel;
+	Burst_Buffer[0] = buffer;
+	Burst_Buffer[1] = buffer + block_size;
+	Burst_Size = block_size;
+	Burst_Callback = callback;
+
+	Fill = 0;
+	Fill_Pos = 0;
+	Full[0] = false;
+	Full[1] = false;
+	Blocks = 0;
+	Overruns = 0;
+
+	return true;
+}
+
+/*
+	Starts the capture: the trigger timer runs at rate_hz from now on.
+
+	@return false if the rate is out of range for the source
+*/
+bool adc_burst_start(adc_trigger_source_t source, uint16_t rate_hz)
+{
+	return adc_trigger_init(source, rate_hz);
+}
+
+/*
+	Stops the trigger. The block that was being filled is discarded.
+*/
+void adc_burst_stop(void)
+{
+	adc_trigger_stop();
+	Fill_Pos = 0;
+}
+
+/*
+	Call from ADC0_RESRDY_vect.
+*/
+void adc_burst_on_result(void)
+{
+	Burst_Buffer[Fill][Fill_Pos] = adc_driver_result(Burst_Channel, ADC0.RES);	// Reading RES clears RESRDY
+
+	if (++Fill_Pos < Burst_Size)
+		return;
+
+	Fill_Pos = 0;
+
+	if (Full[Fill ^ 1])
+	{
+		Overruns++;								// Main still has the other block: refill this one
+	}
+	else
+	{
+		Full[Fill] = true;
+		Blocks++;
+		Fill ^= 1;
+	}
+}
+
+/*
+	Call from the main loop. Runs the callback for a complete block, if there is one.
+
+	@return true if a block was handled
+*/
+bool adc_burst_service(void)
+{
+	for (uint8_t i = 0; i < 2; i++)
+	{
+		if (Full[i])
+		{
+			Burst_Callback(Burst_Buffer[i], Burst_Size);
+			Full[i] = false;					// The ISR may use this buffer again
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+	@return Blocks completed and handed to main since init
+*/
+uint16_t adc_burst_blocks(void)
+{
+	return read_counter(&Blocks);
+}
+
+/*
+	@return Blocks lost because main was still busy with the previous one
+*/
+uint16_t adc_burst_overruns(void)
+{
+	return read_counter(&Overruns);
+}
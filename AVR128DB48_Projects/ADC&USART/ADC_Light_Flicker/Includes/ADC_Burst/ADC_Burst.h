@@ -0,0 +1,48 @@
+/*
+ * ADC_Burst.h
+ *
+ * Block capture of one ADC channel with two ping-pong buffers.
+ *
+ * ADC_Trigger starts the conversions at a fixed rate, the RESRDY ISR writes
+ * the results one after another into the current buffer. When it is full
+ * the ISR switches to the other buffer right away and main gets the full
+ * one through a callback (from adc_burst_service()). While the callback
+ * works on a block, the next block is being captured, so the sample stream
+ * has no gaps as long as one block is processed faster than the next one is
+ * filled (block_size / rate).
+ *
+ * If the other buffer is still in use when a block is complete, the new
+ * block is thrown away and the ISR refills the same buffer. The overrun is
+ * counted, the blocks main gets stay intact.
+ *
+ * Usage:
+ *  static uint16_t Burst_Buffer[2 * 128];
+ *  adc_driver_init(ADC_PRESC_DIV4_gc, true);
+ *  adc_burst_init(&Pot, Burst_Buffer, 128, on_block);
+ *  adc_burst_start(ADC_TRIGGER_TCB2, 1000);
+ *  ISR(ADC0_RESRDY_vect) { adc_burst_on_result(); }
+ *  main loop: adc_burst_service();   // calls on_block(samples, 128)
+ */
+
+#ifndef ADC_BURST_H_
+#define ADC_BURST_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../ADC_Driver/ADC_Driver.h"
+#include "../ADC_Trigger/ADC_Trigger.h"
+
+// Called from main with a complete block. The buffer is given back to the ISR when it returns.
+typedef void (*adc_burst_callback_t)(const uint16_t *samples, uint16_t count);
+
+bool adc_burst_init(const adc_channel_t *channel, uint16_t *buffer, uint16_t block_size, adc_burst_callback_t callback);
+bool adc_burst_start(adc_trigger_source_t source, uint16_t rate_hz);
+void adc_burst_stop(void);
+
+void adc_burst_on_result(void);
+bool adc_burst_service(void);
+
+uint16_t adc_burst_blocks(void);
+uint16_t adc_burst_overruns(void);
+
+#endif /* ADC_BURST_H_ */
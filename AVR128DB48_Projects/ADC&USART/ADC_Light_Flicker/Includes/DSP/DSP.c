@@ -0,0 +1,250 @@
+/*
+ * DSP.c
+ */
+
+#include "DSP.h"
+
+// sin(2 * pi * i / 256) in Q15 for the first quarter (i = 0 ... 64), the rest by symmetry
+static const int16_t Sine_Quarter[65] = {
+	    0,   804,  1608,  2410,  3212,  4011,  4808,  5602,
+	 6393,  7179,  7962,  8739,  9512, 10278, 11039, 11793,
+	12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530,
+	18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+	23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790,
+	27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+	30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971,
+	32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757,
+	32767
+};
+
+// PRIVATE FUNCTIONS //
+
+/*
+	@param index Angle in 1/256 of a full circle
+	@return sin(2 * pi * index / 256) in Q15
+*/
+static int16_t sine_256(uint8_t index)
+{
+	uint8_t quarter = index & 63;
+
+	switch (index >> 6)
+	{
+		case 0:  return Sine_Quarter[quarter];
+		case 1:  return Sine_Quarter[64 - quarter];
+		case 2:  return -Sine_Quarter[quarter];
+		default: return -Sine_Quarter[64 - quarter];
+	}
+}
+
+/*
+	(c * s) >> 14 for a Q14 coefficient and a 32-bit state (up to +-2^24),
+	as two 16 x 16 bit products instead of a 64-bit multiplication.
+*/
+static int32_t mul_q14(int16_t c, int32_t s)
+{
+	int16_t hi = (int16_t)(s >> 16);
+	uint16_t lo = (uint16_t)s;
+
+	return ((int32_t)c * hi) * 4 + (((int32_t)c * lo) >> 14);
+}
+
+// PUBLIC FUNCTIONS //
+
+/*
+	@param phase Angle, 65536 = full circle
+	@return sin(phase) in Q15, linear interpolation between the table entries (error < 4 LSB)
+*/
+int16_t dsp_sin_q15(uint16_t phase)
+{
+	uint8_t index = phase >> 8;
+	uint8_t frac = (uint8_t)phase;
+	int16_t a = sine_256(index);
+	int16_t b = sine_256(index + 1);
+
+	return a + (int16_t)(((int32_t)(b - a) * frac) >> 8);
+}
+
+int16_t dsp_cos_q15(uint16_t phase)
+{
+	return dsp_sin_q15(phase + 16384);
+}
+
+/*
+	@return floor(sqrt(x)), bit by bit (16 steps, no multiplication)
+*/
+uint16_t dsp_sqrt32(uint32_t x)
+{
+	uint32_t root = 0;
+	uint32_t bit = 1UL << 30;
+
+	while (bit > x)
+	{
+		bit >>= 2;
+	}
+
+	while (bit != 0)
+	{
+		if (x >= root + bit)
+		{
+			x -= root + bit;
+			root = (root >> 1) + bit;
+		}
+		else
+		{
+			root >>= 1;
+		}
+		bit >>= 2;
+	}
+	return (uint16_t)root;
+}
+
+/*
+	Sets the frequency of a Goertzel detector. The coefficients come from the
+	sine table, the only divisions are done here.
+
+	Near 0 and sample_hz / 2, cos(w) is within a few LSB of +-1 and the table
+	value alone is up to 1 LSB off, which shifts the detector frequency by a
+	large part of a bin. There the coefficient is taken from the half angle,
+	1 - |cos(w)| = 2 * sin^2(..), which is exact to a fraction of an LSB.
+
+	@param freq_hz Frequency to detect, below sample_hz / 2
+	@param sample_hz Sample rate of the blocks
+*/
+void dsp_goertzel_init(dsp_goertzel_t *g, uint16_t freq_hz, uint16_t sample_hz)
+{
+	uint16_t phase = (uint16_t)(((uint32_t)freq_hz << 16) / sample_hz);
+	uint16_t half = (uint16_t)(((uint32_t)freq_hz << 15) / sample_hz);		// phase / 2, not rounded twice
+	int32_t h;
+
+	if (half < 8192)
+	{
+		h = dsp_sin_q15(half);													// cos(w) = 1 - 2 * sin^2(w / 2)
+		int32_t cosine = 32768L - ((2 * h * h + 16384) >> 15);
+
+		g->coeff = (int16_t)(cosine > 32767 ? 32767 : cosine);				// 2 * cos in Q14 = cos in Q15
+	}
+	else
+	{
+		h = dsp_sin_q15(16384 - half);											// cos(w) = 2 * sin^2((pi - w) / 2) - 1
+		g->coeff = (int16_t)(-32768L + ((2 * h * h + 16384) >> 15));
+	}
+
+	g->sine = dsp_sin_q15(phase);
+	g->s1 = 0;
+	g->s2 = 0;
+}
+
+/*
+	Runs a block through the detector.
+	s = x + 2cos(w) * s1 - s2, then X = s1 - e^(-jw) * s2.
+	X is formed from the full 32-bit states, the power formula
+	s1^2 + s2^2 - 2cos(w) * s1 * s2 would cancel almost completely at low w.
+
+	@param samples ADC values, 12-bit
+	@param count Block length N, a power of 2 from 2 to 256
+	@param offset Subtracted from every sample (the block mean, removes DC)
+	@return Amplitude (peak) of the frequency in ADC counts
+*/
+uint16_t dsp_goertzel_run(dsp_goertzel_t *g, const uint16_t *samples, uint16_t count, uint16_t offset)
+{
+	int32_t s1 = 0;
+	int32_t s2 = 0;
+
+	for (uint16_t i = 0; i < count; i++)
+	{
+		int32_t s0 = (int16_t)(samples[i] - offset) + mul_q14(g->coeff, s1) - s2;
+		s2 = s1;
+		s1 = s0;
+	}
+	g->s1 = s1;
+	g->s2 = s2;
+
+	// 2 * X: real part 2 * s1 - 2cos(w) * s2, imaginary part 2sin(w) * s2
+	int32_t re = 2 * s1 - mul_q14(g->coeff, s2);
+	int32_t im = mul_q14(g->sine, s2);
+
+	// Scale down to 15 bits, so the sum of the squares fits into 32 bits
+	uint8_t shift = 0;
+	while (re > 32767 || re < -32767 || im > 32767 || im < -32767)
+	{
+		re >>= 1;
+		im >>= 1;
+		shift++;
+	}
+
+	uint32_t magnitude = (uint32_t)dsp_sqrt32((uint32_t)(re * re) + (uint32_t)(im * im)) << shift;
+
+	// Amplitude = 2 * |X| / N, N is a power of 2
+	uint8_t log2n = 0;
+	while ((1U << log2n) < count)
+	{
+		log2n++;
+	}
+	return (uint16_t)(magnitude >> log2n);
+}
+
+/*
+	In-place FFT, result scaled by 1/N.
+
+	@param re Real parts, inputs up to +-16384
+	@param im Imaginary parts (0 for real input)
+	@param log2n 6, 7 or 8 (64, 128 or 256 points), other sizes are ignored
+*/
+void dsp_fft(int16_t *re, int16_t *im, uint8_t log2n)
+{
+	if (log2n < DSP_FFT_MIN_LOG2 || log2n > DSP_FFT_MAX_LOG2)
+		return;
+
+	uint16_t n = 1U << log2n;
+
+	// Bit reversed order
+	for (uint16_t i = 0, j = 0; i < n; i++)
+	{
+		if (i < j)
+		{
+			int16_t t = re[i]; re[i] = re[j]; re[j] = t;
+			t = im[i]; im[i] = im[j]; im[j] = t;
+		}
+		uint16_t bit = n >> 1;
+		while (j & bit)
+		{
+			j ^= bit;
+			bit >>= 1;
+		}
+		j |= bit;
+	}
+
+	// Butterflies, W = cos - j sin from the 256 entry table
+	for (uint8_t stage = 1; stage <= log2n; stage++)
+	{
+		uint16_t half = 1U << (stage - 1);
+		uint8_t step = (uint8_t)(256 >> stage);		// Table index step of the twiddle factor
+
+		for (uint16_t k = 0; k < half; k++)
+		{
+			uint8_t index = (uint8_t)(k * step);
+			int16_t c = sine_256(index + 64);
+			int16_t s = sine_256(index);
+
+			for (uint16_t i = k; i < n; i += half << 1)
+			{
+				uint16_t j = i + half;
+				int16_t tr = (int16_t)(((int32_t)c * re[j] + (int32_t)s * im[j]) >> 15);
+				int16_t ti = (int16_t)(((int32_t)c * im[j] - (int32_t)s * re[j]) >> 15);
+
+				re[j] = (re[i] - tr) >> 1;
+				im[j] = (im[i] - ti) >> 1;
+				re[i] = (re[i] + tr) >> 1;
+				im[i] = (im[i] + ti) >> 1;
+			}
+		}
+	}
+}
+
+/*
+	@return |re + j im|
+*/
+uint16_t dsp_magnitude(int16_t re, int16_t im)
+{
+	return dsp_sqrt32((uint32_t)((int32_t)re * re) + (uint32_t)((int32_t)im * im));
+}
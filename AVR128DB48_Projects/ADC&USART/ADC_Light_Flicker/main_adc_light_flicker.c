@@ -0,0 +1,137 @@
+/*
+ * main_adc_light_flicker.c
+ *
+ * Light flicker meter with the photoresistor on AIN18 (PF2).
+ *
+ * ADC_Burst captures blocks of BLOCK_SIZE samples at SAMPLE_RATE_HZ. For every
+ * block main measures the amplitude at 100Hz and 120Hz (mains flicker at 50Hz
+ * and 60Hz) with Goertzel detectors and shows it as modulation depth
+ * (amplitude / mean). An FFT of the same block finds the strongest flicker
+ * frequency.
+ *
+ * 1280Hz / 256 samples = 5Hz per FFT bin, so 100Hz and 120Hz are exact bins.
+ */
+
+#define F_CPU 4000000UL													// Set CPU Frequency to 4MHz
+#define SAMPLE_RATE_HZ 1280												// Conversions per second
+#define BLOCK_LOG2 8
+#define BLOCK_SIZE (1 << BLOCK_LOG2)									// 256 samples = 200ms per block
+
+#include <avr/io.h>
+#include <avr/interrupt.h>												// Required for ISR usage
+#include <stdio.h>														// Used for handling the strings
+#include <stdbool.h>													// Used for bool variables
+#include "I2C_LCD.h"
+#include "ADC_Driver.h"
+#include "ADC_Trigger.h"
+#include "ADC_Burst.h"
+#include "DSP.h"
+
+// Photoresistor on AIN18 (PF2): single 12-bit conversions, longer sampling time for the high impedance divider
+static const adc_channel_t Light_Channel = {
+	ADC_MUXPOS_AIN18_gc, VREF_REFSEL_VDD_gc, ADC_RESSEL_12BIT_gc, ADC_SAMPNUM_ACC1_gc, 8, 0
+};
+
+static uint16_t Burst_Buffer[2 * BLOCK_SIZE];
+
+// FFT work buffers (the burst block must stay unchanged for the Goertzel detectors)
+static int16_t Fft_Re[BLOCK_SIZE];
+static int16_t Fft_Im[BLOCK_SIZE];
+
+static dsp_goertzel_t Flicker_100;										// 50Hz mains
+static dsp_goertzel_t Flicker_120;										// 60Hz mains
+
+void ADC0_init(void)
+{
+	// Disable the digital input buffer of PF2
+	PORTF.PIN2CTRL = PORT_ISC_INPUT_DISABLE_gc;
+
+	// ADC Clock = 4MHz / 4 = 1MHz, Result Ready Interrupt enabled
+	adc_driver_init(ADC_PRESC_DIV4_gc, true);
+}
+
+// Interrupt Service Routine: store the result in the current block
+ISR(ADC0_RESRDY_vect)
+{
+	adc_burst_on_result();
+}
+
+/**
+ * @brief Modulation depth in percent.
+ * @return amplitude / mean * 100, at most 100
+ */
+static uint8_t depth_percent(uint16_t amplitude, uint16_t mean)
+{
+	if (mean == 0 || amplitude >= mean)
+		return 100;
+
+	return (uint8_t)(((uint32_t)amplitude * 100) / mean);				// Once per block, not per sample
+}
+
+/**
+ * @brief Analyses one block (from adc_burst_service() in main) and updates the LCD.
+ */
+static void on_block(const uint16_t *samples, uint16_t count)
+{
+	char Text[17];
+	uint32_t Sum = 0;
+
+	for (uint16_t i = 0; i < count; i++)
+	{
+		Sum += samples[i];
+	}
+	uint16_t Mean = (uint16_t)(Sum >> BLOCK_LOG2);
+
+	// Amplitude at the two mains flicker frequencies
+	uint16_t Amp_100 = dsp_goertzel_run(&Flicker_100, samples, count, Mean);
+	uint16_t Amp_120 = dsp_goertzel_run(&Flicker_120, samples, count, Mean);
+
+	// Strongest frequency in the spectrum (DC removed, bin 0 skipped)
+	for (uint16_t i = 0; i < count; i++)
+	{
+		Fft_Re[i] = (int16_t)(samples[i] - Mean);
+		Fft_Im[i] = 0;
+	}
+	dsp_fft(Fft_Re, Fft_Im, BLOCK_LOG2);
+
+	uint16_t Peak_Bin = 0;
+	uint16_t Peak_Mag = 0;
+	for (uint16_t k = 1; k < count / 2; k++)
+	{
+		uint16_t Mag = dsp_magnitude(Fft_Re[k], Fft_Im[k]);
+		if (Mag > Peak_Mag)
+		{
+			Peak_Mag = Mag;
+			Peak_Bin = k;
+		}
+	}
+	uint16_t Peak_Hz = (uint16_t)(((uint32_t)Peak_Bin * SAMPLE_RATE_HZ) >> BLOCK_LOG2);
+
+	sprintf(Text, "100:%3u 120:%3u%%", depth_percent(Amp_100, Mean), depth_percent(Amp_120, Mean));
+	lcd_moveCursor(0, 0);
+	lcd_putString(Text);
+
+	sprintf(Text, "Pk:%3uHz Avg%4u", Peak_Hz, Mean);
+	lcd_moveCursor(0, 1);
+	lcd_putString(Text);
+}
+
+int main(void)
+{
+	lcd_init();
+	lcd_clear();
+
+	dsp_goertzel_init(&Flicker_100, 100, SAMPLE_RATE_HZ);
+	dsp_goertzel_init(&Flicker_120, 120, SAMPLE_RATE_HZ);
+
+	ADC0_init();
+	adc_burst_init(&Light_Channel, Burst_Buffer, BLOCK_SIZE, on_block);
+	sei();
+
+	adc_burst_start(ADC_TRIGGER_TCB2, SAMPLE_RATE_HZ);
+
+	while (1)
+	{
+		adc_burst_service();
+	}
+}
@@ -0,0 +1,185 @@
+/*
+ * ADC_Sequencer.c
+ *
+ * Each channel has a single producer / single consumer ring buffer like
+ * Event_Queue: the ISR only writes the head, main only writes the tail,
+ * both are free running 8-bit indices. A full buffer drops the new sample
+ * and counts an overrun, the samples main has not read yet stay intact.
+ * The samples are not volatile, a compiler barrier keeps main's copy of a
+ * slot in front of the tail store that releases it.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "ADC_Sequencer.h"
+#include "../Timestamp/Timestamp.h"
+
+// Memory accesses are not moved across it, no instruction is generated
+#define SEQ_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+typedef struct {
+	adc_sample_t samples[ADC_SEQUENCER_BUFFER_SIZE];
+	volatile uint8_t head;				// Written by the ISR
+	volatile uint8_t tail;				// Written by main
+	volatile uint8_t overruns;			// Samples lost because main did not read in time
+} adc_ring_t;
+
+// VARIABLES //
+static const adc_channel_t *Seq_Channels = 0;
+static uint8_t Seq_Count = 0;
+static uint8_t Seq_Current = 0;					// Channel that is selected right now
+static uint8_t Seq_Discard = 0;					// Conversions left to throw away on this channel
+static adc_ring_t Seq_Rings[ADC_SEQUENCER_MAX_CHANNELS];
+
+// PRIVATE FUNCTIONS //
+
+/*
+	Selects a channel and decides how many of its first results are settling results.
+*/
+static void select_channel(uint8_t index)
+{
+	const adc_channel_t *next = &Seq_Channels[index];
+
+	Seq_Discard = ((VREF.ADC0REF & VREF_REFSEL_gm) != next->refsel) ? ADC_SEQUENCER_REF_DISCARD : 0;
+	Seq_Current = index;
+	adc_driver_select(next);
+}
+
+// PUBLIC FUNCTIONS //
+
+/*
+	Checks the channel list, clears all buffers and selects the first channel.
+	Call after adc_driver_init() and before the conversions are triggered.
+	The list must stay valid (e.g. static const) while the sequencer runs.
+
+	@return false if the list is empty, too long or a channel could overflow RES
+*/
+bool adc_sequencer_init(const adc_channel_t *channels, uint8_t count)
+{
+	if (count == 0 || count > ADC_SEQUENCER_MAX_CHANNELS)
+		return false;
+
+	for (uint8_t i = 0; i < count; i++)
+	{
+		if (!adc_driver_valid(&channels[i]))
+			return false;
+	}
+
+	for (uint8_t i = 0; i < ADC_SEQUENCER_MAX_CHANNELS; i++)
+	{
+		Seq_Rings[i].head = 0;
+		Seq_Rings[i].tail = 0;
+		Seq_Rings[i].overruns = 0;
+	}
+
+	Seq_Channels = channels;
+	Seq_Count = count;
+	select_channel(0);
+	Seq_Discard = ADC_SEQUENCER_REF_DISCARD;			// The reference may just have been switched on
+
+	return true;
+}
+
+/*
+	Call from ADC0_RESRDY_vect. Stores the result (unless it is a settling
+	result) and switches to the next channel for the next trigger.
+*/
+void adc_sequencer_on_result(void)
+{
+	uint16_t res = ADC0.RES;							// Also clears the RESRDY flag
+
+	if (Seq_Count == 0)
+		return;
+
+	if (Seq_Discard > 0)
+	{
+		Seq_Discard--;									// Reference still settling, stay on this channel
+		return;
+	}
+
+	adc_ring_t *ring = &Seq_Rings[Seq_Current];
+	uint8_t head = ring->head;
+
+	if ((uint8_t)(head - ring->tail) < ADC_SEQUENCER_BUFFER_SIZE)
+	{
+		adc_sample_t *s = &ring->samples[head & ADC_SEQUENCER_BUFFER_MASK];
+		s->value = adc_driver_result(&Seq_Channels[Seq_Current], res);
+		s->cycles = timestamp_cycles();
+		ring->head = head + 1;
+	}
+	else if (ring->overruns < UINT8_MAX)
+	{
+		ring->overruns++;
+	}
+
+	uint8_t next = Seq_Current + 1;
+	select_channel((next < Seq_Count) ? next : 0);
+}
+
+/*
+	Takes the oldest sample of a channel.
+
+	@param channel Index in the channel list
+	@return false if no sample is waiting
+*/
+bool adc_sequencer_read(uint8_t channel, adc_sample_t *sample)
+{
+	if (channel >= Seq_Count)
+		return false;
+
+	adc_ring_t *ring = &Seq_Rings[channel];
+	uint8_t tail = ring->tail;
+
+	if (ring->head == tail)
+		return false;
+
+	*sample = ring->samples[tail & ADC_SEQUENCER_BUFFER_MASK];
+
+	SEQ_BARRIER();
+	ring->tail = tail + 1;								// Release the slot only after it was copied
+
+	return true;
+}
+
+/*
+	@return Number of samples waiting in the buffer of a channel
+*/
+uint8_t adc_sequencer_available(uint8_t channel)
+{
+	if (channel >= Seq_Count)
+		return 0;
+
+	return (uint8_t)(Seq_Rings[channel].head - Seq_Rings[channel].tail);
+}
+
+/*
+	@return Samples of a channel that were dropped because its buffer was full (saturates at 255)
+*/
+uint8_t adc_sequencer_overruns(uint8_t channel)
+{
+	if (channel >= Seq_Count)
+		return 0;
+
+	return Seq_Rings[channel].overruns;
+}
+
+/*
+	@return Conversions one full scan needs, including the settling conversions after reference changes
+			(per channel rate = trigger rate / this value)
+*/
+uint8_t adc_sequencer_conversions_per_scan(void)
+{
+	uint8_t n = Seq_Count;
+
+	for (uint8_t i = 0; i < Seq_Count; i++)
+	{
+		uint8_t next = (i + 1 < Seq_Count) ? i + 1 : 0;
+
+		if (Seq_Channels[i].refsel != Seq_Channels[next].refsel)
+		{
+			n += ADC_SEQUENCER_REF_DISCARD;
+		}
+	}
+
+	return n;
+}
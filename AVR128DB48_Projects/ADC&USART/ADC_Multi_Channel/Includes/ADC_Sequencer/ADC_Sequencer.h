@@ -0,0 +1,65 @@
+/*
+ * ADC_Sequencer.h
+ *
+ * Multi-channel ADC scan driven by the RESRDY interrupt.
+ *
+ * The sequencer owns a list of ADC_Driver channels. Every result is stored
+ * with its timestamp (Timestamp module, CLK_PER cycles) in the ring buffer of
+ * its channel, then the next channel of the list is selected. The conversions
+ * themselves are started by ADC_Trigger, so the trigger rate is the aggregate
+ * rate and each channel is sampled at (rate / number of conversions per scan).
+ *
+ * When the next channel uses a different reference, the reference needs time
+ * to settle: ADC_SEQUENCER_REF_DISCARD conversions are taken and thrown away
+ * first. They cost trigger slots, not CPU time.
+ *
+ * Usage:
+ *  static const adc_channel_t Channels[] = { {...AIN18...}, {...AIN19...}, {...TEMPSENSE...} };
+ *  timestamp_init(); adc_driver_init(ADC_PRESC_DIV4_gc, true);
+ *  adc_sequencer_init(Channels, 3);
+ *  adc_trigger_init(ADC_TRIGGER_TCB2, 50);
+ *  ISR(ADC0_RESRDY_vect) { adc_sequencer_on_result(); }
+ *  main: adc_sample_t s; while (adc_sequencer_read(1, &s)) { ... s.value, s.cycles ... }
+ */
+
+#ifndef ADC_SEQUENCER_H_
+#define ADC_SEQUENCER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../ADC_Driver/ADC_Driver.h"
+
+#ifndef ADC_SEQUENCER_MAX_CHANNELS
+#define ADC_SEQUENCER_MAX_CHANNELS 4
+#endif
+
+// Samples kept per channel. Must be a power of 2 and at most 128.
+#ifndef ADC_SEQUENCER_BUFFER_SIZE
+#define ADC_SEQUENCER_BUFFER_SIZE 8
+#endif
+
+#define ADC_SEQUENCER_BUFFER_MASK (ADC_SEQUENCER_BUFFER_SIZE - 1)
+
+#if (ADC_SEQUENCER_BUFFER_SIZE & ADC_SEQUENCER_BUFFER_MASK) != 0 || ADC_SEQUENCER_BUFFER_SIZE > 128
+#error "ADC_SEQUENCER_BUFFER_SIZE must be a power of 2 and <= 128"
+#endif
+
+// Conversions thrown away after the reference (VREF) was changed
+#ifndef ADC_SEQUENCER_REF_DISCARD
+#define ADC_SEQUENCER_REF_DISCARD 1
+#endif
+
+typedef struct {
+	uint16_t value;						// adc_driver_result() of the channel
+	uint32_t cycles;					// timestamp_cycles() when the result was read
+} adc_sample_t;
+
+bool adc_sequencer_init(const adc_channel_t *channels, uint8_t count);
+void adc_sequencer_on_result(void);
+
+bool adc_sequencer_read(uint8_t channel, adc_sample_t *sample);
+uint8_t adc_sequencer_available(uint8_t channel);
+uint8_t adc_sequencer_overruns(uint8_t channel);
+uint8_t adc_sequencer_conversions_per_scan(void);
+
+#endif /* ADC_SEQUENCER_H_ */
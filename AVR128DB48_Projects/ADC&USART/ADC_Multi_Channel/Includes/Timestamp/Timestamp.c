@@ -0,0 +1,142 @@
+/*
+ * Timestamp.c
+ *
+ * TCB1 runs in Periodic Interrupt Mode with CCMP = 0xFFFF, so CNT wraps every
+ * 65536 cycles and sets the CAPT flag. The ISR counts these wraps in
+ * Ts_Overflows, which forms the upper bits of the timestamp.
+ *
+ * A read has to combine CNT and Ts_Overflows consistently. If the counter
+ * wrapped but the ISR has not run yet (we are inside another ISR or the wrap
+ * happened during the read), the CAPT flag is still set and CNT is small:
+ * in that case the pending overflow is added by hand.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "Timestamp.h"
+
+// VARIABLES //
+static volatile uint32_t Ts_Overflows = 0;					// Number of TCB1 wraps (65536 cycles each)
+
+// PRIVATE FUNCTIONS //
+
+/*
+	Reads overflow count and counter as one consistent pair.
+	Interrupts are disabled for about 20 cycles and restored to their previous state,
+	so this is safe in ISRs and in main.
+*/
+static void timestamp_read(uint32_t *overflows, uint16_t *count)
+{
+	uint8_t sreg = SREG;
+	cli();
+
+	uint16_t cnt = TCB1.CNT;
+	uint32_t ovf = Ts_Overflows;
+
+	if ((TCB1.INTFLAGS & TCB_CAPT_bm) && cnt < 0x8000)
+	{
+		ovf++;													// Wrap happened but the ISR has not counted it yet
+	}
+
+	SREG = sreg;
+
+	*overflows = ovf;
+	*count = cnt;
+}
+
+// PUBLIC FUNCTIONS //
+
+/*
+	Starts TCB1 as free-running cycle counter (CLK_PER, no prescaler).
+*/
+void timestamp_init(void)
+{
+	Ts_Overflows = 0;
+
+	TCB1.CTRLA = 0;												// Stop while configuring
+	TCB1.CNT = 0;
+	TCB1.CCMP = 0xFFFF;											// Full 16-bit period
+	TCB1.CTRLB = TCB_CNTMODE_INT_gc;							// Periodic Interrupt Mode
+	TCB1.INTFLAGS = TCB_CAPT_bm;
+	TCB1.INTCTRL = TCB_CAPT_bm;									// Interrupt on every wrap
+	TCB1.CTRLA = TCB_CLKSEL_DIV1_gc | TCB_ENABLE_bm;			// Count CLK_PER
+}
+
+/*
+	@return CLK_PER cycles since timestamp_init() (wraps after 2^32 cycles, ~17.9 min at 4MHz)
+*/
+uint32_t timestamp_cycles(void)
+{
+	uint32_t ovf;
+	uint16_t cnt;
+
+	timestamp_read(&ovf, &cnt);
+
+	return (ovf << 16) | cnt;
+}
+
+/*
+	@return Microseconds since timestamp_init() (wraps after 2^32 us, ~71.6 min)
+*/
+uint32_t timestamp_us(void)
+{
+	uint32_t ovf;
+	uint16_t cnt;
+
+	timestamp_read(&ovf, &cnt);
+
+	// (ovf * 65536 + cnt) / cycles_per_us, truncated to 32 bits, without a 48-bit intermediate
+	return (ovf << (16 - TIMESTAMP_US_SHIFT)) | (cnt >> TIMESTAMP_US_SHIFT);
+}
+
+/*
+	@param start_cycles Value previously returned by timestamp_cycles()
+	@return Cycles elapsed since start_cycles (correct across one wrap)
+*/
+uint32_t timestamp_elapsed_cycles(uint32_t start_cycles)
+{
+	return timestamp_cycles() - start_cycles;
+}
+
+/*
+	@param start_us Value previously returned by timestamp_us()
+	@return Microseconds elapsed since start_us (correct across one wrap)
+*/
+uint32_t timestamp_elapsed_us(uint32_t start_us)
+{
+	return timestamp_us() - start_us;
+}
+
+/*
+	Busy-waits for the given time. Unlike a counting loop the duration does not
+	depend on the compiler or optimization level, only on CLK_PER.
+	Waits longer than 16ms need global interrupts enabled (overflow ISR).
+
+	@param us Time to wait in microseconds
+*/
+void timestamp_delay_us(uint32_t us)
+{
+	uint32_t start = timestamp_us();
+
+	while (timestamp_elapsed_us(start) < us)
+	{
+		;
+	}
+}
+
+/*
+	@param ms Time to wait in milliseconds
+*/
+void timestamp_delay_ms(uint16_t ms)
+{
+	timestamp_delay_us((uint32_t)ms * 1000UL);
+}
+
+/*
+	TCB1 wrapped: extend the counter.
+*/
+ISR(TCB1_INT_vect)
+{
+	TCB1.INTFLAGS = TCB_CAPT_bm;
+	Ts_Overflows++;
+}
@@ -0,0 +1,186 @@
+/*
+ * main_adc_multi_channel.c
+ *
+ * Light, potentiometer and chip temperature sampled by one firmware.
+ *
+ * TCB2 starts a conversion every 1/SCAN_RATE_HZ s through the Event System,
+ * the ADC_Sequencer steps through the three channels in the RESRDY ISR and
+ * keeps timestamped samples per channel. Main reads them at its own pace,
+ * runs them through a filter chain per channel and shows the results on the LCD.
+ */
+
+#define F_CPU 4000000UL													// Set CPU Frequency to 4MHz
+#define SCAN_RATE_HZ 50													// Conversions per second for all channels together
+#define DISPLAY_PERIOD_MS 250											// LCD update interval
+#define LIGHT_MAX_MV 2900												// Photoresistor voltage shown as 100%
+
+#include <avr/io.h>
+#include <avr/interrupt.h>												// Required for ISR usage
+#include <stdio.h>														// Used for handling the strings
+#include <stdbool.h>													// Used for bool variables
+#include "I2C_LCD.h"
+#include "Timestamp.h"
+#include "ADC_Driver.h"
+#include "ADC_Trigger.h"
+#include "ADC_Sequencer.h"
+#include "Fixed_Point.h"
+#include "Filter.h"
+
+// Index of each channel in Channels[]
+enum {
+	CH_LIGHT,
+	CH_POT,
+	CH_TEMP,
+	CH_COUNT
+};
+
+// Scan list: VDD reference for the two dividers, 1.024V for the temperature sensor
+static const adc_channel_t Channels[CH_COUNT] = {
+	[CH_LIGHT] = { ADC_MUXPOS_AIN18_gc,     VREF_REFSEL_VDD_gc,   ADC_RESSEL_12BIT_gc, ADC_SAMPNUM_ACC16_gc, 8,  2 },	// PF2, 14-bit
+	[CH_POT]   = { ADC_MUXPOS_AIN19_gc,     VREF_REFSEL_VDD_gc,   ADC_RESSEL_12BIT_gc, ADC_SAMPNUM_ACC16_gc, 0,  2 },	// PF3, 14-bit
+	[CH_TEMP]  = { ADC_MUXPOS_TEMPSENSE_gc, VREF_REFSEL_1V024_gc, ADC_RESSEL_12BIT_gc, ADC_SAMPNUM_ACC16_gc, 31, 4 },	// 12-bit average
+};
+
+// Factory Calibration Value
+uint16_t Sigrow_ADC_Cal_Val = 0;
+
+// Conversion factors without run time division: the two dividers have a 14-bit full scale of 16380,
+// the temperature reciprocal (K = ADC * 358 / Sigrow_ADC_Cal_Val) is computed once at startup
+static const fixed_scale_t Mv_Scale = FIXED_SCALE(3300, 16380);
+static const fixed_scale_t Light_Percent_Scale = FIXED_SCALE(100, LIGHT_MAX_MV);
+static const fixed_scale_t Pot_Percent_Scale = FIXED_SCALE(100, 16380);
+static fixed_scale_t Temp_K_Scale;
+static bool Temp_K_Scale_Valid = false;
+
+// Filtered value and sample timing per channel
+typedef struct {
+	uint16_t value;														// Output of the filter chain
+	uint32_t last_cycles;												// Timestamp of the newest sample
+	uint32_t period_cycles;												// Time between the two newest samples
+} channel_stats_t;
+
+static channel_stats_t Stats[CH_COUNT];
+
+// Filter chain per channel: median of 5 (spikes) -> EMA 1/4 (noise), no division per sample
+#define CHAIN_LENGTH 2
+
+static filter_median_t Median[CH_COUNT];
+static filter_ema_t Ema[CH_COUNT];
+
+static const filter_stage_t Chains[CH_COUNT][CHAIN_LENGTH] = {
+	[CH_LIGHT] = { FILTER_MEDIAN_STAGE(&Median[CH_LIGHT]), FILTER_EMA_STAGE(&Ema[CH_LIGHT]) },
+	[CH_POT]   = { FILTER_MEDIAN_STAGE(&Median[CH_POT]),   FILTER_EMA_STAGE(&Ema[CH_POT]) },
+	[CH_TEMP]  = { FILTER_MEDIAN_STAGE(&Median[CH_TEMP]),  FILTER_EMA_STAGE(&Ema[CH_TEMP]) },
+};
+
+void ADC0_init(void)
+{
+	// Disable the digital input buffers of PF2 (AIN18) and PF3 (AIN19)
+	PORTF.PIN2CTRL = PORT_ISC_INPUT_DISABLE_gc;
+	PORTF.PIN3CTRL = PORT_ISC_INPUT_DISABLE_gc;
+	
+	// ADC Clock = 4MHz / 4 = 1MHz, Result Ready Interrupt enabled
+	adc_driver_init(ADC_PRESC_DIV4_gc, true);
+	adc_sequencer_init(Channels, CH_COUNT);
+}
+
+// Interrupt Service Routine: store the result, select the next channel
+ISR(ADC0_RESRDY_vect)
+{
+	adc_sequencer_on_result();
+}
+
+/**
+ * @brief Runs all waiting samples of all channels through their filter chains.
+ */
+static void collect_samples(void)
+{
+	adc_sample_t Sample;
+	
+	for (uint8_t Ch = 0; Ch < CH_COUNT; Ch++)
+	{
+		while (adc_sequencer_read(Ch, &Sample))
+		{
+			if (Stats[Ch].last_cycles != 0)
+			{
+				Stats[Ch].period_cycles = Sample.cycles - Stats[Ch].last_cycles;
+			}
+			Stats[Ch].last_cycles = Sample.cycles;
+			Stats[Ch].value = filter_chain_update(Chains[Ch], CHAIN_LENGTH, Sample.value);
+		}
+	}
+}
+
+/**
+ * @brief Sets up the filter chains of all channels.
+ */
+static void filters_init(void)
+{
+	for (uint8_t Ch = 0; Ch < CH_COUNT; Ch++)
+	{
+		filter_median_init(&Median[Ch], 5);
+		filter_ema_init(&Ema[Ch], 2);
+	}
+}
+
+/**
+ * @brief Converts the filtered values and writes both LCD lines.
+ */
+static void update_display(void)
+{
+	char Text[17];
+	
+	uint16_t Light_Mv = fixed_scale(&Mv_Scale, Stats[CH_LIGHT].value);
+	uint16_t Light_Perc = fixed_scale(&Light_Percent_Scale, Light_Mv);
+	uint16_t Pot_Perc = fixed_scale(&Pot_Percent_Scale, Stats[CH_POT].value);
+	
+	int32_t Temp_C = 0;
+	uint16_t Temp_Raw = Stats[CH_TEMP].value;
+	if (Temp_K_Scale_Valid)
+	{
+		Temp_C = (int32_t)fixed_scale(&Temp_K_Scale, Temp_Raw) - 273;
+	}
+	
+	// Per channel sample rate from the timestamps of its two newest samples
+	uint16_t Rate_Hz = (Stats[CH_TEMP].period_cycles > 0) ? F_CPU / Stats[CH_TEMP].period_cycles : 0;
+	
+	sprintf(Text, "L:%3u%% P:%3u%%   ", Light_Perc, Pot_Perc);
+	lcd_moveCursor(0, 0);
+	lcd_putString(Text);
+	
+	sprintf(Text, "T:%3ldC %2uHz/ch  ", Temp_C, Rate_Hz);
+	lcd_moveCursor(0, 1);
+	lcd_putString(Text);
+}
+
+int main(void)
+{
+	lcd_init();
+	lcd_clear();
+	
+	// Read Calibration Data
+	Sigrow_ADC_Cal_Val = SIGROW.TEMPSENSE0 | (SIGROW.TEMPSENSE1 << 8);
+	Temp_K_Scale_Valid = fixed_scale_init(&Temp_K_Scale, 358, Sigrow_ADC_Cal_Val, 4095);
+	
+	filters_init();
+	timestamp_init();
+	ADC0_init();
+	sei();
+	
+	// SCAN_RATE_HZ conversions per second are shared by the channels:
+	// 3 channels + 2 settling conversions (VDD <-> 1.024V) = 10 samples per channel and second
+	adc_trigger_init(ADC_TRIGGER_TCB2, SCAN_RATE_HZ);
+	
+	uint32_t Last_Display = timestamp_cycles();
+	
+	while (1)
+	{
+		collect_samples();
+		
+		if (timestamp_elapsed_cycles(Last_Display) >= (uint32_t)DISPLAY_PERIOD_MS * (F_CPU / 1000))
+		{
+			Last_Display += (uint32_t)DISPLAY_PERIOD_MS * (F_CPU / 1000);
+			update_display();
+		}
+	}
+}
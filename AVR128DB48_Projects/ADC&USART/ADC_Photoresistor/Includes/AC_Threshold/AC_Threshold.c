@@ -0,0 +1,102 @@
+/*
+ * AC_Threshold.c
+ */
+
+#ifndef F_CPU
+#define F_CPU 4000000UL
+#endif
+
+#include <avr/io.h>
+#include <util/delay.h>
+#include "AC_Threshold.h"
+
+#define AC_STARTUP_us 10						// Comparator start-up time before the first state is valid
+
+// VARIABLES //
+static uint8_t Dacref_Rising = 0;				// Used while the input is below: threshold + hysteresis / 2
+static uint8_t Dacref_Falling = 0;				// Used while the input is above: threshold - hysteresis / 2
+
+// PRIVATE FUNCTIONS //
+
+/*
+	@return DACREF value for mv: DACREF / 256 * ref_mv = mv (rounded, at most 255)
+*/
+static uint8_t to_dacref(uint16_t mv, uint16_t ref_mv)
+{
+	uint32_t value = (((uint32_t)mv << 8) + ref_mv / 2) / ref_mv;
+
+	return (value > 255) ? 255 : (uint8_t)value;
+}
+
+// PUBLIC FUNCTIONS //
+
+/*
+	Sets up AC0 (DACREF as negative input), enables it in standby and the
+	interrupt on both edges. The digital input buffer of the pin should be
+	disabled by the caller (PORT_ISC_INPUT_DISABLE_gc).
+
+	@return false if the threshold +- hysteresis / 2 is outside 0 ... ref_mv (nothing is changed)
+*/
+bool ac_threshold_init(const ac_threshold_t *config)
+{
+	uint16_t half = config->hysteresis_mv / 2;
+
+	if (config->ref_mv == 0 || config->threshold_mv < half ||
+		(uint32_t)config->threshold_mv + half >= config->ref_mv)
+		return false;
+
+	Dacref_Rising = to_dacref(config->threshold_mv + half, config->ref_mv);
+	Dacref_Falling = to_dacref(config->threshold_mv - half, config->ref_mv);
+
+	AC0.CTRLA = 0;
+	AC0.INTCTRL = 0;
+	VREF.ACREF = config->acref;
+	AC0.MUXCTRL = config->muxpos | AC_MUXNEG_DACREF_gc;
+	AC0.DACREF = Dacref_Rising;
+	AC0.CTRLA = config->hysmode | AC_RUNSTDBY_bm | AC_ENABLE_bm;
+	_delay_us(AC_STARTUP_us);
+
+	// Start with the threshold that belongs to the current side
+	if (AC0.STATUS & AC_CMPSTATE_bm)
+	{
+		AC0.DACREF = Dacref_Falling;
+	}
+
+	AC0.STATUS = AC_CMPIF_bm;
+	AC0.INTCTRL = AC_INTMODE_NORMAL_BOTHEDGE_gc | AC_CMP_bm;
+	return true;
+}
+
+/*
+	Disables AC0 and its interrupt.
+*/
+void ac_threshold_stop(void)
+{
+	AC0.INTCTRL = 0;
+	AC0.CTRLA = 0;
+	AC0.STATUS = AC_CMPIF_bm;
+}
+
+/*
+	@return true if the input is above the threshold
+*/
+bool ac_threshold_above(void)
+{
+	return (AC0.STATUS & AC_CMPSTATE_bm) != 0;
+}
+
+/*
+	Call from AC0_AC_vect. Clears the flag and moves the threshold to the other
+	side of the hysteresis band.
+
+	@return true if the input is now above the threshold
+*/
+bool ac_threshold_on_crossing(void)
+{
+	AC0.STATUS = AC_CMPIF_bm;
+
+	bool above = ac_threshold_above();
+	AC0.DACREF = above ? Dacref_Falling : Dacref_Rising;
+
+	return above;
+}
@@ -0,0 +1,51 @@
+/*
+ * AC_Threshold.h
+ *
+ * Threshold detection with the Analog Comparator AC0 instead of ADC conversions.
+ *
+ * The positive input is a pin (AINPn), the negative input is the DACREF of
+ * AC0: an 8-bit fraction of an internal reference (VREF.ACREF), so the
+ * threshold is set in mV without any external part. The comparator runs
+ * continuously in hardware and raises an interrupt only when the input
+ * crosses the threshold, the CPU can sleep in standby in between and the
+ * ADC can stay off.
+ *
+ * Hysteresis:
+ *  - hardware: AC_HYSMODE_SMALL/MEDIUM/LARGE_gc (about 10/25/50mV)
+ *  - programmable: with hysteresis_mv the threshold moves to threshold + hysteresis_mv / 2
+ *    while the input is below and to threshold - hysteresis_mv / 2 while it is above.
+ *    Both DACREF values are computed once in ac_threshold_init(), the ISR only swaps them.
+ *
+ * The comparator output is also an Event System generator (EVSYS_CHANNELn_AC0_OUT_gc),
+ * e.g. to start an ADC conversion or count crossings with a timer without the CPU.
+ *
+ * Usage:
+ *  static const ac_threshold_t Dark = { AC_MUXPOS_AINP0_gc, VREF_REFSEL_VDD_gc, 3300, 1450, 100, AC_HYSMODE_MEDIUM_gc };
+ *  ac_threshold_init(&Dark);
+ *  ISR(AC0_AC_vect) { bool above = ac_threshold_on_crossing(); ... }
+ *
+ * Resources: AC0, VREF.ACREF.
+ */
+
+#ifndef AC_THRESHOLD_H_
+#define AC_THRESHOLD_H_
+
+#include <avr/io.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+	uint8_t muxpos;						// AC_MUXPOS_AINPn_gc, positive input pin
+	uint8_t acref;						// VREF_REFSEL_xxx_gc, reference the DACREF divides
+	uint16_t ref_mv;					// Voltage of that reference in mV
+	uint16_t threshold_mv;				// Switching point
+	uint16_t hysteresis_mv;				// Programmable hysteresis (total width), 0 = hardware hysteresis only
+	uint8_t hysmode;					// AC_HYSMODE_xxx_gc
+} ac_threshold_t;
+
+bool ac_threshold_init(const ac_threshold_t *config);
+void ac_threshold_stop(void);
+bool ac_threshold_above(void);
+bool ac_threshold_on_crossing(void);
+
+#endif /* AC_THRESHOLD_H_ */
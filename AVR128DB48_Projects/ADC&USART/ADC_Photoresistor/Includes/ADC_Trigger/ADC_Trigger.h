@@ -0,0 +1,53 @@
+/*
+ * ADC_Trigger.h
+ *
+ * Hardware-timed ADC sampling through the Event System (EVSYS).
+ *
+ * A timer event is routed to ADC0 "start conversion" (ADC0.EVCTRL STARTEI),
+ * so conversions start at an exact rate without any CPU involvement.
+ * The CPU only has to read the result in ADC0_RESRDY_vect.
+ *
+ * Sources:
+ *  - ADC_TRIGGER_TCB2: TCB2 periodic at CLK_PER/2, for rates from 31Hz to the ADC limit
+ *  - ADC_TRIGGER_RTC:  RTC overflow at 32.768kHz (OSC32K), for rates from 1Hz to 16kHz.
+ *                      If RTC_Clock already runs the counter, its 1Hz overflow is shared
+ *                      (only rate 1, the counter is left alone and keeps counting after stop)
+ *
+ * Jitter can be measured by calling adc_trigger_mark() first thing in the RESRDY ISR
+ * (needs the Timestamp module running). Period min/max are then available
+ * through adc_trigger_get_jitter(); max - min is the peak-to-peak jitter.
+ *
+ * Resources: EVSYS channel 0, TCB2 or the RTC counter (the RTC PIT stays free).
+ */
+
+#ifndef ADC_TRIGGER_H_
+#define ADC_TRIGGER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef F_CPU
+#define F_CPU 4000000UL
+#endif
+
+#define ADC_TRIGGER_RTC_HZ 32768UL
+
+typedef enum {
+	ADC_TRIGGER_TCB2,
+	ADC_TRIGGER_RTC
+} adc_trigger_source_t;
+
+typedef struct {
+	uint16_t count;								// Number of periods measured
+	uint32_t period_min;						// Shortest time between two results (CLK_PER cycles)
+	uint32_t period_max;						// Longest time between two results (CLK_PER cycles)
+} adc_jitter_t;
+
+bool adc_trigger_init(adc_trigger_source_t source, uint16_t rate_hz);
+void adc_trigger_stop(void);
+
+void adc_trigger_mark(void);
+void adc_trigger_get_jitter(adc_jitter_t *jitter);
+void adc_trigger_reset_jitter(void);
+
+#endif /* ADC_TRIGGER_H_ */
@@ -0,0 +1,28 @@
+/*
+ * Fixed_Point.c
+ */
+
+#include "Fixed_Point.h"
+
+/*
+	Prepares a scale with a divisor that is only known at run time (e.g. from the signature row).
+	This is the only division, every fixed_scale() call afterwards is division free.
+
+	@param num Multiplier
+	@param den Divisor
+	@param x_max Largest input that will be scaled
+	@return false if den is 0 or x_max * num / den does not fit into 16 bits (scale is not changed)
+*/
+bool fixed_scale_init(fixed_scale_t *scale, uint16_t num, uint16_t den, uint16_t x_max)
+{
+	// Same check as FIXED_SCALE_FITS(), without a division
+	if (den == 0 || (uint32_t)x_max * num > 0xFFFFUL * den + (den - 1))
+	{
+		return false;
+	}
+	
+	scale->mult = ((uint32_t)num << 16) / den;
+	scale->num = num;
+	scale->den = den;
+	return true;
+}
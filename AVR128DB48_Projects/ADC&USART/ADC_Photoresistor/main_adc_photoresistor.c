@@ -8,16 +8,103 @@
  */ 
 
 #define F_CPU 4000000UL													// Set CPU Frequency to 4MHz
+#define SAMPLE_RATE_HZ 50												// Conversions per second, started by TCB2 via the Event System
+#define ADC_DEADBAND 32													// Changes up to +-32 LSB (14-bit, ~6mV) do not interrupt
+#define ADC_FULL_SCALE 16380U											// adc_driver_full_scale(&Light_Channel)
 
 #include <avr/io.h>
 #include <avr/interrupt.h>												// Required for ISR usage
 #include <stdio.h>														// Used for handling the strings
 #include <stdbool.h>													// Used for bool variables
 #include "I2C_LCD.h"
+#include "Event_Queue.h"
+#include "ADC_Trigger.h"
+#include "ADC_Driver.h"
+#include "Fixed_Point.h"
+#include "Filter.h"
+#include "Lookup_Table.h"
 
-// Global Variables
-volatile uint16_t Adc_Result = 0;										// Stores the latest ADC value
-volatile bool Result_Ready = false;										// Flag to tell Main that data is ready
+// Uncomment to record an event trace. Send 't' over USART3 (9600 baud) to dump it (decode with Tools/trace_decode.py), 'c' to clear.
+//#define TRACE_ENABLE
+
+#ifdef TRACE_ENABLE
+#include "Timestamp.h"
+#include "Debug_USART.h"
+#endif
+#include "Trace.h"
+
+// Uncomment for threshold detection: AC0 tells light from dark, the ADC stays off and the CPU sleeps
+// in standby between crossings. A precise reading is only taken when SW0 (PB2) is pressed.
+// Needs the divider output also connected to PD2 (AC0 positive input AINP0).
+//#define LIGHT_THRESHOLD_MODE
+
+#ifdef LIGHT_THRESHOLD_MODE
+#include <avr/sleep.h>
+#include "AC_Threshold.h"
+#endif
+
+// Event Definitions
+typedef enum {
+	EVENT_ADC_RESULT = 1,												// Result moved out of the deadband, payload = ADC result
+	EVENT_LIGHT_CHANGED,												// Threshold mode: AC0 crossing, payload = 1 for light
+	EVENT_MEASURE_REQUEST,												// Threshold mode: SW0 pressed
+	EVENT_TYPE_COUNT
+} app_event_t;
+
+// Trace event ids (_BEGIN/_END pairs are shown as spans by the decoder)
+enum {
+	TRC_ADC_RESULT = 1,													// arg = ADC result
+	TRC_LCD_BEGIN,														// arg = ADC result shown
+	TRC_LCD_END,
+	TRC_CROSSING														// arg = 1 for light
+};
+
+// Photoresistor on AIN18 (PF2): 16 samples accumulated in hardware, >> 2 = 14-bit result (0 ... 16380).
+// The divider has a high source impedance, so the sampling time is extended by 8 ADC clocks.
+static const adc_channel_t Light_Channel = {
+	ADC_MUXPOS_AIN18_gc, VREF_REFSEL_VDD_gc, ADC_RESSEL_12BIT_gc, ADC_SAMPNUM_ACC16_gc, 8, 2
+};
+
+// Conversion factor as reciprocal computed by the compiler, no division at run time
+static const fixed_scale_t Mv_Scale = FIXED_SCALE(3300, ADC_FULL_SCALE);
+
+// Divider voltage (mV) -> illuminance (lux), instead of the old made-up 2.9V = 100%.
+// Points from the typical GL5528 curve (15k at 10 lux, gamma 0.7) with the LDR to VDD and 10k to GND,
+// replace them with own measurements (lux meter) and run the generator again.
+// Generated by Tools/lut_generate.py --x-max 3300 --shift 5 --interp loglog --from-zero --name Lux 387:1 736:3 1320:10 1947:30 2540:100 2898:300 3114:1000 3211:3000 3261:10000
+// 105 entries, 32 input units per segment
+static const uint16_t Lux_Table[105] LUT_FLASH = {
+	    0,     0,     0,     0,     0,     0,     0,     1,     1,     1,     1,     1,
+	    1,     1,     1,     1,     2,     2,     2,     2,     2,     3,     3,     3,
+	    3,     4,     4,     4,     4,     5,     5,     6,     6,     6,     7,     7,
+	    8,     8,     8,     9,     9,    10,    11,    11,    12,    13,    14,    14,
+	   15,    16,    17,    18,    19,    20,    21,    23,    24,    25,    26,    28,
+	   29,    30,    33,    35,    38,    40,    43,    46,    50,    53,    57,    60,
+	   64,    68,    73,    77,    82,    87,    92,    98,   107,   118,   131,   145,
+	  160,   177,   195,   215,   236,   260,   285,   325,   391,   468,   560,   668,
+	  797,   948,  1287,  1851,  2653,  4986, 10000, 10000, 10000,
+};
+static const lut_t Lux_Lut = LUT_INIT(Lux_Table, 5);
+
+// The shown voltage only follows changes of more than +-20mV, so a value on the edge of a 0.1V or 1% step doesn't flicker
+#define DISPLAY_DEADBAND_MV 20
+static filter_deadband_t Mv_Deadband;
+
+#ifdef LIGHT_THRESHOLD_MODE
+// Light / dark switching point in lux (converted to mV with the lux table), +-50mV programmable hysteresis
+// on top of the comparator's 25mV
+#define LIGHT_THRESHOLD_LUX 50
+#define LIGHT_HYSTERESIS_MV 100
+#define SW0_PIN_bm PIN2_bm												// Curiosity Nano button, PB2 (fully asynchronous, wakes from standby)
+
+static ac_threshold_t Light_Threshold = {
+	AC_MUXPOS_AINP0_gc, VREF_REFSEL_VDD_gc, 3300, 0, LIGHT_HYSTERESIS_MV, AC_HYSMODE_MEDIUM_gc		// threshold_mv set in AC0_init()
+};
+#endif
+
+// Main loop state
+static uint16_t Prev_Voltage_Dv = 0xFFFF;								// Shown values, initialized so that the first update happens
+static uint16_t Prev_Lux = 0xFFFF;
 	
 
 void ADC0_init(void)
@@ -27,80 +114,195 @@ void ADC0_init(void)
 	PORTF.PIN2CTRL &= ~PORT_ISC_gm;										// Clear all ISC (Input/Sense Configuration) bits
 	PORTF.PIN2CTRL |= PORT_ISC_INPUT_DISABLE_gc;						// Disable the digital input buffer
 	
-	// Configure Vref
-	VREF.ADC0REF = VREF_REFSEL_VDD_gc;									// Set ADC0 reference to VDD (3.3V for us)
+#ifdef LIGHT_THRESHOLD_MODE
+	// ADC Clock = 4MHz / 4 = 1MHz, no interrupt: only single readings on request, off in between
+	adc_driver_init(ADC_PRESC_DIV4_gc, false);
+	adc_driver_select(&Light_Channel);
+	adc_driver_enable(false);
+#else
+	// ADC Clock = 4MHz / 4 = 1MHz, Result Ready Interrupt enabled
+	adc_driver_init(ADC_PRESC_DIV4_gc, true);
 	
-	// Configure ADC Control C (Prescaler)
-	ADC0.CTRLC = ADC_PRESC_DIV4_gc;										// ADC Clock = 1MHz
+	// VDD reference (3.3V for us), AIN18 (Pin PF2), 12-bit conversions accumulated 16 times
+	adc_driver_select(&Light_Channel);
 	
-	// Configure MUX (Input Selection)
-	ADC0.MUXPOS = ADC_MUXPOS_AIN18_gc;									// Select AIN18 (which corresponds to Pin PF2)
-	
-    // Enable ADC Interrupt
-    ADC0.INTCTRL = ADC_RESRDY_bm;										// Set the Result Ready Interrupt Enable bit
+	// Window compare instead of Result Ready: only real changes of the light interrupt
+	adc_driver_window_init(&Light_Channel, ADC_DEADBAND);
+#endif
+}
+
+#ifdef LIGHT_THRESHOLD_MODE
+void AC0_init(void)
+{
+	// PD2 = AINP0, analog only
+	PORTD.PIN2CTRL = PORT_ISC_INPUT_DISABLE_gc;
+	Light_Threshold.threshold_mv = lut_inverse(&Lux_Lut, LIGHT_THRESHOLD_LUX);
+	ac_threshold_init(&Light_Threshold);
+
+	// SW0 requests a precise reading
+	PORTB.DIRCLR = SW0_PIN_bm;
+	PORTB.PIN2CTRL = PORT_PULLUPEN_bm | PORT_ISC_FALLING_gc;
+}
 
-	ADC0.CTRLA = ADC_ENABLE_bm | ADC_RESSEL_12BIT_gc;					// Enable ADC and set 12-bit Resolution
+// Interrupt Service Routine: the light crossed the threshold, the ADC is not involved
+ISR(AC0_AC_vect)
+{
+	bool Light = ac_threshold_on_crossing();
+
+	TRACE(TRC_CROSSING, Light);
+	event_post(EVENT_LIGHT_CHANGED, 0, Light);
+}
+
+// Interrupt Service Routine: SW0 pressed (a bounce only causes one more reading)
+ISR(PORTB_PORT_vect)
+{
+	PORTB.INTFLAGS = SW0_PIN_bm;
+	event_post(EVENT_MEASURE_REQUEST, 0, 0);
 }
+#else
 
-// Interrupt Service Routine
-ISR(ADC0_RESRDY_vect)
+// Interrupt Service Routine: the result left the window around the last reported value
+ISR(ADC0_WCOMP_vect)
 {
-    Adc_Result = ADC0.RES;												// Read the RES register. It automatically clears the interrupt flag
+    // Clears the flag and re-centres the window. The value travels with the event,
+    // so it can't be overwritten by the next conversion before main reads it.
+    uint16_t Result = adc_driver_window_update(&Light_Channel);
     
-    Result_Ready = true;												// Set the flag to let main know we have new data
+    TRACE(TRC_ADC_RESULT, Result);
+    event_post(EVENT_ADC_RESULT, 0, Result);
 }
+#endif
 
-int main(void)
+/**
+ * @brief Converts a new result and updates the LCD if it changed.
+ */
+static void on_adc_result(const event_t *event)
 {
     char Text[17];														// Text for LCD text
-	uint16_t Adc_Prev_Result = 0xFFFF;									// Initialize with a value that ensures first update happens
-    uint32_t Voltage_Mv = 0;											// Voltage in millivolts
-    uint16_t Percentage = 0;											// Percentage value
+    uint16_t Voltage_Mv = 0;											// Voltage in millivolts
+    uint16_t Lux = 0;													// Illuminance
+    uint16_t Adc_Result = event->payload;
     
+	// Vref = 3300mV, Resolution = full scale of the 14-bit result
+	Voltage_Mv = fixed_scale(&Mv_Scale, Adc_Result);					// V = (ADC * Vref) / Resolution
+	Voltage_Mv = filter_deadband_update(&Mv_Deadband, Voltage_Mv);
+	
+	Lux = lut_interpolate(&Lux_Lut, Voltage_Mv);						// Non-linear LDR curve from the flash table
+	
+	// Handle the hard job only if the shown text changes (the 14-bit result changes much more often)
+	if (Voltage_Mv / 100 != Prev_Voltage_Dv || Lux != Prev_Lux)
+	{
+        Prev_Voltage_Dv = Voltage_Mv / 100;                             // Update previous values
+        Prev_Lux = Lux;
+        TRACE(TRC_LCD_BEGIN, Adc_Result);
+        
+
+		// Edit the first line text
+		sprintf(Text, "Volt: %u.%u V   ", Voltage_Mv / 1000, (Voltage_Mv % 1000) / 100);
+			
+		lcd_moveCursor(0, 0);											// Move the cursor to line 1
+		lcd_putString(Text);											// Print Voltage: "Volt: x.y V"
+
+		// Edit the second line text
+		sprintf(Text, "Lux: %u      ", Lux);
+			
+		lcd_moveCursor(0, 1);											// Move the cursor to line 2
+		lcd_putString(Text);											// Print Illuminance: "Lux: x"
+		TRACE(TRC_LCD_END, 0);
+	}
+}
+
+#ifdef LIGHT_THRESHOLD_MODE
+/**
+ * @brief Shows light or dark after an AC0 crossing.
+ */
+static void on_light_changed(const event_t *event)
+{
+	lcd_moveCursor(0, 0);
+	lcd_putString(event->payload ? "Light           " : "Dark            ");
+}
+
+/**
+ * @brief Takes one precise reading: the ADC is only enabled for this conversion.
+ */
+static void on_measure_request(const event_t *event)
+{
+	char Text[17];
+
+	adc_driver_enable(true);
+	uint16_t Adc_Result = adc_driver_read(&Light_Channel);				// 16 accumulated samples, ~0.3ms
+	adc_driver_enable(false);
+	TRACE(TRC_ADC_RESULT, Adc_Result);
+
+	uint16_t Voltage_Mv = fixed_scale(&Mv_Scale, Adc_Result);
+	uint16_t Lux = lut_interpolate(&Lux_Lut, Voltage_Mv);
+
+	sprintf(Text, "%u.%u V %5u lx  ", Voltage_Mv / 1000, (Voltage_Mv % 1000) / 100, Lux);
+	lcd_moveCursor(0, 1);
+	lcd_putString(Text);
+}
+#endif
+
+// Handler table, indexed by app_event_t
+static const event_handler_t Event_Handlers[EVENT_TYPE_COUNT] = {
+	[EVENT_ADC_RESULT] = on_adc_result,
+#ifdef LIGHT_THRESHOLD_MODE
+	[EVENT_LIGHT_CHANGED] = on_light_changed,
+	[EVENT_MEASURE_REQUEST] = on_measure_request,
+#endif
+};
+
+int main(void)
+{
+    filter_deadband_init(&Mv_Deadband, DISPLAY_DEADBAND_MV);
     ADC0_init();														// 1. Initialize Peripherals
     lcd_init();															// 2. Initialize LCD
     lcd_clear();
 	
+#ifdef TRACE_ENABLE
+    timestamp_init();
+    debug_usart_init();
+    trace_init();
+#endif
+    
+    event_queue_init();											// No 1ms tick here: event_tick() is not called, event timestamps stay 0
+    
+#ifdef LIGHT_THRESHOLD_MODE
+    AC0_init();
+    event_post(EVENT_LIGHT_CHANGED, 0, ac_threshold_above());			// Show the state before the first crossing
+    event_post(EVENT_MEASURE_REQUEST, 0, 0);
+    set_sleep_mode(SLEEP_MODE_STANDBY);									// AC0 keeps running (RUNSTDBY)
+    sei();																// Enable Global Interrupts
+#else
     sei();																// Enable Global Interrupts
     
-    // Start the FIRST conversion manually
-    ADC0.COMMAND = ADC_STCONV_bm;
+    // From now on TCB2 starts a conversion every 1/SAMPLE_RATE_HZ s, independent of the LCD work in main
+    adc_trigger_init(ADC_TRIGGER_TCB2, SAMPLE_RATE_HZ);
+#endif
     
     while (1) 
     {
-        // Check if the ISR has given us new data
-        if (Result_Ready)
+        // Handle results posted by the ADC ISR
+        event_dispatch(Event_Handlers, EVENT_TYPE_COUNT);
+        
+#ifdef TRACE_ENABLE
+        char Cmd;
+        if (debug_usart_get_char(&Cmd))
+        {
+            trace_command(Cmd);
+        }
+#elif defined(LIGHT_THRESHOLD_MODE)
+        // Sleep until the next crossing or button press. sei() lets the next instruction
+        // run first, so an event posted after the check still wakes the CPU.
+        cli();
+        if (event_pending() == 0)
         {
-            // Reset the flag immediately
-            Result_Ready = false;
-            
-			if (Adc_Result != Adc_Prev_Result)							// Handle the hard job if the result has been changed
-			{
-                Adc_Prev_Result = Adc_Result;                           // Update previous result
-                
-				// Vref = 3300mV, Resolution = 4096 (12-bit)
-				Voltage_Mv = ((uint32_t)Adc_Result * 3300) / 4095;		// V = (ADC * Vref) / Resolution
-				
-				// Since I can't really calibrate, I made up a fictitious max Voltage of 2.9V
-				// ADCmax for this new max voltage = (2.9V * 4095) / 3.3V ~=3600
-				Percentage = ((uint32_t)Adc_Result * 100) / 3600;		// Perc = (ADC * 100) / Calibrated ADCmax
-				
-
-				// Edit the first line text
-				sprintf(Text, "Volt: %lu.%lu V   ", Voltage_Mv / 1000, (Voltage_Mv % 1000) / 100);
-					
-				lcd_moveCursor(0, 0);									// Move the cursor to line 1
-				lcd_putString(Text);									// Print Voltage: "Volt: x.y V"
-
-				// Edit the second line text
-				sprintf(Text, "Perc: %u %%    ", Percentage);
-					
-				lcd_moveCursor(0, 1);									// Move the cursor to line 2
-				lcd_putString(Text);									// Print Percentage: "Perc: x %"
-			}
-            
-            // Start the NEXT conversion
-            ADC0.COMMAND = ADC_STCONV_bm;
+            sleep_enable();
+            sei();
+            sleep_cpu();
+            sleep_disable();
         }
+        sei();
+#endif
     }
 }
\ No newline at end of file
@@ -0,0 +1,178 @@
+/*
+ * ADC_Driver.c
+ */
+
+#include "ADC_Driver.h"
+
+// VARIABLES //
+static uint16_t Window_Delta = 0;				// Half width of the window in RES units (before the shift)
+
+// PRIVATE FUNCTIONS //
+
+/*
+	@return Highest code of one conversion
+*/
+static uint16_t max_code(const adc_channel_t *channel)
+{
+	return (channel->ressel == ADC_RESSEL_10BIT_gc) ? 1023 : 4095;
+}
+
+// PUBLIC FUNCTIONS //
+
+/*
+	Enables ADC0. The channel settings are applied later by adc_driver_select().
+
+	@param prescaler ADC_PRESC_xxx_gc, the ADC clock must stay at or below 2MHz for 12-bit conversions
+	@param result_interrupt Enable the RESRDY interrupt
+*/
+void adc_driver_init(uint8_t prescaler, bool result_interrupt)
+{
+	ADC0.CTRLC = prescaler;
+	ADC0.CTRLD = ADC_INITDLY_DLY32_gc;			// Reference settling time after enabling (32 ADC clocks)
+	ADC0.INTCTRL = result_interrupt ? ADC_RESRDY_bm : 0;
+	ADC0.CTRLA = ADC_ENABLE_bm | ADC_RESSEL_12BIT_gc;
+}
+
+/*
+	@return false if the result of this channel would need more than 16 bits
+	        (shift below the hardware shift) or SAMPNUM is above ACC128
+*/
+bool adc_driver_valid(const adc_channel_t *channel)
+{
+	return (channel->sampnum & ADC_SAMPNUM_gm) <= ADC_SAMPNUM_ACC128_gc
+		&& channel->shift >= adc_driver_hw_shift(channel);
+}
+
+/*
+	Applies the settings of one channel. Call while no conversion is running
+	(e.g. from the RESRDY ISR before the next start).
+
+	@return false if the channel is not valid (nothing is changed)
+*/
+bool adc_driver_select(const adc_channel_t *channel)
+{
+	if (!adc_driver_valid(channel))
+		return false;
+
+	VREF.ADC0REF = channel->refsel;
+	ADC0.MUXPOS = channel->muxpos;
+	ADC0.SAMPCTRL = channel->sampctrl;
+	ADC0.CTRLB = channel->sampnum;
+	ADC0.CTRLA = (ADC0.CTRLA & ~ADC_RESSEL_gm) | channel->ressel;
+
+	return true;
+}
+
+/*
+	Starts one conversion (all accumulated samples) by software.
+	Not needed when conversions are started by an event (ADC_Trigger).
+*/
+void adc_driver_start(void)
+{
+	ADC0.COMMAND = ADC_STCONV_bm;
+}
+
+/*
+	Switches ADC0 on or off, the settings are kept. A disabled ADC draws no current,
+	after enabling the first conversion waits for the reference (INITDLY).
+*/
+void adc_driver_enable(bool enable)
+{
+	if (enable)
+	{
+		ADC0.CTRLA |= ADC_ENABLE_bm;
+	}
+	else
+	{
+		ADC0.CTRLA &= ~ADC_ENABLE_bm;
+	}
+}
+
+/*
+	One conversion by software, waits for the result (all accumulated samples).
+	Only for on-demand readings with the RESRDY interrupt disabled and no trigger running.
+
+	@return The result (same units as adc_driver_result()), 0 if the channel is not valid
+*/
+uint16_t adc_driver_read(const adc_channel_t *channel)
+{
+	if (!adc_driver_select(channel))
+		return 0;
+
+	ADC0.INTFLAGS = ADC_RESRDY_bm;
+	adc_driver_start();
+	while (!(ADC0.INTFLAGS & ADC_RESRDY_bm))
+	{
+		;
+	}
+
+	return adc_driver_result(channel, ADC0.RES);		// Reading RES clears the flag
+}
+
+/*
+	@return Number of samples that are added up for one result
+*/
+uint8_t adc_driver_samples(const adc_channel_t *channel)
+{
+	return (uint8_t)(1 << ((channel->sampnum & ADC_SAMPNUM_gm) >> ADC_SAMPNUM_gp));
+}
+
+/*
+	@return Highest value adc_driver_result() can return for this channel
+*/
+uint16_t adc_driver_full_scale(const adc_channel_t *channel)
+{
+	return (uint16_t)(((uint32_t)max_code(channel) * adc_driver_samples(channel)) >> channel->shift);
+}
+
+/*
+	@return Resolution of adc_driver_result() in bits (e.g. 14 for 16 x 12-bit >> 2)
+*/
+uint8_t adc_driver_bits(const adc_channel_t *channel)
+{
+	uint8_t bits = 0;
+
+	for (uint16_t scale = adc_driver_full_scale(channel); scale != 0; scale >>= 1)
+	{
+		bits++;
+	}
+
+	return bits;
+}
+
+/*
+	Switches to window mode: only results outside the window around the last
+	reported value raise an interrupt (ADC0_WCOMP_vect instead of ADC0_RESRDY_vect).
+	The first result is always reported.
+
+	@param delta Deadband in adc_driver_result() units, changes up to +-delta are ignored
+*/
+void adc_driver_window_init(const adc_channel_t *channel, uint16_t delta)
+{
+	uint32_t raw = (uint32_t)delta << (channel->shift - adc_driver_hw_shift(channel));	// The comparator works on RES, before the software shift
+
+	Window_Delta = (raw > UINT16_MAX) ? UINT16_MAX : (uint16_t)raw;
+
+	ADC0.WINLT = UINT16_MAX;					// Every possible result is below: the first one is reported
+	ADC0.WINHT = UINT16_MAX;
+	ADC0.CTRLE = ADC_WINCM_OUTSIDE_gc;
+	ADC0.INTFLAGS = ADC_WCMP_bm;
+	ADC0.INTCTRL = ADC_WCMP_bm;					// No RESRDY interrupt
+}
+
+/*
+	Call from ADC0_WCOMP_vect. Re-centres the window around the new result.
+
+	@return The new result (same units as adc_driver_result())
+*/
+uint16_t adc_driver_window_update(const adc_channel_t *channel)
+{
+	uint16_t res = ADC0.RES;
+
+	ADC0.INTFLAGS = ADC_WCMP_bm;
+
+	ADC0.WINLT = (res > Window_Delta) ? res - Window_Delta : 0;
+	ADC0.WINHT = (res < UINT16_MAX - Window_Delta) ? res + Window_Delta : UINT16_MAX;
+
+	return adc_driver_result(channel, res);
+}
@@ -0,0 +1,84 @@
+/*
+ * Fixed_Point.h
+ *
+ * Integer scaling without division at run time.
+ *
+ * fixed_scale() computes floor(x * num / den) with the exact result of the
+ * 32-bit division formula, but the division is replaced by a multiplication
+ * with the reciprocal mult = floor(num * 2^16 / den) and a shift by 16
+ * (taking the high word, free on the AVR). The estimate is at most 1 too
+ * small, one multiply and compare corrects it. Cost on the AVR: roughly 3
+ * multiplications instead of a __udivmodsi4 call of several hundred cycles.
+ *
+ * Fixed factors:   static const fixed_scale_t Mv_Scale = FIXED_SCALE(3300, 16380);
+ *                  Voltage_Mv = fixed_scale(&Mv_Scale, Adc_Result);
+ * Runtime divisor (e.g. calibration data): fixed_scale_init() once, it does the only division.
+ *
+ * Limit: the result for the largest input must fit into 16 bits
+ * (x_max * num / den <= 65535), see FIXED_SCALE_FITS().
+ *
+ * Q-format: FIXED_Q() converts a constant to a signed 16-bit value with
+ * frac fractional bits at compile time, fixed_q_mul() multiplies two of them.
+ */
+
+#ifndef FIXED_POINT_H_
+#define FIXED_POINT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+	uint32_t mult;						// floor(num * 2^16 / den)
+	uint16_t num;						// Kept for the correction step
+	uint16_t den;
+} fixed_scale_t;
+
+// Constant initializer, the reciprocal is computed by the compiler
+#define FIXED_SCALE(num, den) { (((uint32_t)(num) << 16) / (den)), (num), (den) }
+
+// True if every x <= x_max gives a 16-bit result (usable in _Static_assert)
+#define FIXED_SCALE_FITS(num, den, x_max) ((uint32_t)(x_max) * (num) / (den) <= 0xFFFFUL)
+
+// Constant in Q-format with frac fractional bits, rounded to nearest (e.g. FIXED_Q(0.75, 8) = 192)
+#define FIXED_Q(value, frac) ((int16_t)((value) * (1L << (frac)) + (((value) < 0) ? -0.5 : 0.5)))
+
+bool fixed_scale_init(fixed_scale_t *scale, uint16_t num, uint16_t den, uint16_t x_max);
+
+/*
+	floor(x * num / den), same result as ((uint32_t)x * num) / den.
+	Inline, so with a const scale the compiler folds num, den and mult into the code.
+
+	@param x Input, at most the x_max the scale was made for
+	@return Scaled value
+*/
+static inline uint16_t fixed_scale(const fixed_scale_t *scale, uint16_t x)
+{
+	uint16_t q = (uint16_t)(((uint32_t)x * scale->mult) >> 16);	// floor(x * num / den) or 1 less
+	
+	if (((uint32_t)q + 1) * scale->den <= (uint32_t)x * scale->num)
+	{
+		q++;
+	}
+	return q;
+}
+
+/*
+	Product of two Q-format values with the same number of fractional bits, rounded.
+
+	@param frac Fractional bits (1..15)
+	@return a * b in the same Q-format
+*/
+static inline int16_t fixed_q_mul(int16_t a, int16_t b, uint8_t frac)
+{
+	return (int16_t)(((int32_t)a * b + (1L << (frac - 1))) >> frac);
+}
+
+/*
+	@return Q-format value rounded to the nearest integer
+*/
+static inline int16_t fixed_q_round(int16_t a, uint8_t frac)
+{
+	return (int16_t)(((int32_t)a + (1L << (frac - 1))) >> frac);
+}
+
+#endif /* FIXED_POINT_H_ */
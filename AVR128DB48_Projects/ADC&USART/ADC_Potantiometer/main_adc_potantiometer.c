@@ -8,15 +8,30 @@
  */ 
 
 #define F_CPU 4000000UL													// Set CPU Frequency to 4MHz
+#define SAMPLE_RATE_HZ 50												// Conversions per second, started by TCB2 via the Event System
+#define ADC_DEADBAND 32													// Changes up to +-32 LSB (14-bit, ~6mV) do not interrupt
+#define ADC_FULL_SCALE 16380U											// adc_driver_full_scale(&Pot_Channel)
 
 #include <avr/io.h>
 #include <avr/interrupt.h>												// Required for ISR usage
 #include <stdio.h>														// Used for handling the strings
 #include <stdbool.h>													// Used for bool variables
 #include "I2C_LCD.h"
+#include "ADC_Trigger.h"
+#include "ADC_Driver.h"
+#include "Fixed_Point.h"
+
+// Potentiometer on AIN19 (PF3): 16 samples accumulated in hardware, >> 2 = 14-bit result (0 ... 16380)
+static const adc_channel_t Pot_Channel = {
+	ADC_MUXPOS_AIN19_gc, VREF_REFSEL_VDD_gc, ADC_RESSEL_12BIT_gc, ADC_SAMPNUM_ACC16_gc, 0, 2
+};
+
+// Vref = 3300mV and 100%, Resolution = full scale of the 14-bit result (reciprocals computed by the compiler)
+static const fixed_scale_t Mv_Scale = FIXED_SCALE(3300, ADC_FULL_SCALE);
+static const fixed_scale_t Percent_Scale = FIXED_SCALE(100, ADC_FULL_SCALE);
 
 // Global Variables
-volatile uint16_t Adc_Result = 0;										// Stores the latest ADC value
+volatile uint16_t Adc_Result = 0;										// Stores the latest ADC value (decimated)
 volatile bool Result_Ready = false;										// Flag to tell Main that data is ready
 
 void ADC0_init(void)
@@ -26,25 +41,20 @@ void ADC0_init(void)
 	PORTF.PIN3CTRL &= ~PORT_ISC_gm;										// Clear all ISC (Input/Sense Configuration) bits
 	PORTF.PIN3CTRL |= PORT_ISC_INPUT_DISABLE_gc;						// Disable the digital input buffer
 	
-	// Configure VREF
-	VREF.ADC0REF = VREF_REFSEL_VDD_gc;									// Set ADC0 reference to VDD (3.3V for us)
-	
-	// Configure ADC Control C (Prescaler)
-	ADC0.CTRLC = ADC_PRESC_DIV4_gc;										// ADC Clock = 1MHz
+	// ADC Clock = 4MHz / 4 = 1MHz, Result Ready Interrupt enabled
+	adc_driver_init(ADC_PRESC_DIV4_gc, true);
 	
-	// Configure MUX (Input Selection)
-	ADC0.MUXPOS = ADC_MUXPOS_AIN19_gc;									// Select AIN19 (which corresponds to Pin PF3)
+	// VDD reference (3.3V for us), AIN19 (Pin PF3), 12-bit conversions accumulated 16 times
+	adc_driver_select(&Pot_Channel);
 	
-    // Enable ADC Interrupt
-    ADC0.INTCTRL = ADC_RESRDY_bm;										// Set the Result Ready Interrupt Enable bit
-
-	ADC0.CTRLA = ADC_ENABLE_bm | ADC_RESSEL_12BIT_gc;					// Enable ADC and set 12-bit Resolution
+	// Window compare instead of Result Ready: only real movements of the pot interrupt
+	adc_driver_window_init(&Pot_Channel, ADC_DEADBAND);
 }
 
-// Interrupt Service Routine
-ISR(ADC0_RESRDY_vect)													// It does not make any sense since we don't do anything if the result is not ready yet
-{																		// but it is forbidden to use blocking delays
-    Adc_Result = ADC0.RES;												// Read the RES register. It automatically clears the interrupt flag
+// Interrupt Service Routine: the result left the window around the last reported value
+ISR(ADC0_WCOMP_vect)													// Noise inside the deadband never gets here,
+{																		// so main is only woken up for real changes
+    Adc_Result = adc_driver_window_update(&Pot_Channel);				// Read RES (sum of 16 samples), clear the flag and re-centre the window
     
     Result_Ready = true;												// Set the flag to let main know we have new data
 }
@@ -52,8 +62,9 @@ ISR(ADC0_RESRDY_vect)													// It does not make any sense since we don't d
 int main(void)
 {
     char Text[17];														// Text for LCD text
-	uint16_t Adc_Prev_Result = 0xFFFF;									// Initialize with a value that ensures first update happens
-    uint32_t Voltage_Mv = 0;											// Voltage in millivolts
+	uint16_t Prev_Voltage_Dv = 0xFFFF;									// Shown values, initialized so that the first update happens
+	uint16_t Prev_Percentage = 0xFFFF;
+    uint16_t Voltage_Mv = 0;											// Voltage in millivolts
     uint16_t Percentage = 0;											// Percentage value
     
     ADC0_init();														// 1. Initialize Peripherals
@@ -62,8 +73,8 @@ int main(void)
     
     sei();																// Enable Global Interrupts
     
-    // Start the FIRST conversion manually
-    ADC0.COMMAND = ADC_STCONV_bm;
+    // From now on TCB2 starts a conversion every 1/SAMPLE_RATE_HZ s, independent of the LCD work in main
+    adc_trigger_init(ADC_TRIGGER_TCB2, SAMPLE_RATE_HZ);
     
     while (1) 
     {
@@ -73,18 +84,20 @@ int main(void)
             // Reset the flag immediately
             Result_Ready = false;
             
-			if (Adc_Result != Adc_Prev_Result)							// Handle the hard job if the result has been changed
+			// Same results as the 32-bit divisions, but with multiplications only
+			Voltage_Mv = fixed_scale(&Mv_Scale, Adc_Result);			// V = (ADC * Vref) / Resolution
+			
+			Percentage = fixed_scale(&Percent_Scale, Adc_Result);		// Perc = (ADC * 100) / Resolution
+			
+			// Handle the hard job only if the shown text changes (the 14-bit result changes much more often)
+			if (Voltage_Mv / 100 != Prev_Voltage_Dv || Percentage != Prev_Percentage)
 			{
-                Adc_Prev_Result = Adc_Result;                           // Update previous result
-                
-				// Vref = 3300mV, Resolution = 4096 (12-bit)
-				Voltage_Mv = ((uint32_t)Adc_Result * 3300) / 4095;		// V = (ADC * Vref) / Resolution
-				
-				Percentage = ((uint32_t)Adc_Result * 100) / 4095;		// Perc = (ADC * 100) / Resolution
+				Prev_Voltage_Dv = Voltage_Mv / 100;						// Update previous values
+				Prev_Percentage = Percentage;
 				
 
 				// Edit the first line text
-				sprintf(Text, "Volt: %lu.%lu V   ", Voltage_Mv / 1000, (Voltage_Mv % 1000) / 100);
+				sprintf(Text, "Volt: %u.%u V   ", Voltage_Mv / 1000, (Voltage_Mv % 1000) / 100);
 					
 				lcd_moveCursor(0, 0);									// Move the cursor to line 1
 				lcd_putString(Text);									// Print Voltage: "Volt: x.y V"
@@ -95,9 +108,6 @@ int main(void)
 				lcd_moveCursor(0, 1);									// Move the cursor to line 2
 				lcd_putString(Text);									// Print Percentage: "Perc: x %"
 			}
-            
-            // Start the NEXT conversion
-            ADC0.COMMAND = ADC_STCONV_bm;
         }
     }
 }
\ No newline at end of file
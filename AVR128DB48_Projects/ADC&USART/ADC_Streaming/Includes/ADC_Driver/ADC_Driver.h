@@ -0,0 +1,87 @@
+/*
+ * ADC_Driver.h
+ *
+ * ADC0 set-up per channel, with hardware accumulation (oversampling).
+ *
+ * With SAMPNUM > 1 one conversion start makes the ADC take 2 ... 128 samples
+ * back to back and add them up in hardware. RESRDY fires once with the sum,
+ * so the CPU pays for one interrupt no matter how many samples were taken.
+ * Shifting the sum right (decimation) gives extra resolution: 4^n samples and
+ * a shift of n give n extra bits, e.g. 16 x 12-bit >> 2 = 14-bit.
+ *
+ * RES is a 16-bit register. A sum that can be wider (12-bit with ACC32 ...
+ * ACC128, 10-bit with ACC128) does not overflow: the ADC drops its LSBs so the
+ * 16 MSBs fit, e.g. 128 x 12-bit (19 bits) arrives shifted right by 3. This
+ * hardware shift is part of the channel's shift, so shift always counts from
+ * the full sum: 128 x 12-bit with shift 3 gives 16 bits, 64 x 12-bit with
+ * shift 3 gives 15 bits (2 in hardware, 1 in adc_driver_result()).
+ * adc_driver_select() rejects a shift smaller than the hardware shift (more
+ * than 16 result bits).
+ *
+ * Usage:
+ *  static const adc_channel_t Pot = { ADC_MUXPOS_AIN19_gc, VREF_REFSEL_VDD_gc, ADC_RESSEL_12BIT_gc, ADC_SAMPNUM_ACC16_gc, 0, 2 };
+ *  adc_driver_init(ADC_PRESC_DIV4_gc, true);
+ *  adc_driver_select(&Pot);
+ *  RESRDY ISR: uint16_t value = adc_driver_result(&Pot, ADC0.RES);   // 0 ... adc_driver_full_scale(&Pot)
+ *
+ * On demand (no RESRDY interrupt): adc_driver_enable(true); value = adc_driver_read(&Pot);
+ * adc_driver_enable(false); keeps the ADC and its reference off between readings.
+ *
+ * Window mode (deadband): adc_driver_window_init(&Pot, delta) replaces the RESRDY
+ * interrupt by the window compare interrupt (WINCM OUTSIDE). The window is
+ * re-centred around every reported value, so the CPU is only interrupted when
+ * the result moved by more than delta (in adc_driver_result() units):
+ *  ADC0_WCOMP_vect: uint16_t value = adc_driver_window_update(&Pot);
+ */
+
+#ifndef ADC_DRIVER_H_
+#define ADC_DRIVER_H_
+
+#include <avr/io.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+	uint8_t muxpos;						// ADC_MUXPOS_xxx_gc
+	uint8_t refsel;						// VREF_REFSEL_xxx_gc
+	uint8_t ressel;						// ADC_RESSEL_12BIT_gc or ADC_RESSEL_10BIT_gc
+	uint8_t sampnum;					// ADC_SAMPNUM_xxx_gc, number of accumulated samples
+	uint8_t sampctrl;					// Extra sampling time in ADC clock cycles (0 ... 255), for high impedance sources
+	uint8_t shift;						// Right shift of the full accumulated sum (includes adc_driver_hw_shift())
+} adc_channel_t;
+
+void adc_driver_init(uint8_t prescaler, bool result_interrupt);
+bool adc_driver_valid(const adc_channel_t *channel);
+bool adc_driver_select(const adc_channel_t *channel);
+void adc_driver_start(void);
+void adc_driver_enable(bool enable);
+uint16_t adc_driver_read(const adc_channel_t *channel);
+
+uint8_t adc_driver_samples(const adc_channel_t *channel);
+uint16_t adc_driver_full_scale(const adc_channel_t *channel);
+uint8_t adc_driver_bits(const adc_channel_t *channel);
+
+void adc_driver_window_init(const adc_channel_t *channel, uint16_t delta);
+uint16_t adc_driver_window_update(const adc_channel_t *channel);
+
+/*
+	@return Bits the ADC itself drops from a sum wider than 16 bits (0 ... 3)
+*/
+static inline uint8_t adc_driver_hw_shift(const adc_channel_t *channel)
+{
+	uint8_t width = ((channel->ressel == ADC_RESSEL_10BIT_gc) ? 10 : 12)
+		+ ((channel->sampnum & ADC_SAMPNUM_gm) >> ADC_SAMPNUM_gp);
+
+	return (width > 16) ? (uint8_t)(width - 16) : 0;
+}
+
+/*
+	Decimates a raw RES value of this channel. Inline for use in the RESRDY ISR
+	(constant channels fold to a single shift).
+*/
+static inline uint16_t adc_driver_result(const adc_channel_t *channel, uint16_t res)
+{
+	return res >> (channel->shift - adc_driver_hw_shift(channel));
+}
+
+#endif /* ADC_DRIVER_H_ */
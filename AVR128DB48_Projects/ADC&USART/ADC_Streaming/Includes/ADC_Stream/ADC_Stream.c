@@ -0,0 +1,258 @@
+/*
+ * ADC_Stream.c
+ *
+ * Two frame buffers change hands through their state byte: the ISR only
+ * fills a FILLING buffer and hands it over by setting READY, main only sends
+ * a READY buffer and gives it back by setting FREE. A single byte is written
+ * atomically, so no interrupt lock is needed.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "ADC_Stream.h"
+
+typedef enum {
+	BUFFER_FREE,
+	BUFFER_FILLING,
+	BUFFER_READY						// Full, main sends it
+} buffer_state_t;
+
+typedef struct {
+	uint8_t data[ADC_STREAM_FRAME_SIZE];
+	volatile uint8_t state;
+} stream_buffer_t;
+
+// VARIABLES //
+static const adc_channel_t *Stream_Channels = 0;
+static uint8_t Stream_Count = 0;
+static uint8_t Stream_Current = 0;				// Channel of the conversion that is running
+static volatile bool Stream_Enabled = false;
+
+static stream_buffer_t Buffers[2];
+static uint8_t Fill_Index = 0;					// Buffer the ISR writes to
+static uint8_t Fill_Samples = 0;				// Samples in that buffer
+static uint8_t *Fill_Ptr = 0;					// Next payload byte
+static uint16_t Sequence = 0;
+static volatile uint16_t Frames = 0;			// Frames completed (sent or dropped)
+static volatile uint16_t Dropped = 0;
+
+static stream_buffer_t *Tx_Buffer = 0;			// Frame main is sending, 0 if none
+static uint8_t Tx_Pos = 0;
+static uint8_t Tx_Sum = 0;
+
+// PRIVATE FUNCTIONS //
+
+/*
+	Writes the header of the buffer that is filled next.
+*/
+static void start_frame(void)
+{
+	uint8_t *data = Buffers[Fill_Index].data;
+
+	data[0] = ADC_STREAM_SYNC0;
+	data[1] = ADC_STREAM_SYNC1;
+	data[2] = (uint8_t)Sequence;
+	data[3] = (uint8_t)(Sequence >> 8);
+	data[4] = (uint8_t)((Stream_Current << 4) | Stream_Count);
+	data[5] = ADC_STREAM_FRAME_SAMPLES;
+
+	Buffers[Fill_Index].state = BUFFER_FILLING;
+	Fill_Samples = 0;
+	Fill_Ptr = &data[ADC_STREAM_HEADER_SIZE];
+}
+
+/*
+	Hands a full frame to main, or drops it if main is still sending the other one.
+*/
+static void finish_frame(void)
+{
+	uint8_t other = Fill_Index ^ 1;
+
+	Sequence++;
+	Frames++;
+
+	if (Buffers[other].state == BUFFER_FREE)
+	{
+		Buffers[Fill_Index].state = BUFFER_READY;
+		Fill_Index = other;
+	}
+	else
+	{
+		Dropped++;								// Refill the same buffer, its sequence number is lost
+	}
+
+	start_frame();
+}
+
+// PUBLIC FUNCTIONS //
+
+/*
+	Checks the channel list and selects the first channel. Streaming starts disabled.
+	Call after adc_driver_init() and before the conversions are triggered.
+
+	All channels must use the same reference, resolution and accumulation (only
+	the input and sampling time change between conversions, no settling needed),
+	and adc_driver_result() must fit into 12 bits.
+
+	@return false if the list is empty, too long or a channel does not fit
+*/
+bool adc_stream_init(const adc_channel_t *channels, uint8_t count)
+{
+	if (count == 0 || count > ADC_STREAM_MAX_CHANNELS)
+		return false;
+
+	for (uint8_t i = 0; i < count; i++)
+	{
+		if (!adc_driver_valid(&channels[i]) || adc_driver_full_scale(&channels[i]) > 4095)
+			return false;
+
+		if (channels[i].refsel != channels[0].refsel || channels[i].ressel != channels[0].ressel ||
+			channels[i].sampnum != channels[0].sampnum)
+			return false;
+	}
+
+	Stream_Enabled = false;
+	Stream_Channels = channels;
+	Stream_Count = count;
+	Stream_Current = 0;
+	adc_driver_select(&channels[0]);
+
+	Sequence = 0;
+	Frames = 0;
+	Dropped = 0;
+	Tx_Buffer = 0;
+	Buffers[0].state = BUFFER_FREE;
+	Buffers[1].state = BUFFER_FREE;
+	Fill_Index = 0;
+	start_frame();
+
+	return true;
+}
+
+/*
+	Call from ADC0_RESRDY_vect. Packs the result and selects the next channel.
+*/
+void adc_stream_on_result(void)
+{
+	const adc_channel_t *channel = &Stream_Channels[Stream_Current];
+	uint16_t value = adc_driver_result(channel, ADC0.RES);		// Reading RES clears RESRDY
+
+	if (++Stream_Current >= Stream_Count)
+	{
+		Stream_Current = 0;
+	}
+	ADC0.MUXPOS = Stream_Channels[Stream_Current].muxpos;			// Ready before the next trigger
+	ADC0.SAMPCTRL = Stream_Channels[Stream_Current].sampctrl;
+
+	if (!Stream_Enabled)
+		return;
+
+	// Two samples in three bytes
+	if ((Fill_Samples & 1) == 0)
+	{
+		Fill_Ptr[0] = (uint8_t)value;
+		Fill_Ptr[1] = (uint8_t)(value >> 8);
+	}
+	else
+	{
+		Fill_Ptr[1] |= (uint8_t)(value << 4);
+		Fill_Ptr[2] = (uint8_t)(value >> 4);
+		Fill_Ptr += 3;
+	}
+
+	if (++Fill_Samples >= ADC_STREAM_FRAME_SAMPLES)
+	{
+		finish_frame();
+	}
+}
+
+/*
+	Call from the main loop as often as possible. Writes as many bytes of a
+	ready frame as the USART3 transmit buffer accepts, then returns.
+	The checksum is added up here, not in the ISR.
+*/
+void adc_stream_service(void)
+{
+	if (Tx_Buffer == 0)
+	{
+		for (uint8_t i = 0; i < 2; i++)
+		{
+			if (Buffers[i].state == BUFFER_READY)
+			{
+				Tx_Buffer = &Buffers[i];
+				Tx_Pos = 0;
+				Tx_Sum = 0;
+				break;
+			}
+		}
+		if (Tx_Buffer == 0)
+			return;
+	}
+
+	while (USART3.STATUS & USART_DREIF_bm)
+	{
+		uint8_t byte;
+
+		if (Tx_Pos < ADC_STREAM_FRAME_SIZE - 1)
+		{
+			byte = Tx_Buffer->data[Tx_Pos];
+			if (Tx_Pos >= 2)
+			{
+				Tx_Sum += byte;
+			}
+		}
+		else
+		{
+			byte = Tx_Sum;
+		}
+
+		USART3.TXDATAL = byte;
+
+		if (++Tx_Pos >= ADC_STREAM_FRAME_SIZE)
+		{
+			Tx_Buffer->state = BUFFER_FREE;
+			Tx_Buffer = 0;
+			return;
+		}
+	}
+}
+
+/*
+	Starts or stops putting samples into frames. The conversions keep running,
+	a stopped stream restarts with an empty frame.
+*/
+void adc_stream_enable(bool enable)
+{
+	if (enable && !Stream_Enabled)
+	{
+		uint8_t sreg = SREG;
+		cli();
+		start_frame();
+		SREG = sreg;
+	}
+	Stream_Enabled = enable;
+}
+
+/*
+	@return Frames completed since init (sent + dropped)
+*/
+uint16_t adc_stream_frames(void)
+{
+	uint8_t sreg = SREG;
+	cli();
+	uint16_t frames = Frames;
+	SREG = sreg;
+	return frames;
+}
+
+/*
+	@return Frames dropped because main had not finished sending the previous one
+*/
+uint16_t adc_stream_dropped(void)
+{
+	uint8_t sreg = SREG;
+	cli();
+	uint16_t dropped = Dropped;
+	SREG = sreg;
+	return dropped;
+}
@@ -0,0 +1,74 @@
+/*
+ * ADC_Stream.h
+ *
+ * Continuous ADC sampling sent to a PC as binary frames over USART3.
+ *
+ * The conversions are started by ADC_Trigger at a fixed rate. The RESRDY ISR
+ * packs every result (12 bits) into one of two frame buffers and switches to
+ * the next channel of the list. When a frame is full the ISR continues in the
+ * other buffer while main sends the full one (adc_stream_service(), polled,
+ * no interrupt per byte). If main is still sending when the next frame is
+ * full, that frame is dropped and counted, its sequence number is skipped
+ * so the PC sees the gap.
+ *
+ * Frame (little endian):
+ *  0   0xA5 0x5A                    sync
+ *  2   sequence (uint16)            +1 per frame, including dropped ones
+ *  4   first channel << 4 | number of channels
+ *  5   number of samples n
+ *  6   n * 12-bit samples packed into n * 3 / 2 bytes, channels interleaved:
+ *      sample 2k:   byte 3k = bits 0-7, byte 3k+1 bits 0-3 = bits 8-11
+ *      sample 2k+1: byte 3k+1 bits 4-7 = bits 0-3, byte 3k+2 = bits 4-11
+ *  6 + n * 3 / 2   checksum         sum of bytes 2 ... end-1 (mod 256)
+ *
+ * Bandwidth at 4MHz: USART3 with CLK2X runs at up to 500000 baud (50kB/s),
+ * 1.5 bytes per sample plus 7 bytes per frame allow about 30k samples/s.
+ * The RESRDY ISR is short (no timestamps, no per-byte work in main's place),
+ * rates up to 20k samples/s (all channels together) leave time for main.
+ *
+ * Usage:
+ *  adc_driver_init(ADC_PRESC_DIV4_gc, true);
+ *  adc_stream_init(Channels, 2);
+ *  adc_trigger_init(ADC_TRIGGER_TCB2, 10000);
+ *  ISR(ADC0_RESRDY_vect) { adc_stream_on_result(); }
+ *  main loop: adc_stream_service();
+ *
+ * Resources: USART3 TX (set up by the caller), ADC0 RESRDY interrupt.
+ */
+
+#ifndef ADC_STREAM_H_
+#define ADC_STREAM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../ADC_Driver/ADC_Driver.h"
+
+#ifndef ADC_STREAM_MAX_CHANNELS
+#define ADC_STREAM_MAX_CHANNELS 4
+#endif
+
+// Samples per frame, even (two samples share 3 bytes) and at most 164
+#ifndef ADC_STREAM_FRAME_SAMPLES
+#define ADC_STREAM_FRAME_SAMPLES 64
+#endif
+
+#define ADC_STREAM_SYNC0 0xA5
+#define ADC_STREAM_SYNC1 0x5A
+#define ADC_STREAM_HEADER_SIZE 6
+#define ADC_STREAM_PAYLOAD_SIZE (ADC_STREAM_FRAME_SAMPLES / 2 * 3)
+#define ADC_STREAM_FRAME_SIZE (ADC_STREAM_HEADER_SIZE + ADC_STREAM_PAYLOAD_SIZE + 1)
+
+// The send position is 8-bit: 164 samples give 253 bytes, 166 would need 256
+#if (ADC_STREAM_FRAME_SAMPLES & 1) != 0 || ADC_STREAM_FRAME_SIZE > 255
+#error "ADC_STREAM_FRAME_SAMPLES must be even and <= 164 (frame of at most 255 bytes)"
+#endif
+
+bool adc_stream_init(const adc_channel_t *channels, uint8_t count);
+void adc_stream_on_result(void);
+void adc_stream_service(void);
+
+void adc_stream_enable(bool enable);
+uint16_t adc_stream_frames(void);
+uint16_t adc_stream_dropped(void);
+
+#endif /* ADC_STREAM_H_ */
@@ -0,0 +1,92 @@
+/*
+ * main_adc_streaming.c
+ *
+ * ADC data acquisition: potentiometer and photoresistor sampled at a fixed
+ * rate and streamed to a PC as binary frames (ADC_Stream module).
+ *
+ * TCB2 starts every conversion through the Event System, the RESRDY ISR
+ * packs the 12-bit results into double buffered frames and main sends them
+ * over USART3 at 500000 baud. Send 's' to start and 'x' to stop the stream.
+ * Capture on the PC with Tools/adc_stream_capture.py.
+ */
+
+#define F_CPU 4000000UL													// Set CPU Frequency to 4MHz
+#define STREAM_BAUD 500000UL											// Highest baud rate at 4MHz (CLK2X, BAUD register = 64)
+#define STREAM_RATE_HZ 10000											// Conversions per second for all channels together (1k ... 20k)
+
+#include <avr/io.h>
+#include <avr/interrupt.h>												// Required for ISR usage
+#include <stdbool.h>													// Used for bool variables
+#include "ADC_Driver.h"
+#include "ADC_Trigger.h"
+#include "ADC_Stream.h"
+#include "USART_Baud.h"
+
+USART_BAUD_CHECK(STREAM_BAUD, USART_DOUBLE_SPEED);
+
+// Streamed channels, sampled in turns: single 12-bit conversions, VDD reference for both
+static const adc_channel_t Channels[] = {
+	{ ADC_MUXPOS_AIN19_gc, VREF_REFSEL_VDD_gc, ADC_RESSEL_12BIT_gc, ADC_SAMPNUM_ACC1_gc, 0, 0 },	// PF3, potentiometer
+	{ ADC_MUXPOS_AIN18_gc, VREF_REFSEL_VDD_gc, ADC_RESSEL_12BIT_gc, ADC_SAMPNUM_ACC1_gc, 8, 0 },	// PF2, photoresistor (high impedance)
+};
+
+#define CHANNEL_COUNT (sizeof(Channels) / sizeof(Channels[0]))
+
+void ADC0_init(void)
+{
+	// Disable the digital input buffers of PF2 (AIN18) and PF3 (AIN19)
+	PORTF.PIN2CTRL = PORT_ISC_INPUT_DISABLE_gc;
+	PORTF.PIN3CTRL = PORT_ISC_INPUT_DISABLE_gc;
+
+	// ADC Clock = 4MHz / 4 = 1MHz (one 12-bit conversion ~15us), Result Ready Interrupt enabled
+	adc_driver_init(ADC_PRESC_DIV4_gc, true);
+	adc_stream_init(Channels, CHANNEL_COUNT);
+}
+
+void USART3_init(void)
+{
+	PORTMUX.USARTROUTEA &= ~PORTMUX_USART3_gm;							// Default pins PB0 = TX, PB1 = RX
+	PORTB.DIRSET = PIN0_bm;
+	PORTB.DIRCLR = PIN1_bm;
+
+	USART3.BAUD = USART_BAUD_VALUE_2X(STREAM_BAUD);						// Double speed mode (CLK2X)
+	USART3.CTRLC = USART_CHSIZE_8BIT_gc | USART_PMODE_DISABLED_gc | USART_SBMODE_1BIT_gc;
+	USART3.CTRLB = USART_TXEN_bm | USART_RXEN_bm | USART_RXMODE_CLK2X_gc;
+}
+
+// Interrupt Service Routine: pack the result, select the next channel
+ISR(ADC0_RESRDY_vect)
+{
+	adc_stream_on_result();
+}
+
+int main(void)
+{
+	USART3_init();
+	ADC0_init();
+	sei();
+
+	// From now on the ADC runs at the stream rate, the samples are only framed while the stream is on
+	adc_trigger_init(ADC_TRIGGER_TCB2, STREAM_RATE_HZ);
+
+	while (1)
+	{
+		// Commands from the PC
+		if (USART3.STATUS & USART_RXCIF_bm)
+		{
+			char c = USART3.RXDATAL;
+
+			if (c == 's')
+			{
+				adc_stream_enable(true);
+			}
+			else if (c == 'x')
+			{
+				adc_stream_enable(false);
+			}
+		}
+
+		// Send the next bytes of a full frame, the ISR already fills the other buffer
+		adc_stream_service();
+	}
+}
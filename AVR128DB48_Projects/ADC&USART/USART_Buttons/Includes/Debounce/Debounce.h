@@ -0,0 +1,82 @@
+/*
+ * Debounce.h
+ *
+ * Debounces all 8 pins of a port at once with vertical counters.
+ *
+ * Every pin has a 3-bit counter, but the counters are stored "vertically":
+ * bit 0 of all 8 counters is in c0, bit 1 in c1 and bit 2 in c2. A counter
+ * runs while its pin differs from the debounced state and is cleared as soon
+ * as the pin agrees again. After DEBOUNCE_SAMPLES differing samples in a row
+ * the state of that pin toggles. All 8 counters are updated together with a
+ * few AND/XOR instructions, so the cost per tick is the same for 1 or 8 buttons.
+ *
+ * A bit is 1 when the pin reads high (same as the old per-pin handlers).
+ * XOR the sample with a mask first for active-low buttons.
+ *
+ * Usage:
+ *  static debounce_t Buttons;
+ *  debounce_init(&Buttons, PORTC.IN);
+ *  1ms ISR:  uint8_t changed = debounce_update(&Buttons, PORTC.IN);
+ *            uint8_t pressed = DEBOUNCE_PRESSED(&Buttons, changed);	// Stable rising edges
+ *
+ * Interrupt-gated: the sampling timer only has to run while a pin bounces.
+ * Start it from a pin-change interrupt (PORT_ISC_BOTHEDGES_gc) and stop it
+ * as soon as debounce_idle() is true. With idle buttons no ISR runs at all.
+ */
+
+#ifndef DEBOUNCE_H_
+#define DEBOUNCE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Consecutive equal samples needed for a change (fixed by the 3-bit counter)
+#define DEBOUNCE_SAMPLES 8
+
+typedef struct {
+	uint8_t state;						// Debounced level of every pin
+	uint8_t c0;							// Vertical counter, bit 0
+	uint8_t c1;							// Vertical counter, bit 1
+	uint8_t c2;							// Vertical counter, bit 2
+} debounce_t;
+
+// Edge masks from the value returned by debounce_update()
+#define DEBOUNCE_PRESSED(db, changed) ((uint8_t)((changed) & (db)->state))
+#define DEBOUNCE_RELEASED(db, changed) ((uint8_t)((changed) & ~(db)->state))
+
+void debounce_init(debounce_t *db, uint8_t initial);
+
+/*
+	Feeds one sample of the port. Call at a fixed rate (e.g. every 1ms).
+	Inline, so an ISR only pays for the bit operations.
+
+	@param sample Port input byte (e.g. PORTC.IN)
+	@return Pins whose debounced state changed with this sample
+*/
+static inline uint8_t debounce_update(debounce_t *db, uint8_t sample)
+{
+	uint8_t delta = sample ^ db->state;							// Pins that differ from the debounced state
+	uint8_t c0 = db->c0;
+	uint8_t c1 = db->c1;
+	uint8_t c2 = db->c2;
+	uint8_t changed = delta & c0 & c1 & c2;						// Counter was at 7: this is the 8th differing sample
+
+	// Increment the counters of differing pins, clear the others (7 wraps to 0)
+	db->c2 = (c2 ^ (c1 & c0)) & delta;
+	db->c1 = (c1 ^ c0) & delta;
+	db->c0 = (uint8_t)~c0 & delta;
+
+	db->state ^= changed;
+	return changed;
+}
+
+/*
+	@return true if the last sample matched the debounced state on every pin (all counters are 0),
+			a gated sampling timer can be stopped
+*/
+static inline bool debounce_idle(const debounce_t *db)
+{
+	return (db->c0 | db->c1 | db->c2) == 0;
+}
+
+#endif /* DEBOUNCE_H_ */
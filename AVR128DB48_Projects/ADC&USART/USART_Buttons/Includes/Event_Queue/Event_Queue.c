@@ -0,0 +1,144 @@
+/*
+ * Event_Queue.c
+ *
+ * Single producer / single consumer ring buffer. On the AVR an ISR is never
+ * interrupted by another ISR (no ISR_NOBLOCK is used), so all ISRs together
+ * act as one producer and main() is the only consumer.
+ *
+ * Head and tail are free running 8-bit indices: the producer only writes
+ * Event_Head and the consumer only writes Event_Tail. Both are single bytes,
+ * so reading them is atomic and no interrupt has to be disabled. The number
+ * of queued events is (Head - Tail), which also lets all slots be used.
+ *
+ * The slots themselves are not volatile (event_get() copies a whole event),
+ * so a compiler barrier keeps the slot accesses in front of the index store
+ * that hands the slot over. Without it the compiler may move the slot stores
+ * behind Event_Head and main can read a half written event.
+ */
+
+#include <stddef.h>
+#include "Event_Queue.h"
+
+// Memory accesses are not moved across it, no instruction is generated
+#define EVENT_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+// VARIABLES //
+static event_t Event_Buffer[EVENT_QUEUE_SIZE];
+static volatile uint8_t Event_Head = 0;						// Written by the producer (ISR)
+static volatile uint8_t Event_Tail = 0;						// Written by the consumer (main)
+static volatile uint8_t Event_Dropped = 0;					// Events lost because the queue was full
+static volatile uint16_t Event_Time_ms = 0;					// Timestamp source, advanced by event_tick()
+
+/*
+	Resets the queue. Call before interrupts are enabled.
+*/
+void event_queue_init(void)
+{
+	Event_Head = 0;
+	Event_Tail = 0;
+	Event_Dropped = 0;
+	Event_Time_ms = 0;
+}
+
+/*
+	Advances the event timestamp by 1ms. Call from the 1ms timer ISR.
+*/
+void event_tick(void)
+{
+	Event_Time_ms++;
+}
+
+/*
+	Returns the current event time in ms (wraps after 65.5 s).
+	Safe in ISR context. In main the 16-bit read can tear, so compare
+	timestamps of events instead of calling this in a tight loop.
+*/
+uint16_t event_now(void)
+{
+	return Event_Time_ms;
+}
+
+/*
+	Appends an event to the queue.
+
+	@param type    Application event type (1 ... handler_count - 1)
+	@param source  Originator of the event
+	@param payload Event data
+	@return true if queued, false if the queue was full (event is counted as dropped)
+*/
+bool event_post(uint8_t type, uint8_t source, uint16_t payload)
+{
+	uint8_t head = Event_Head;
+
+	if ((uint8_t)(head - Event_Tail) >= EVENT_QUEUE_SIZE)
+	{
+		if (Event_Dropped < 0xFF) Event_Dropped++;
+		return false;
+	}
+
+	event_t *slot = &Event_Buffer[head & EVENT_QUEUE_MASK];
+	slot->type = type;
+	slot->source = source;
+	slot->payload = payload;
+	slot->timestamp = Event_Time_ms;
+
+	EVENT_BARRIER();
+	Event_Head = head + 1;									// Publish only after the slot is complete
+	return true;
+}
+
+/*
+	Removes the oldest event from the queue.
+
+	@param event Destination for the event
+	@return true if an event was copied, false if the queue is empty
+*/
+bool event_get(event_t *event)
+{
+	uint8_t tail = Event_Tail;
+
+	if (tail == Event_Head)
+		return false;
+
+	*event = Event_Buffer[tail & EVENT_QUEUE_MASK];
+
+	EVENT_BARRIER();
+	Event_Tail = tail + 1;									// Release the slot only after it was copied
+	return true;
+}
+
+/*
+	Returns the number of events waiting in the queue.
+*/
+uint8_t event_pending(void)
+{
+	return (uint8_t)(Event_Head - Event_Tail);
+}
+
+/*
+	Returns the number of events lost because the queue was full (saturates at 255).
+*/
+uint8_t event_dropped(void)
+{
+	return Event_Dropped;
+}
+
+/*
+	Drains the queue and calls the handler registered for each event type.
+	Events whose type has no handler (NULL or out of range) are discarded.
+
+	@param handlers      Table of handlers, indexed by event type
+	@param handler_count Number of entries in the table
+*/
+void event_dispatch(const event_handler_t *handlers, uint8_t handler_count)
+{
+	event_t event;
+
+	while (event_get(&event))
+	{
+		if (event.type < handler_count && handlers[event.type] != NULL)
+		{
+			handlers[event.type](&event);
+		}
+	}
+}
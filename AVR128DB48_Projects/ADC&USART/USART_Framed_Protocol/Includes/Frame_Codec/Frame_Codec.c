@@ -0,0 +1,205 @@
+/*
+ * Frame_Codec.c
+ *
+ * COBS: every block starts with a code byte n (1 ... 255), n - 1 data bytes
+ * follow. A block with n < 255 stands for its data plus one 0x00, the 0x00
+ * after the last block is left out. The encoder looks ahead only at the start
+ * of a block, so every data byte is read twice at most.
+ */
+
+#include "Frame_Codec.h"
+
+// PRIVATE FUNCTIONS //
+
+/*
+	Adds one decoded byte. A frame that gets too long is discarded up to the delimiter.
+*/
+static void decoder_append(frame_decoder_t *decoder, uint8_t byte)
+{
+	if (decoder->size >= FRAME_MAX_SIZE)
+	{
+		decoder->discard = true;
+		return;
+	}
+
+	decoder->frame->data[decoder->size++] = byte;
+	decoder->crc = frame_crc_update(decoder->crc, byte);
+}
+
+static void decoder_reset(frame_decoder_t *decoder)
+{
+	decoder->size = 0;
+	decoder->crc = FRAME_CRC_INIT;
+	decoder->remaining = 0;
+	decoder->zero_pending = false;
+	decoder->discard = false;
+}
+
+// PUBLIC FUNCTIONS //
+
+/*
+	@return CRC-16/CCITT-FALSE of length bytes ("123456789" gives 0x29B1)
+*/
+uint16_t frame_crc(const uint8_t *data, uint8_t length)
+{
+	uint16_t crc = FRAME_CRC_INIT;
+
+	for (uint8_t i = 0; i < length; i++)
+	{
+		crc = frame_crc_update(crc, data[i]);
+	}
+
+	return crc;
+}
+
+/*
+	Writes the header and the CRC around a payload that is already in
+	frame_payload(frame).
+
+	@return false if payload_length is above FRAME_MAX_PAYLOAD (frame unchanged)
+*/
+bool frame_finish(frame_t *frame, uint8_t type, uint8_t sequence, uint8_t payload_length)
+{
+	if (payload_length > FRAME_MAX_PAYLOAD)
+		return false;
+
+	frame->data[0] = type;
+	frame->data[1] = sequence;
+	frame->size = FRAME_HEADER_SIZE + payload_length;
+
+	uint16_t crc = frame_crc(frame->data, frame->size);
+	frame->data[frame->size++] = (uint8_t)(crc >> 8);
+	frame->data[frame->size++] = (uint8_t)crc;
+	return true;
+}
+
+/*
+	Starts decoding into frame. The decoder expects the first byte of a frame
+	(or garbage, which ends at the next 0x00).
+*/
+void frame_decoder_start(frame_decoder_t *decoder, frame_t *frame)
+{
+	decoder->frame = frame;
+	decoder_reset(decoder);
+}
+
+/*
+	Decodes one received byte.
+
+	@return FRAME_RX_OK when byte was the delimiter of a valid frame (then
+	        decoder->frame holds it until the next frame starts), an error
+	        for a damaged frame, FRAME_RX_BUSY otherwise
+*/
+frame_rx_result_t frame_decoder_put(frame_decoder_t *decoder, uint8_t byte)
+{
+	if (byte == 0)
+	{
+		frame_rx_result_t result;
+
+		if (decoder->size == 0 && !decoder->zero_pending && !decoder->discard)
+		{
+			result = FRAME_RX_BUSY;									// Empty frame, e.g. a leading delimiter
+		}
+		else if (decoder->discard || decoder->remaining != 0 || decoder->size < FRAME_HEADER_SIZE + FRAME_CRC_SIZE)
+		{
+			result = FRAME_RX_FORMAT_ERROR;
+		}
+		else if (decoder->crc != 0)									// CRC over data and CRC is 0
+		{
+			result = FRAME_RX_CRC_ERROR;
+		}
+		else
+		{
+			result = FRAME_RX_OK;
+		}
+
+		decoder->frame->size = decoder->size;
+		decoder_reset(decoder);
+		return result;
+	}
+
+	if (decoder->discard)
+		return FRAME_RX_BUSY;
+
+	if (decoder->remaining == 0)									// Code byte of the next block
+	{
+		if (decoder->zero_pending)
+		{
+			decoder_append(decoder, 0);
+		}
+
+		decoder->remaining = byte - 1;
+		decoder->zero_pending = (byte != 0xFF);
+	}
+	else
+	{
+		decoder_append(decoder, byte);
+		decoder->remaining--;
+	}
+
+	return FRAME_RX_BUSY;
+}
+
+/*
+	Starts encoding a finished frame. The frame must not change until the encoder is done.
+*/
+void frame_encoder_start(frame_encoder_t *encoder, const frame_t *frame)
+{
+	encoder->frame = frame;
+	encoder->index = 0;
+	encoder->remaining = 0;
+	encoder->code = 0;
+	encoder->done = false;
+}
+
+/*
+	Gives the next byte to send.
+
+	@return false when the frame is complete (the last byte was the 0x00 delimiter)
+*/
+bool frame_encoder_next(frame_encoder_t *encoder, uint8_t *byte)
+{
+	const frame_t *frame = encoder->frame;
+
+	if (encoder->done)
+		return false;
+
+	while (1)
+	{
+		if (encoder->code == 0)										// Start of a block: count the bytes up to the next 0x00
+		{
+			uint8_t count = 0;
+
+			while (encoder->index + count < frame->size && frame->data[encoder->index + count] != 0 && count < 254)
+			{
+				count++;
+			}
+
+			encoder->code = count + 1;
+			encoder->remaining = count;
+			*byte = encoder->code;
+			return true;
+		}
+
+		if (encoder->remaining > 0)
+		{
+			encoder->remaining--;
+			*byte = frame->data[encoder->index++];
+			return true;
+		}
+
+		if (encoder->index >= frame->size)
+		{
+			encoder->done = true;
+			*byte = 0;												// Delimiter
+			return true;
+		}
+
+		if (encoder->code != 0xFF)
+		{
+			encoder->index++;										// The 0x00 the code byte stands for
+		}
+
+		encoder->code = 0;
+	}
+}
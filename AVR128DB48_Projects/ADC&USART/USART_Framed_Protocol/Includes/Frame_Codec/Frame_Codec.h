@@ -0,0 +1,128 @@
+/*
+ * Frame_Codec.h
+ *
+ * Binary frames with COBS encoding and CRC-16, one byte at a time.
+ *
+ * Frame before encoding:
+ *  0   type                         message type (application defined)
+ *  1   sequence                     +1 per frame sent, per direction
+ *  2   payload                      0 ... FRAME_MAX_PAYLOAD bytes, little endian values
+ *  n   CRC-16 (high byte first)     CRC-16/CCITT-FALSE of bytes 0 ... n-1
+ *
+ * On the line the frame is COBS encoded (Consistent Overhead Byte Stuffing,
+ * no 0x00 inside, one extra byte) and ends with a 0x00 delimiter. A receiver
+ * that starts in the middle of a frame or loses bytes is in sync again after
+ * the next 0x00. Empty frames (0x00 0x00) are ignored, a sender may start with
+ * a 0x00 to end any garbage on the line.
+ *
+ * The encoder and decoder keep their state between bytes, so they can run
+ * in the USART ISRs: the decoder writes the data straight into a frame_t and
+ * checks the CRC on the fly (the CRC over data plus its own CRC is 0), the
+ * encoder reads from the frame_t main has filled. No frame is copied.
+ *
+ * The module is plain C without AVR headers, Tools/serial_frame compiles the
+ * same file for the PC side.
+ *
+ * Usage (sender):
+ *  uint8_t *payload = frame_payload(&frame);   // Fill the payload in place
+ *  frame_finish(&frame, MSG_TELEMETRY, sequence++, 6);
+ *  frame_encoder_start(&encoder, &frame);
+ *  while (frame_encoder_next(&encoder, &byte)) send(byte);   // Ends with 0x00
+ *
+ * Usage (receiver):
+ *  frame_decoder_start(&decoder, &frame);
+ *  if (frame_decoder_put(&decoder, byte) == FRAME_RX_OK) handle(&frame);
+ */
+
+#ifndef FRAME_CODEC_H_
+#define FRAME_CODEC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef FRAME_MAX_PAYLOAD
+#define FRAME_MAX_PAYLOAD 32
+#endif
+
+#define FRAME_HEADER_SIZE 2
+#define FRAME_CRC_SIZE 2
+#define FRAME_MAX_SIZE (FRAME_HEADER_SIZE + FRAME_MAX_PAYLOAD + FRAME_CRC_SIZE)
+#define FRAME_MAX_ENCODED (FRAME_MAX_SIZE + FRAME_MAX_SIZE / 254 + 2)		// COBS code bytes and delimiter
+
+#if FRAME_MAX_SIZE > 255
+#error "FRAME_MAX_PAYLOAD must be at most 251"
+#endif
+
+#define FRAME_CRC_INIT 0xFFFF
+
+typedef struct {
+	uint8_t size;						// Bytes in data: header, payload and CRC
+	uint8_t data[FRAME_MAX_SIZE];
+} frame_t;
+
+typedef enum {
+	FRAME_RX_BUSY,						// Frame not complete yet
+	FRAME_RX_OK,						// Valid frame, the destination holds it
+	FRAME_RX_CRC_ERROR,					// Complete but damaged
+	FRAME_RX_FORMAT_ERROR				// Too short, too long or broken COBS
+} frame_rx_result_t;
+
+typedef struct {
+	frame_t *frame;						// Destination
+	uint16_t crc;
+	uint8_t size;						// Bytes decoded so far
+	uint8_t remaining;					// Data bytes left in the current COBS block
+	bool zero_pending;					// The current block ends with a 0x00 (code < 0xFF)
+	bool discard;						// Error in this frame, skip up to the delimiter
+} frame_decoder_t;
+
+typedef struct {
+	const frame_t *frame;
+	uint8_t index;						// Next data byte
+	uint8_t remaining;					// Data bytes left in the current COBS block
+	uint8_t code;						// Code byte of the current block, 0 = block not started
+	bool done;							// Delimiter sent
+} frame_encoder_t;
+
+/*
+	CRC-16/CCITT-FALSE (polynomial 0x1021, start FRAME_CRC_INIT), one byte,
+	a few shifts and XORs without a table or loop.
+*/
+static inline uint16_t frame_crc_update(uint16_t crc, uint8_t byte)
+{
+	uint8_t x = (uint8_t)(crc >> 8) ^ byte;
+
+	x ^= x >> 4;
+	return (uint16_t)((crc << 8) ^ ((uint16_t)x << 12) ^ ((uint16_t)x << 5) ^ x);
+}
+
+static inline uint8_t frame_type(const frame_t *frame)
+{
+	return frame->data[0];
+}
+
+static inline uint8_t frame_sequence(const frame_t *frame)
+{
+	return frame->data[1];
+}
+
+static inline uint8_t *frame_payload(frame_t *frame)
+{
+	return &frame->data[FRAME_HEADER_SIZE];
+}
+
+static inline uint8_t frame_payload_length(const frame_t *frame)
+{
+	return (uint8_t)(frame->size - FRAME_HEADER_SIZE - FRAME_CRC_SIZE);
+}
+
+uint16_t frame_crc(const uint8_t *data, uint8_t length);
+bool frame_finish(frame_t *frame, uint8_t type, uint8_t sequence, uint8_t payload_length);
+
+void frame_decoder_start(frame_decoder_t *decoder, frame_t *frame);
+frame_rx_result_t frame_decoder_put(frame_decoder_t *decoder, uint8_t byte);
+
+void frame_encoder_start(frame_encoder_t *encoder, const frame_t *frame);
+bool frame_encoder_next(frame_encoder_t *encoder, uint8_t *byte);
+
+#endif /* FRAME_CODEC_H_ */
@@ -0,0 +1,238 @@
+/*
+ * Serial_Frame.c
+ *
+ * Ownership of the frame buffers:
+ *  RX: the ISR owns Rx_Frames[Rx_Write], main owns Rx_Frames[Rx_Read] while Rx_Pending is set
+ *  TX: main owns Tx_Frames[Tx_Head & 1] while fewer than two frames are queued,
+ *      the ISR owns Tx_Frames[Tx_Tail & 1] until its delimiter is in TXDATA
+ * Rx_Pending, Tx_Head and Tx_Tail are 8-bit, so no access needs a critical section.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "Serial_Frame.h"
+
+#define TX_QUEUE_SIZE 2
+
+// VARIABLES //
+static USART_t *Usart;
+
+static frame_t Rx_Frames[2];
+static frame_decoder_t Decoder;						// Only used by the RXC ISR
+static uint8_t Rx_Write = 0;						// Buffer the ISR decodes into
+static uint8_t Rx_Read = 0;							// Buffer main reads, valid while Rx_Pending
+static volatile bool Rx_Pending = false;
+static uint8_t Rx_Last_Sequence = 0;
+static bool Rx_Sequence_Valid = false;
+
+static frame_t Tx_Frames[TX_QUEUE_SIZE];
+static frame_encoder_t Encoder;						// Only used by the DRE ISR
+static bool Encoder_Active = false;
+static volatile uint8_t Tx_Head = 0;				// Frames queued, written by main
+static volatile uint8_t Tx_Tail = 0;				// Frames sent, written by the DRE ISR
+static uint8_t Tx_Sequence = 0;
+
+static volatile serial_frame_stats_t Stats;
+
+// PRIVATE FUNCTIONS //
+
+/*
+	Called by the RXC ISR for every valid frame.
+*/
+static void on_frame(void)
+{
+	frame_t *frame = &Rx_Frames[Rx_Write];
+	uint8_t sequence = frame_sequence(frame);
+
+	Stats.rx_frames++;
+
+	if (Rx_Sequence_Valid && sequence != (uint8_t)(Rx_Last_Sequence + 1))
+	{
+		Stats.sequence_gaps++;
+	}
+
+	Rx_Last_Sequence = sequence;
+	Rx_Sequence_Valid = true;
+
+	if (Rx_Pending)
+	{
+		Stats.rx_dropped++;									// Decode the next frame into the same buffer
+		return;
+	}
+
+	Rx_Read = Rx_Write;
+	Rx_Write ^= 1;
+	frame_decoder_start(&Decoder, &Rx_Frames[Rx_Write]);
+	Rx_Pending = true;
+}
+
+// PUBLIC FUNCTIONS //
+
+/*
+	Sets up the USART for 8N1 with receiver, transmitter and RX interrupt.
+	Pins (direction, PORTMUX route) are set by the caller. Call before sei().
+
+	@param hw            Peripheral, e.g. &USART3
+	@param baud_register Value for the BAUD register (USART_BAUD_VALUE() or USART_BAUD_VALUE_2X())
+	@param speed         Sampling mode the register was computed for
+*/
+void serial_frame_init(USART_t *hw, uint16_t baud_register, usart_speed_t speed)
+{
+	Usart = hw;
+	Rx_Write = 0;
+	Rx_Pending = false;
+	Rx_Sequence_Valid = false;
+	Tx_Head = 0;
+	Tx_Tail = 0;
+	Encoder_Active = false;
+	frame_decoder_start(&Decoder, &Rx_Frames[0]);
+
+	hw->CTRLB = 0;
+	hw->BAUD = baud_register;
+	hw->CTRLC = USART_CMODE_ASYNCHRONOUS_gc | USART_CHSIZE_8BIT_gc | USART_PMODE_DISABLED_gc | USART_SBMODE_1BIT_gc;
+	hw->CTRLA = USART_RXCIE_bm;										// DREIE only while a frame is queued
+	hw->CTRLB = USART_RXEN_bm | USART_TXEN_bm
+		| ((speed == USART_DOUBLE_SPEED) ? USART_RXMODE_CLK2X_gc : USART_RXMODE_NORMAL_gc);
+}
+
+/*
+	@return The oldest received frame (type, sequence, payload), NULL if there is none.
+	        Main owns it until serial_frame_release().
+*/
+frame_t *serial_frame_receive(void)
+{
+	if (!Rx_Pending)
+		return NULL;
+
+	return &Rx_Frames[Rx_Read];
+}
+
+/*
+	Gives the received frame back to the ISR.
+*/
+void serial_frame_release(void)
+{
+	Rx_Pending = false;
+}
+
+/*
+	@return Frame buffer to fill with frame_payload(), NULL if two frames are
+	        still being sent. Valid until serial_frame_send().
+*/
+frame_t *serial_frame_tx_buffer(void)
+{
+	uint8_t head = Tx_Head;
+
+	if ((uint8_t)(head - Tx_Tail) >= TX_QUEUE_SIZE)
+		return NULL;
+
+	return &Tx_Frames[head & (TX_QUEUE_SIZE - 1)];
+}
+
+/*
+	Adds type, the next sequence number and the CRC to the frame from
+	serial_frame_tx_buffer() and queues it.
+
+	@return false if there was no free buffer or payload_length is too large (counted as rejected)
+*/
+bool serial_frame_send(uint8_t type, uint8_t payload_length)
+{
+	frame_t *frame = serial_frame_tx_buffer();
+
+	if (frame == NULL || !frame_finish(frame, type, Tx_Sequence, payload_length))
+	{
+		uint8_t sreg = SREG;
+		cli();
+		Stats.tx_rejected++;
+		SREG = sreg;
+		return false;
+	}
+
+	Tx_Sequence++;
+	Tx_Head++;														// Publish after the frame is complete
+	Usart->STATUS = USART_TXCIF_bm;									// serial_frame_tx_done() waits for the new frame
+	Usart->CTRLA |= USART_DREIE_bm;
+	return true;
+}
+
+/*
+	@return true when every queued frame has left the shift register (e.g. before sleeping)
+*/
+bool serial_frame_tx_done(void)
+{
+	return Tx_Head == Tx_Tail && (Usart->STATUS & USART_TXCIF_bm);
+}
+
+/*
+	Consistent copy of the counters.
+*/
+void serial_frame_get_stats(serial_frame_stats_t *stats)
+{
+	uint8_t sreg = SREG;
+	cli();
+	*stats = *(const serial_frame_stats_t *)&Stats;					// Interrupts are off, volatile is not needed
+	SREG = sreg;
+}
+
+/*
+	Call from USARTn_RXC_vect. Decodes one byte, a damaged byte is still
+	decoded (the CRC rejects the frame).
+*/
+void serial_frame_rx_isr(void)
+{
+	uint8_t status = Usart->RXDATAH;								// Error flags of the byte in RXDATAL, read first
+	uint8_t data = Usart->RXDATAL;
+
+	if (status & (USART_FERR_bm | USART_BUFOVF_bm))
+	{
+		Stats.line_errors++;
+	}
+
+	switch (frame_decoder_put(&Decoder, data))
+	{
+		case FRAME_RX_OK:
+			on_frame();
+			break;
+		case FRAME_RX_CRC_ERROR:
+			Stats.crc_errors++;
+			break;
+		case FRAME_RX_FORMAT_ERROR:
+			Stats.format_errors++;
+			break;
+		default:
+			break;
+	}
+}
+
+/*
+	Call from USARTn_DRE_vect. Sends the next encoded byte, starts the next
+	queued frame after a delimiter, disables the interrupt when nothing is left.
+*/
+void serial_frame_dre_isr(void)
+{
+	uint8_t data;
+
+	if (!Encoder_Active)
+	{
+		uint8_t tail = Tx_Tail;
+
+		if (tail == Tx_Head)
+		{
+			Usart->CTRLA &= ~USART_DREIE_bm;
+			return;
+		}
+
+		frame_encoder_start(&Encoder, &Tx_Frames[tail & (TX_QUEUE_SIZE - 1)]);
+		Encoder_Active = true;
+	}
+
+	frame_encoder_next(&Encoder, &data);
+	Usart->TXDATAL = data;
+
+	if (Encoder.done)												// Delimiter sent, the buffer is free again
+	{
+		Encoder_Active = false;
+		Stats.tx_frames++;
+		Tx_Tail++;
+	}
+}
@@ -0,0 +1,66 @@
+/*
+ * Serial_Frame.h
+ *
+ * Frame_Codec frames over a USART, encoded and decoded in the interrupts.
+ *
+ * RX: the RXC ISR decodes every byte straight into one of two frame buffers.
+ * A valid frame is handed to main (serial_frame_receive()) and the ISR goes
+ * on in the other buffer. If main still holds the previous frame the new one
+ * is dropped and counted. Damaged frames are counted and skipped, the
+ * decoder is in sync again after the next delimiter.
+ *
+ * TX: main fills the payload of a free frame buffer in place
+ * (serial_frame_tx_buffer()), serial_frame_send() adds type, sequence number
+ * and CRC. The DRE ISR COBS encodes the frame one byte per interrupt and
+ * switches itself off when no frame is left. Two frames can be queued.
+ *
+ * Sequence numbers: sent frames are numbered automatically (+1 per frame),
+ * for received frames every jump in the sequence is counted as a gap.
+ *
+ * Usage:
+ *  PORTB.DIRSET = PIN0_bm;                                   // USART3 TX = PB0, RX = PB1
+ *  serial_frame_init(&USART3, USART_BAUD_VALUE(115200), USART_NORMAL_SPEED);
+ *  ISR(USART3_RXC_vect) { serial_frame_rx_isr(); }
+ *  ISR(USART3_DRE_vect) { serial_frame_dre_isr(); }
+ *  main: frame_t *rx = serial_frame_receive(); ... serial_frame_release();
+ *        frame_t *tx = serial_frame_tx_buffer(); fill frame_payload(tx); serial_frame_send(type, length);
+ *
+ * Resources: one USART (8N1, RXC and DRE interrupts).
+ */
+
+#ifndef SERIAL_FRAME_H_
+#define SERIAL_FRAME_H_
+
+#include <avr/io.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "../Frame_Codec/Frame_Codec.h"
+#include "../USART_Driver/USART_Driver.h"
+
+typedef struct {
+	uint16_t rx_frames;					// Valid frames received
+	uint16_t crc_errors;				// Complete frames with a wrong CRC
+	uint16_t format_errors;				// Too short, too long or broken COBS
+	uint16_t rx_dropped;				// Valid frames lost because main still held the previous one
+	uint16_t sequence_gaps;				// Received sequence numbers that were not previous + 1
+	uint16_t line_errors;				// Framing errors and hardware overruns (BUFOVF)
+	uint16_t tx_frames;					// Frames sent completely
+	uint16_t tx_rejected;				// serial_frame_send() without a free buffer or with a too long payload
+} serial_frame_stats_t;
+
+void serial_frame_init(USART_t *hw, uint16_t baud_register, usart_speed_t speed);
+
+frame_t *serial_frame_receive(void);
+void serial_frame_release(void);
+
+frame_t *serial_frame_tx_buffer(void);
+bool serial_frame_send(uint8_t type, uint8_t payload_length);
+bool serial_frame_tx_done(void);
+
+void serial_frame_get_stats(serial_frame_stats_t *stats);
+
+void serial_frame_rx_isr(void);
+void serial_frame_dre_isr(void);
+
+#endif /* SERIAL_FRAME_H_ */
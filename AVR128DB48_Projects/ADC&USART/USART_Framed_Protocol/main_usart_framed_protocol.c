@@ -0,0 +1,283 @@
+/*
+ * main_usart_framed_protocol.c
+ *
+ * Commands and telemetry as binary frames (COBS, sequence number, CRC-16)
+ * instead of text lines.
+ *
+ * The PC sends commands (ping, RGB colour, statistics, telemetry rate), every
+ * command is answered with an ACK or a reply. The potentiometer (PF3) and the
+ * running time are sent as telemetry frames every 100ms. The frames are
+ * encoded and decoded in the USART3 ISRs (Serial_Frame module), main only
+ * works with whole frames.
+ * PC side: Tools/serial_frame (frame_tool, loopback test).
+ *
+ * Messages (payload values little endian):
+ *  PC -> board   0x01 PING           any payload
+ *                0x02 SET_RGB        red, green, blue (uint8 each)
+ *                0x03 GET_STATS      -
+ *                0x04 SET_TELEMETRY  period in ms (uint16, 0 = off)
+ *  board -> PC   0x80 ACK            sequence of the command, status
+ *                0x81 PONG           payload of the PING
+ *                0x83 STATS          serial_frame_stats_t (8 x uint16)
+ *                0x90 TELEMETRY      time in ms (uint32), potentiometer 0 ... 4095 (uint16)
+ */
+
+#define F_CPU 4000000UL																// CPU Frequency 4MHz
+#define BAUD_RATE 115200UL															// 0.08% error at 4MHz
+#define BAUD_SPEED USART_NORMAL_SPEED
+#define TELEMETRY_PERIOD_MS 100														// Default, changed with SET_TELEMETRY
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <stdbool.h>
+#include "Frame_Codec.h"
+#include "Serial_Frame.h"
+#include "USART_Driver.h"
+#include "ADC_Driver.h"
+
+USART_BAUD_CHECK(BAUD_RATE, BAUD_SPEED);
+
+// Message types
+typedef enum {
+	MSG_PING = 0x01,
+	MSG_SET_RGB = 0x02,
+	MSG_GET_STATS = 0x03,
+	MSG_SET_TELEMETRY = 0x04,
+	MSG_ACK = 0x80,
+	MSG_PONG = 0x81,
+	MSG_STATS = 0x83,
+	MSG_TELEMETRY = 0x90
+} msg_type_t;
+
+// Status in an ACK
+typedef enum {
+	STATUS_OK = 0,
+	STATUS_BAD_LENGTH = 1,
+	STATUS_UNKNOWN_TYPE = 2
+} msg_status_t;
+
+// Potentiometer on AIN19 (PF3): single 12-bit conversions on request
+static const adc_channel_t Pot_Channel = {
+	ADC_MUXPOS_AIN19_gc, VREF_REFSEL_VDD_gc, ADC_RESSEL_12BIT_gc, ADC_SAMPNUM_ACC1_gc, 0, 0
+};
+
+volatile uint32_t Time_Ms = 0;														// Running time, TCB0 ISR
+static uint16_t Telemetry_Period_Ms = TELEMETRY_PERIOD_MS;
+
+/**
+ * @brief Initializes Timer/Counter B0 (TCB0) for 1ms periodic interrupts.
+ */
+void timer_init(void)
+{
+	TCB0.CCMP = 3999;
+	TCB0.CTRLA = TCB_CLKSEL_DIV1_gc;
+	TCB0.CTRLB = TCB_CNTMODE_INT_gc;
+	TCB0.INTCTRL = TCB_CAPT_bm;
+	TCB0.CTRLA |= TCB_ENABLE_bm;
+}
+
+/**
+ * @brief RGB LED on PE0 ... PE2, 8-bit single slope PWM of TCA0 (15.6kHz).
+ */
+void TCA0_init(void)
+{
+	PORTMUX.TCAROUTEA = (PORTMUX.TCAROUTEA & ~PORTMUX_TCA0_gm) | PORTMUX_TCA0_PORTE_gc;
+	PORTE.DIRSET = PIN0_bm | PIN1_bm | PIN2_bm;
+
+	TCA0.SINGLE.CTRLA = 0;
+	TCA0.SINGLE.CTRLESET = TCA_SINGLE_CMD_RESET_gc;
+	TCA0.SINGLE.PER = 255;
+	TCA0.SINGLE.CTRLB = TCA_SINGLE_CMP0EN_bm | TCA_SINGLE_CMP1EN_bm | TCA_SINGLE_CMP2EN_bm | TCA_SINGLE_WGMODE_SINGLESLOPE_gc;
+	TCA0.SINGLE.CTRLA = TCA_SINGLE_CLKSEL_DIV1_gc | TCA_SINGLE_ENABLE_bm;
+}
+
+void USART3_init(void)
+{
+	PORTMUX.USARTROUTEA &= ~PORTMUX_USART3_gm;										// PB0 = TX, PB1 = RX
+	PORTB.DIRSET = PIN0_bm;
+	PORTB.DIRCLR = PIN1_bm;
+	serial_frame_init(&USART3, (uint16_t)USART_BAUD_REGISTER(BAUD_RATE, BAUD_SPEED), BAUD_SPEED);
+}
+
+void ADC0_init(void)
+{
+	PORTF.PIN3CTRL = PORT_ISC_INPUT_DISABLE_gc;										// Digital input buffer of PF3 off
+	adc_driver_init(ADC_PRESC_DIV4_gc, false);										// 1MHz ADC clock, read on request
+}
+
+// Interrupt Service Routines
+ISR(TCB0_INT_vect)
+{
+	TCB0.INTFLAGS = TCB_CAPT_bm;
+	Time_Ms++;
+}
+
+ISR(USART3_RXC_vect)
+{
+	serial_frame_rx_isr();
+}
+
+ISR(USART3_DRE_vect)
+{
+	serial_frame_dre_isr();
+}
+
+static uint32_t time_ms(void)
+{
+	uint8_t sreg = SREG;
+	cli();
+	uint32_t now = Time_Ms;
+	SREG = sreg;
+	return now;
+}
+
+static void put_u16(uint8_t *p, uint16_t value)
+{
+	p[0] = (uint8_t)value;
+	p[1] = (uint8_t)(value >> 8);
+}
+
+/*
+ * Waits for a free TX buffer (at most one frame time, ~4ms at 115200 baud).
+ */
+static frame_t *tx_buffer(void)
+{
+	frame_t *frame;
+
+	while ((frame = serial_frame_tx_buffer()) == NULL)
+	{
+		;
+	}
+
+	return frame;
+}
+
+static void send_ack(uint8_t sequence, msg_status_t status)
+{
+	uint8_t *payload = frame_payload(tx_buffer());
+
+	payload[0] = sequence;
+	payload[1] = status;
+	serial_frame_send(MSG_ACK, 2);
+}
+
+/*
+ * Handles one received command, every command gets exactly one answer.
+ */
+static void handle_command(frame_t *command)
+{
+	const uint8_t *data = frame_payload(command);
+	uint8_t length = frame_payload_length(command);
+	uint8_t sequence = frame_sequence(command);
+
+	switch (frame_type(command))
+	{
+		case MSG_PING:
+		{
+			uint8_t *payload = frame_payload(tx_buffer());
+
+			for (uint8_t i = 0; i < length; i++)
+			{
+				payload[i] = data[i];
+			}
+
+			serial_frame_send(MSG_PONG, length);
+			break;
+		}
+		case MSG_SET_RGB:
+			if (length != 3)
+			{
+				send_ack(sequence, STATUS_BAD_LENGTH);
+				break;
+			}
+
+			TCA0.SINGLE.CMP0BUF = data[0];
+			TCA0.SINGLE.CMP1BUF = data[1];
+			TCA0.SINGLE.CMP2BUF = data[2];
+			send_ack(sequence, STATUS_OK);
+			break;
+		case MSG_GET_STATS:
+		{
+			serial_frame_stats_t stats;
+			uint8_t *payload = frame_payload(tx_buffer());
+
+			serial_frame_get_stats(&stats);
+			put_u16(&payload[0], stats.rx_frames);
+			put_u16(&payload[2], stats.crc_errors);
+			put_u16(&payload[4], stats.format_errors);
+			put_u16(&payload[6], stats.rx_dropped);
+			put_u16(&payload[8], stats.sequence_gaps);
+			put_u16(&payload[10], stats.line_errors);
+			put_u16(&payload[12], stats.tx_frames);
+			put_u16(&payload[14], stats.tx_rejected);
+			serial_frame_send(MSG_STATS, 16);
+			break;
+		}
+		case MSG_SET_TELEMETRY:
+			if (length != 2)
+			{
+				send_ack(sequence, STATUS_BAD_LENGTH);
+				break;
+			}
+
+			Telemetry_Period_Ms = data[0] | ((uint16_t)data[1] << 8);
+			send_ack(sequence, STATUS_OK);
+			break;
+		default:
+			send_ack(sequence, STATUS_UNKNOWN_TYPE);
+			break;
+	}
+}
+
+/*
+ * Sends one telemetry frame if a buffer is free, otherwise skips this period.
+ */
+static void send_telemetry(uint32_t now)
+{
+	frame_t *frame = serial_frame_tx_buffer();
+
+	if (frame == NULL)
+		return;
+
+	uint8_t *payload = frame_payload(frame);
+	uint16_t pot = adc_driver_read(&Pot_Channel);
+
+	payload[0] = (uint8_t)now;
+	payload[1] = (uint8_t)(now >> 8);
+	payload[2] = (uint8_t)(now >> 16);
+	payload[3] = (uint8_t)(now >> 24);
+	put_u16(&payload[4], pot);
+	serial_frame_send(MSG_TELEMETRY, 6);
+}
+
+int main(void)
+{
+	uint32_t Last_Telemetry_Ms = 0;
+
+	USART3_init();
+	TCA0_init();
+	ADC0_init();
+	timer_init();
+	sei();
+
+	while (1)
+	{
+		// Commands from the PC, decoded by the RXC ISR
+		frame_t *command = serial_frame_receive();
+
+		if (command != NULL)
+		{
+			handle_command(command);
+			serial_frame_release();
+		}
+
+		// Telemetry
+		uint32_t now = time_ms();
+
+		if (Telemetry_Period_Ms != 0 && now - Last_Telemetry_Ms >= Telemetry_Period_Ms)
+		{
+			Last_Telemetry_Ms = now;
+			send_telemetry(now);
+		}
+	}
+}
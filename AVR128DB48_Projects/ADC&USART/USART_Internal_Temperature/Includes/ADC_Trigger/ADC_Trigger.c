@@ -0,0 +1,179 @@
+/*
+ * ADC_Trigger.c
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "ADC_Trigger.h"
+#include "../Timestamp/Timestamp.h"
+
+#define TCB2_CLOCK_HZ (F_CPU / 2)					// TCB_CLKSEL_DIV2
+
+// VARIABLES //
+static adc_trigger_source_t Trigger_Source = ADC_TRIGGER_TCB2;
+static bool Rtc_Shared = false;								// The RTC counter belongs to RTC_Clock
+static volatile adc_jitter_t Jitter;
+static volatile uint32_t Last_Mark = 0;
+static volatile bool Mark_Valid = false;					// Last_Mark holds a timestamp
+
+// PRIVATE FUNCTIONS //
+
+static bool tcb2_init(uint16_t rate_hz)
+{
+	uint32_t top = TCB2_CLOCK_HZ / rate_hz;
+
+	if (top < 2 || top > 65536UL)
+		return false;
+
+	TCB2.CTRLA = 0;
+	TCB2.CNT = 0;
+	TCB2.CCMP = (uint16_t)(top - 1);				// Period = CCMP + 1
+	TCB2.CTRLB = TCB_CNTMODE_INT_gc;				// Periodic mode, CAPT event at every period
+	TCB2.INTCTRL = 0;								// No interrupt, the event is all we need
+	TCB2.CTRLA = TCB_CLKSEL_DIV2_gc | TCB_ENABLE_bm;
+
+	EVSYS.CHANNEL0 = EVSYS_CHANNEL0_TCB2_CAPT_gc;
+	return true;
+}
+
+static bool rtc_init(uint16_t rate_hz)
+{
+	uint32_t top = ADC_TRIGGER_RTC_HZ / rate_hz;
+
+	if (top < 2 || top > 65536UL)
+		return false;
+
+	if ((RTC.CTRLA & RTC_RTCEN_bm) && (RTC.INTCTRL & RTC_OVF_bm))	// RTC_Clock counts seconds with it: use its overflow
+	{
+		if ((uint32_t)RTC.PER + 1 != top || (RTC.CTRLA & RTC_PRESCALER_gm) != RTC_PRESCALER_DIV1_gc)
+			return false;
+
+		Rtc_Shared = true;
+		EVSYS.CHANNEL0 = EVSYS_CHANNEL0_RTC_OVF_gc;
+		return true;
+	}
+
+	Rtc_Shared = false;
+
+	while (RTC.STATUS)								// Wait until earlier writes are synchronized
+	{
+		;
+	}
+	RTC.CTRLA = 0;
+	while (RTC.STATUS & RTC_CTRLABUSY_bm)
+	{
+		;
+	}
+
+	if (!(RTC.PITCTRLA & RTC_PITEN_bm))				// A running PIT already selected the 32.768kHz source
+	{
+		RTC.CLKSEL = RTC_CLKSEL_OSC32K_gc;			// Internal 32.768kHz oscillator
+	}
+	RTC.CNT = 0;
+	RTC.PER = (uint16_t)(top - 1);					// Overflow every PER + 1 ticks
+	RTC.INTCTRL = 0;
+
+	while (RTC.STATUS)
+	{
+		;
+	}
+	RTC.CTRLA = RTC_PRESCALER_DIV1_gc | RTC_RUNSTDBY_bm | RTC_RTCEN_bm;
+
+	EVSYS.CHANNEL0 = EVSYS_CHANNEL0_RTC_OVF_gc;
+	return true;
+}
+
+// PUBLIC FUNCTIONS //
+
+/*
+	Configures the timer and routes its event to ADC0 START.
+	ADC0 itself (reference, MUXPOS, resolution, RESRDY interrupt) must be set up by the caller,
+	and no conversion should be started with ADC0.COMMAND anymore.
+
+	@param source  Timer that generates the trigger
+	@param rate_hz Conversions per second
+	@return false if the rate is out of range for the source (nothing is changed)
+*/
+bool adc_trigger_init(adc_trigger_source_t source, uint16_t rate_hz)
+{
+	if (rate_hz == 0)
+		return false;
+
+	bool ok = (source == ADC_TRIGGER_RTC) ? rtc_init(rate_hz) : tcb2_init(rate_hz);
+
+	if (!ok)
+		return false;
+
+	Trigger_Source = source;
+	adc_trigger_reset_jitter();
+
+	EVSYS.USERADC0START = EVSYS_USER_CHANNEL0_gc;	// Channel 0 -> ADC0 start conversion
+	ADC0.EVCTRL = ADC_STARTEI_bm;
+	return true;
+}
+
+/*
+	Stops the trigger timer and disconnects the event from the ADC.
+*/
+void adc_trigger_stop(void)
+{
+	ADC0.EVCTRL = 0;
+	EVSYS.USERADC0START = 0;
+
+	if (Trigger_Source == ADC_TRIGGER_RTC && !Rtc_Shared)
+	{
+		while (RTC.STATUS & RTC_CTRLABUSY_bm)
+		{
+			;
+		}
+		RTC.CTRLA &= ~RTC_RTCEN_bm;
+	}
+	else
+	{
+		TCB2.CTRLA &= ~TCB_ENABLE_bm;
+	}
+}
+
+/*
+	Records the time between this call and the previous one.
+	Call at the start of ADC0_RESRDY_vect (uses timestamp_cycles()).
+*/
+void adc_trigger_mark(void)
+{
+	uint32_t now = timestamp_cycles();
+
+	if (Mark_Valid)
+	{
+		uint32_t period = now - Last_Mark;
+
+		if (period < Jitter.period_min) Jitter.period_min = period;
+		if (period > Jitter.period_max) Jitter.period_max = period;
+		if (Jitter.count < 0xFFFF) Jitter.count++;
+	}
+	Last_Mark = now;
+	Mark_Valid = true;
+}
+
+/*
+	Copies the measured period statistics.
+*/
+void adc_trigger_get_jitter(adc_jitter_t *jitter)
+{
+	uint8_t sreg = SREG;
+	cli();
+	jitter->count = Jitter.count;
+	jitter->period_min = Jitter.period_min;
+	jitter->period_max = Jitter.period_max;
+	SREG = sreg;
+}
+
+void adc_trigger_reset_jitter(void)
+{
+	uint8_t sreg = SREG;
+	cli();
+	Jitter.count = 0;
+	Jitter.period_min = 0xFFFFFFFFUL;
+	Jitter.period_max = 0;
+	Mark_Valid = false;
+	SREG = sreg;
+}
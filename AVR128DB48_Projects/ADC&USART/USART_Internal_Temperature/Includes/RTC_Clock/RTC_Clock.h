@@ -0,0 +1,65 @@
+/*
+ * RTC_Clock.h
+ *
+ * Wall-clock timekeeping with the RTC counter.
+ *
+ * The RTC counts the 32.768kHz clock from 0 to 32767 (PER) and its overflow
+ * interrupt adds one second, so there is exactly one interrupt per second
+ * and no other timer is needed. The sub-second part is RTC.CNT itself
+ * (1/32768 s resolution). The 32.768kHz crystal of the Curiosity Nano
+ * (XOSC32K on PF0/PF1) is used if it starts, otherwise the internal OSC32K.
+ *
+ * Calibration: a PIT event (32.768kHz divided by RTC_CLOCK_PIT_DIV, about
+ * 64Hz at 4MHz) is routed through the Event System to TCB3 in frequency
+ * measurement mode. TCB3 captures the CLK_PER cycles of every event period
+ * in hardware, without an interrupt; rtc_clock_calibrate() reads the last
+ * capture and trims the main oscillator against the 32.768kHz reference.
+ *
+ * Usage:
+ *  1. rtc_clock_init(true); sei();
+ *  2. Read the time with rtc_clock_now() or rtc_clock_seconds().
+ *  3. Optionally call rtc_clock_calibrate() once per second from main.
+ *
+ * Resources: RTC counter and RTC_CNT_vect, RTC PIT (event only), RTC.CLKSEL,
+ * TCB3, EVSYS channel 1. ADC_Trigger can share the 1Hz overflow event
+ * (adc_trigger_init(ADC_TRIGGER_RTC, 1) after rtc_clock_init()).
+ */
+
+#ifndef RTC_CLOCK_H_
+#define RTC_CLOCK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef F_CPU
+#define F_CPU 4000000UL
+#endif
+
+#define RTC_CLOCK_HZ 32768UL
+
+// PIT divider for the calibration event: the largest one whose period still
+// fits into the 16-bit TCB capture with about 5% margin (62500 cycles)
+#if F_CPU <= 4000000UL
+#define RTC_CLOCK_PIT_DIV 512
+#elif F_CPU <= 8000000UL
+#define RTC_CLOCK_PIT_DIV 256
+#elif F_CPU <= 16000000UL
+#define RTC_CLOCK_PIT_DIV 128
+#else
+#define RTC_CLOCK_PIT_DIV 64
+#endif
+
+// Called from the RTC overflow ISR once per second with the new second count (keep it short)
+typedef void (*rtc_clock_callback_t)(uint32_t seconds);
+
+bool rtc_clock_init(bool use_crystal);
+void rtc_clock_set_callback(rtc_clock_callback_t callback);
+
+uint32_t rtc_clock_seconds(void);
+void rtc_clock_now(uint32_t *seconds, uint16_t *millis);
+
+uint32_t rtc_clock_cycles_per_second(void);
+int32_t rtc_clock_error_ppm(void);
+bool rtc_clock_calibrate(void);
+
+#endif /* RTC_CLOCK_H_ */
@@ -0,0 +1,56 @@
+/*
+ * Timestamp.h
+ *
+ * Free-running high-resolution timestamp service.
+ *
+ * TCB1 counts CLK_PER cycles from 0 to 0xFFFF and its overflow interrupt extends
+ * the count with a software overflow counter. Together they form a monotonic
+ * cycle counter (0.25us resolution at 4MHz) that can be read from ISRs and
+ * from main. Interrupts are disabled only for the few instructions of the read.
+ *
+ * Usage:
+ *  1. Call timestamp_init() once, then enable interrupts with sei().
+ *  2. Take a start value with timestamp_cycles() or timestamp_us().
+ *  3. Measure with timestamp_elapsed_cycles()/timestamp_elapsed_us() or wait with timestamp_delay_us()/_ms().
+ *
+ * Resources: TCB1 and its TCB1_INT_vect (one interrupt every 65536 cycles).
+ */
+
+#ifndef TIMESTAMP_H_
+#define TIMESTAMP_H_
+
+#include <stdint.h>
+
+#ifndef F_CPU
+#define F_CPU 4000000UL
+#endif
+
+#define TIMESTAMP_CYCLES_PER_US (F_CPU / 1000000UL)
+
+// Cycles -> microseconds is done with a shift, so F_CPU must be a power-of-two number of MHz
+#if TIMESTAMP_CYCLES_PER_US == 1
+#define TIMESTAMP_US_SHIFT 0
+#elif TIMESTAMP_CYCLES_PER_US == 2
+#define TIMESTAMP_US_SHIFT 1
+#elif TIMESTAMP_CYCLES_PER_US == 4
+#define TIMESTAMP_US_SHIFT 2
+#elif TIMESTAMP_CYCLES_PER_US == 8
+#define TIMESTAMP_US_SHIFT 3
+#elif TIMESTAMP_CYCLES_PER_US == 16
+#define TIMESTAMP_US_SHIFT 4
+#else
+#error "Timestamp: F_CPU must be 1, 2, 4, 8 or 16 MHz"
+#endif
+
+void timestamp_init(void);
+
+uint32_t timestamp_cycles(void);
+uint32_t timestamp_us(void);
+
+uint32_t timestamp_elapsed_cycles(uint32_t start_cycles);
+uint32_t timestamp_elapsed_us(uint32_t start_us);
+
+void timestamp_delay_us(uint32_t us);
+void timestamp_delay_ms(uint16_t ms);
+
+#endif /* TIMESTAMP_H_ */
@@ -0,0 +1,98 @@
+/*
+ * USART_Driver.h
+ *
+ * Interrupt driven full-duplex driver for any USARTn, with RX and TX ring buffers.
+ *
+ * The RXC ISR puts every received byte into the RX ring, the DRE ISR sends
+ * from the TX ring and switches itself off when the ring is empty. Main only
+ * touches the rings, nothing blocks:
+ *  - usart_driver_write() / usart_driver_put_string() queue all bytes or none
+ *    (a message is never cut off), a rejected message is counted
+ *  - usart_driver_get_char() / usart_driver_read() return what has arrived
+ *
+ * Rings use free running 8-bit head/tail indices like the Event_Queue: the
+ * ISR and main each write only their own index, so no interrupt has to be
+ * disabled and all slots can be used. Sizes must be powers of two (2 ... 128).
+ *
+ * Errors are counted, not reported per byte: RX ring full, hardware buffer
+ * overflow (BUFOVF, the RX ISR came too late), framing and parity errors
+ * (the byte is dropped) and rejected TX data.
+ *
+ * The driver accesses the peripheral only through usart->hw, so it can run on
+ * a PC against a USART_t in RAM (call the ISR functions by hand).
+ *
+ * Baud rate: USART_BAUD_VALUE() / USART_BAUD_VALUE_2X() and USART_BAUD_CHECK()
+ * come from USART_Baud (also used by Debug_USART), computed by the compiler.
+ *
+ * Usage:
+ *  USART_DRIVER_DEFINE(Serial, 16, 128);                 // Instance with 16 byte RX and 128 byte TX ring
+ *  USART_BAUD_CHECK(115200, USART_NORMAL_SPEED);         // At file scope, fails the build for a bad rate
+ *  PORTB.DIRSET = PIN0_bm;                               // TX pin of USART3 (PB0), RX = PB1
+ *  usart_driver_init(&Serial, &USART3, USART_BAUD_VALUE(115200), USART_NORMAL_SPEED);
+ *  usart_driver_init(&Serial, &USART3, USART_BAUD_VALUE_2X(500000), USART_DOUBLE_SPEED);
+ *  ISR(USART3_RXC_vect) { usart_driver_rx_isr(&Serial); }
+ *  ISR(USART3_DRE_vect) { usart_driver_dre_isr(&Serial); }
+ *  or, to handle each byte in the ISR: if (usart_driver_rx_read(&Serial, &data)) ...
+ *  main: usart_driver_put_string(&Serial, "Hello\r\n"); if (usart_driver_get_char(&Serial, &c)) ...
+ */
+
+#ifndef USART_DRIVER_H_
+#define USART_DRIVER_H_
+
+#include <avr/io.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "../USART_Baud/USART_Baud.h"
+
+// True for a ring size the driver can use
+#define USART_RING_SIZE_OK(size) ((size) >= 2 && (size) <= 128 && ((size) & ((size) - 1)) == 0)
+
+typedef struct {
+	uint16_t rx_overflows;				// Bytes lost because the RX ring was full
+	uint16_t hw_overruns;				// Bytes lost in the hardware (BUFOVF), the RX ISR was blocked too long
+	uint16_t frame_errors;				// Bytes with a missing stop bit (wrong baud rate, line noise)
+	uint16_t parity_errors;				// Only with parity enabled
+	uint16_t tx_rejected;				// Bytes not queued because the TX ring had no room for the whole write
+} usart_errors_t;
+
+typedef struct {
+	USART_t *hw;
+	uint8_t *rx_buffer;
+	uint8_t *tx_buffer;
+	uint8_t rx_mask;					// Ring size - 1
+	uint8_t tx_mask;
+	volatile uint8_t rx_head;			// Written by the RXC ISR
+	volatile uint8_t rx_tail;			// Written by main
+	volatile uint8_t tx_head;			// Written by main
+	volatile uint8_t tx_tail;			// Written by the DRE ISR
+	volatile usart_errors_t errors;
+} usart_driver_t;
+
+// Defines a driver instance and its ring buffers (static, at file scope)
+#define USART_DRIVER_DEFINE(name, rx_size, tx_size) \
+	_Static_assert(USART_RING_SIZE_OK(rx_size) && USART_RING_SIZE_OK(tx_size), \
+		"USART ring sizes must be powers of 2 from 2 to 128"); \
+	static uint8_t name##_Rx_Buffer[rx_size]; \
+	static uint8_t name##_Tx_Buffer[tx_size]; \
+	static usart_driver_t name = { 0, name##_Rx_Buffer, name##_Tx_Buffer, (rx_size) - 1, (tx_size) - 1, 0, 0, 0, 0, { 0, 0, 0, 0, 0 } }
+
+void usart_driver_init(usart_driver_t *usart, USART_t *hw, uint16_t baud_register, usart_speed_t speed);
+
+bool usart_driver_put_char(usart_driver_t *usart, char c);
+bool usart_driver_write(usart_driver_t *usart, const uint8_t *data, uint8_t length);
+bool usart_driver_put_string(usart_driver_t *usart, const char *str);
+uint8_t usart_driver_tx_free(const usart_driver_t *usart);
+bool usart_driver_tx_done(const usart_driver_t *usart);
+
+bool usart_driver_get_char(usart_driver_t *usart, char *c);
+uint8_t usart_driver_read(usart_driver_t *usart, uint8_t *data, uint8_t max_length);
+uint8_t usart_driver_rx_available(const usart_driver_t *usart);
+
+void usart_driver_get_errors(const usart_driver_t *usart, usart_errors_t *errors);
+void usart_driver_clear_errors(usart_driver_t *usart);
+
+void usart_driver_rx_isr(usart_driver_t *usart);
+bool usart_driver_rx_read(usart_driver_t *usart, uint8_t *data);
+void usart_driver_dre_isr(usart_driver_t *usart);
+
+#endif /* USART_DRIVER_H_ */
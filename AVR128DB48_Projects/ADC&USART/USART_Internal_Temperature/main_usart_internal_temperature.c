@@ -8,21 +8,30 @@
  */
 
 #define F_CPU 4000000UL                                                                 // CPU Frequency 4MHz
-#define BAUD_RATE 9600                                                                  // UART Baud Rate
-#define ONE_SECOND_MS 1000                                                              // 1000ms = 1 Second
+#define BAUD_RATE 115200UL                                                              // UART Baud Rate (0.08% error at 4MHz)
+#define SAMPLE_RATE_HZ 1                                                                // Temperature conversions per second
 
 #include <avr/io.h>
 #include <avr/interrupt.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdbool.h>
+#include "ADC_Trigger.h"
+#include "ADC_Driver.h"
+#include "Timestamp.h"
+#include "RTC_Clock.h"
+#include "Fixed_Point.h"
+#include "Filter.h"
+#include "USART_Driver.h"
 
-// **Global flags & data
-// Timer Flags
-volatile uint16_t G_Time_Remaining_ms = ONE_SECOND_MS;
-volatile bool G_Start_Adc_Flag = false;												// Flag to trigger a new measurement
-volatile uint32_t G_Total_Time_s = 0;
+// Temperature sensor: 16 samples accumulated in hardware and averaged (>> 4), still a 12-bit value for the calibration formula
+static const adc_channel_t Temp_Channel = {
+    ADC_MUXPOS_TEMPSENSE_gc, VREF_REFSEL_1V024_gc, ADC_RESSEL_12BIT_gc, ADC_SAMPNUM_ACC16_gc,
+    31,                                                                             // High impedance sensor needs a long sampling time
+    4
+};
 
+// **Global flags & data
 // ADC Data
 volatile uint16_t G_Adc_Raw_Result = 0;												// Stores the result from ISR
 volatile bool G_New_Data_Available = false;											// Flag to tell main "Result is ready"
@@ -30,98 +39,50 @@ volatile bool G_New_Data_Available = false;											// Flag to tell main "Resu
 
 // Factory Calibration Value
 uint16_t Sigrow_ADC_Cal_Val = 0;
+// K = (ADC * 358) / Sigrow_ADC_Cal_Val, the reciprocal of the calibration value is computed once at startup
+fixed_scale_t Temp_K_Scale;
+bool Temp_K_Scale_Valid = false;
+
+// Smoothing of the 1 Hz readings: EMA with alpha = 1/4 (time constant ~4s)
+filter_ema_t Temp_Ema;
 
-// UART Variables
-volatile const char *Tx_Ptr = NULL;
-volatile bool Tx_Busy = false;
+// USART3: one log line (< 80 characters) fits into the TX ring, the RX ring is unused
+USART_DRIVER_DEFINE(Serial, 8, 128);
+USART_BAUD_CHECK(BAUD_RATE, USART_NORMAL_SPEED);
 
 // **Initialization functions
 void ADC0_init(void)
 {
-    // Vref: Internal 1.024V
-    VREF.ADC0REF = VREF_REFSEL_1V024_gc;
-    
     // Prescaler: 4MHz / 4 = 1MHz ADC Clock
-    ADC0.CTRLC = ADC_PRESC_DIV4_gc;
-    
-    // MUX: Select Internal Temperature Sensor
-    ADC0.MUXPOS = ADC_MUXPOS_TEMPSENSE_gc;
-    
-    // Sample Control (High Impedance Sensor needs longer time)
-    ADC0.SAMPCTRL = 31;
-    
-    // Init Delay
-    ADC0.CTRLD = ADC_INITDLY_DLY32_gc;
-    
     // Enable Interrupts for "Result Ready"
     // This allows us to remove the blocking while loop!
-    ADC0.INTCTRL = ADC_RESRDY_bm;
+    adc_driver_init(ADC_PRESC_DIV4_gc, true);
     
-    // Enable ADC (12-bit)
-    ADC0.CTRLA = ADC_ENABLE_bm | ADC_RESSEL_12BIT_gc;
-}
-
-void Timer_init(void)
-{
-    // TCB0 setup for 1ms interrupt
-    TCB0.CCMP = 3999;
-    TCB0.CTRLA = TCB_CLKSEL_DIV1_gc | TCB_ENABLE_bm;
-    TCB0.CTRLB = TCB_CNTMODE_INT_gc;
-    TCB0.INTCTRL = TCB_CAPT_bm;
+    // Vref: Internal 1.024V, MUX: Internal Temperature Sensor, 12-bit, 16 accumulated samples
+    adc_driver_select(&Temp_Channel);
 }
 
 void USART3_init(void)
 {
-    USART3.BAUD = (uint16_t)((float)(4UL * F_CPU) / BAUD_RATE);
-    PORTB.DIR |= PIN0_bm;															// TX Pin Output
-    USART3.CTRLB = USART_TXEN_bm;
+    PORTB.DIRSET = PIN0_bm;															// TX Pin Output (PB0)
+    usart_driver_init(&Serial, &USART3, USART_BAUD_VALUE(BAUD_RATE), USART_NORMAL_SPEED);
 }
 // End of initialization functions**
 
-void USART3_send_string(const char *str)
-{
-    if (Tx_Busy) return;
-    Tx_Ptr = str;
-    Tx_Busy = true;
-    USART3.CTRLA |= USART_DREIE_bm;
-}
-
 // **Interrupt Service Routines
-/*
- * Timer TCB0 Interrupt - Fires every 1ms
- * Logic: Handles the countdown. When 1s hits, it tells Main to START the ADC.
- */
-ISR(TCB0_INT_vect)
-{
-    TCB0.INTFLAGS = TCB_CAPT_bm;
-    
-    if (G_Time_Remaining_ms > 0)
-    {
-        G_Time_Remaining_ms--;
-    }
-    else
-    {
-        // 1 Second has passed!
-        G_Time_Remaining_ms = ONE_SECOND_MS;
-        G_Total_Time_s++;
-        
-        // Signal Main to START conversion.
-        // We don't start it here to keep ISR short, 
-        // and to avoid accessing ADC registers from two ISRs if we ever expanded logic.
-        G_Start_Adc_Flag = true; 
-    }
-}
-
 /*
  * ADC Result Ready Interrupt
- * Logic: Fires automatically when the ADC finishes measuring (~35us after start).
+ * Logic: Fires automatically when the ADC finishes measuring (~35us after the RTC event).
  * This replaces the blocking "while" loop.
  */
 ISR(ADC0_RESRDY_vect)
 {
+    // Measure the time since the previous result (sampling jitter)
+    adc_trigger_mark();
+    
     // Read the result immediately
     // Reading .RES automatically clears the Interrupt Flag
-    G_Adc_Raw_Result = ADC0.RES;
+    G_Adc_Raw_Result = adc_driver_result(&Temp_Channel, ADC0.RES);
     
     // Tell Main loop: "I have data for you to calculate"
     G_New_Data_Available = true;
@@ -133,61 +94,64 @@ ISR(ADC0_RESRDY_vect)
  */
 ISR(USART3_DRE_vect)
 {
-    if (Tx_Ptr != NULL && *Tx_Ptr != '\0')
-    {
-        USART3.TXDATAL = *Tx_Ptr;
-        Tx_Ptr++;
-    }
-    else
-    {
-        USART3.CTRLA &= ~USART_DREIE_bm;
-        Tx_Busy = false;
-        Tx_Ptr = NULL;
-    }
+    usart_driver_dre_isr(&Serial);
+}
+
+/*
+ * UART Receive Complete Interrupt (nothing is received, errors are still counted)
+ */
+ISR(USART3_RXC_vect)
+{
+    usart_driver_rx_isr(&Serial);
 }
 
 int main(void)
 {
-    char Msg_Buffer[64];
+    char Msg_Buffer[80];
     uint32_t Temp_K = 0;
     int32_t Temp_C = 0;
+    adc_jitter_t Jitter;
     
     USART3_init();
-    Timer_init();
+    timestamp_init();
+    
+    // Running time: the RTC counter overflows once per second (1 interrupt per second instead of 1000)
+    rtc_clock_init(true);
     ADC0_init();
     
+    // The same 1Hz RTC overflow starts every conversion via the Event System:
+    // the sample rate no longer depends on how busy main is.
+    adc_trigger_init(ADC_TRIGGER_RTC, SAMPLE_RATE_HZ);
+    
     // Read Calibration Data
     Sigrow_ADC_Cal_Val = SIGROW.TEMPSENSE0 | (SIGROW.TEMPSENSE1 << 8);
+    Temp_K_Scale_Valid = fixed_scale_init(&Temp_K_Scale, 358, Sigrow_ADC_Cal_Val, 4095);      // false for a missing (0) value
+    filter_ema_init(&Temp_Ema, 2);
     
     sei();
     
     while (1) 
     {
-        // EVENT 1: Time to Measure
-        if (G_Start_Adc_Flag)
-        {
-            G_Start_Adc_Flag = false;
-            
-            // FIRE AND FORGET!
-            ADC0.COMMAND = ADC_STCONV_bm;
-        }
-        
-        // EVENT 2: Measurement Finished
+        // Measurement Finished (conversions are started by the RTC event)
         if (G_New_Data_Available)
         {
             G_New_Data_Available = false;
             
-            if (Sigrow_ADC_Cal_Val != 0)
+            if (Temp_K_Scale_Valid)
             {
-                Temp_K = ((uint32_t)G_Adc_Raw_Result * 358) / Sigrow_ADC_Cal_Val;
+                Temp_K = fixed_scale(&Temp_K_Scale, filter_ema_update(&Temp_Ema, G_Adc_Raw_Result));
                 Temp_C = (int32_t)Temp_K - 273;
             }
             
-            // Send Message (Only if UART is free)
-            if (!Tx_Busy)
+            // Send Message (Only if the whole line fits, the ring copies it so Msg_Buffer can be reused)
+            if (usart_driver_tx_free(&Serial) >= sizeof(Msg_Buffer))
             {
-                sprintf(Msg_Buffer, "T: %lu s | %lu K | %ld C\r\n", G_Total_Time_s, Temp_K, Temp_C);
-                USART3_send_string(Msg_Buffer);
+                // Jitter = longest - shortest time between two results so far (us)
+                adc_trigger_get_jitter(&Jitter);
+                uint32_t Jitter_us = (Jitter.count > 0) ? (Jitter.period_max - Jitter.period_min) / TIMESTAMP_CYCLES_PER_US : 0;
+                
+                sprintf(Msg_Buffer, "T: %lu s | %lu K | %ld C | jit %lu us\r\n", rtc_clock_seconds(), Temp_K, Temp_C, Jitter_us);
+                usart_driver_put_string(&Serial, Msg_Buffer);
             }
         }
     }
@@ -0,0 +1,290 @@
+/*
+ * Command_Line.c
+ *
+ * Ownership of the line buffers: the RXC ISR owns Lines[Line_Write], main
+ * owns Lines[Line_Read] while Line_Pending is set (8-bit flag, no critical
+ * section needed).
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <string.h>
+#include "Command_Line.h"
+
+// VARIABLES //
+static char Lines[2][COMMAND_LINE_SIZE];
+static uint8_t Line_Write = 0;						// Buffer the ISR fills
+static uint8_t Line_Read = 0;						// Buffer main reads, valid while Line_Pending
+static uint8_t Line_Length = 0;
+static bool Line_Discard = false;					// Current line is too long, skip up to its end
+static volatile bool Line_Pending = false;
+
+static volatile command_line_stats_t Stats;
+
+// Messages for command_line_status_t
+static const char *const Status_Texts[] = {
+	"OK", "", "ERR unknown command", "ERR bad arguments", "ERR failed"
+};
+
+// PRIVATE FUNCTIONS //
+
+static bool is_space(char c)
+{
+	return c == ' ' || c == '\t';
+}
+
+// PUBLIC FUNCTIONS //
+
+void command_line_init(void)
+{
+	Line_Write = 0;
+	Line_Length = 0;
+	Line_Discard = false;
+	Line_Pending = false;
+}
+
+/*
+	Call from the RXC ISR for every received character.
+*/
+void command_line_rx_char(uint8_t c)
+{
+	if (c == '\r' || c == '\n')
+	{
+		if (Line_Discard)
+		{
+			Line_Discard = false;
+			Stats.too_long++;
+		}
+		else if (Line_Length == 0)
+		{
+			;												// Empty line or the LF of CR LF
+		}
+		else if (Line_Pending)
+		{
+			Stats.dropped++;
+		}
+		else
+		{
+			Lines[Line_Write][Line_Length] = '\0';
+			Line_Read = Line_Write;
+			Line_Write ^= 1;
+			Stats.lines++;
+			Line_Pending = true;
+		}
+
+		Line_Length = 0;
+		return;
+	}
+
+	if (c == '\b' || c == 0x7F)								// Backspace or DEL
+	{
+		if (Line_Length > 0)
+		{
+			Line_Length--;
+		}
+		return;
+	}
+
+	if (Line_Discard)
+		return;
+
+	if (Line_Length >= COMMAND_LINE_SIZE - 1)
+	{
+		Line_Discard = true;
+		return;
+	}
+
+	Lines[Line_Write][Line_Length++] = (char)c;
+}
+
+/*
+	@return The oldest complete line ('\0' terminated, without CR/LF), NULL if
+	        there is none. Main owns it (and may change it) until command_line_release().
+*/
+char *command_line_receive(void)
+{
+	if (!Line_Pending)
+		return NULL;
+
+	return Lines[Line_Read];
+}
+
+/*
+	Gives the line buffer back to the ISR.
+*/
+void command_line_release(void)
+{
+	Line_Pending = false;
+}
+
+/*
+	Splits line at spaces and tabs in place: every separator after a word
+	becomes '\0', argv[i] points to the words.
+
+	@return Number of words, max_args + 1 if there are more than max_args
+*/
+uint8_t command_line_split(char *line, char *argv[], uint8_t max_args)
+{
+	uint8_t argc = 0;
+
+	while (1)
+	{
+		while (is_space(*line))
+		{
+			line++;
+		}
+
+		if (*line == '\0')
+			return argc;
+
+		if (argc == max_args)
+			return max_args + 1;
+
+		argv[argc++] = line;
+
+		while (*line != '\0' && !is_space(*line))
+		{
+			line++;
+		}
+
+		if (*line == '\0')
+			return argc;
+
+		*line++ = '\0';
+	}
+}
+
+/*
+	Copies entry index of a COMMAND_LINE_FLASH table to RAM.
+*/
+void command_line_get_entry(const command_line_entry_t *table, uint8_t index, command_line_entry_t *entry)
+{
+#if defined(__AVR_HAVE_FLMAP__) && defined(__AVR_RODATA_IN_RAM__) && (__AVR_RODATA_IN_RAM__ == 0)
+	*entry = table[index];
+#else
+	memcpy_P(entry, &table[index], sizeof(*entry));
+#endif
+}
+
+/*
+	Splits line and calls the handler of its first word.
+
+	@param table COMMAND_LINE_FLASH table
+	@param count Number of entries
+	@param line  From command_line_receive(), changed by the split
+	@return Status of the handler, or why no handler was called
+*/
+command_line_status_t command_line_dispatch(const command_line_entry_t *table, uint8_t count, char *line)
+{
+	char *argv[COMMAND_LINE_MAX_ARGS];
+	uint8_t argc = command_line_split(line, argv, COMMAND_LINE_MAX_ARGS);
+
+	if (argc == 0)
+		return COMMAND_LINE_EMPTY;
+
+	for (uint8_t i = 0; i < count; i++)
+	{
+		command_line_entry_t entry;
+
+		command_line_get_entry(table, i, &entry);
+
+		if (strcmp(entry.name, argv[0]) != 0)
+			continue;
+
+		if (argc > COMMAND_LINE_MAX_ARGS || argc - 1 < entry.min_args || argc - 1 > entry.max_args)
+			return COMMAND_LINE_BAD_ARGS;
+
+		return entry.handler(argc, argv);
+	}
+
+	return COMMAND_LINE_UNKNOWN;
+}
+
+/*
+	@return Reply text for a status ("" for an empty line)
+*/
+const char *command_line_status_text(command_line_status_t status)
+{
+	if (status > COMMAND_LINE_FAILED)
+		return "";
+
+	return Status_Texts[status];
+}
+
+/*
+	Parses 1 ... 8 hex digits (0-9, a-f, A-F), nothing else.
+
+	@return false if text is empty, too long or has another character (value unchanged)
+*/
+bool command_line_parse_hex(const char *text, uint32_t *value)
+{
+	uint32_t result = 0;
+	uint8_t digits = 0;
+
+	while (*text != '\0')
+	{
+		uint8_t c = (uint8_t)*text++;
+		uint8_t nibble = c - '0';
+
+		if (nibble > 9)
+		{
+			nibble = (uint8_t)((c | 0x20) - 'a');				// | 0x20: upper to lower case
+			if (nibble > 5)
+				return false;
+			nibble += 10;
+		}
+
+		if (++digits > 8)
+			return false;
+
+		result = (result << 4) | nibble;
+	}
+
+	if (digits == 0)
+		return false;
+
+	*value = result;
+	return true;
+}
+
+/*
+	Parses a decimal number 0 ... 65535 (digits only).
+
+	@return false if text is empty, has another character or overflows (value unchanged)
+*/
+bool command_line_parse_u16(const char *text, uint16_t *value)
+{
+	uint16_t result = 0;
+
+	if (*text == '\0')
+		return false;
+
+	while (*text != '\0')
+	{
+		uint8_t digit = (uint8_t)(*text++ - '0');
+
+		if (digit > 9)
+			return false;
+
+		if (result > 6553 || (result == 6553 && digit > 5))
+			return false;
+
+		result = (result << 3) + (result << 1) + digit;			// * 10 without a multiplication
+	}
+
+	*value = result;
+	return true;
+}
+
+/*
+	Consistent copy of the counters.
+*/
+void command_line_get_stats(command_line_stats_t *stats)
+{
+	uint8_t sreg = SREG;
+	cli();
+	stats->lines = Stats.lines;
+	stats->too_long = Stats.too_long;
+	stats->dropped = Stats.dropped;
+	SREG = sreg;
+}
@@ -0,0 +1,93 @@
+/*
+ * Command_Line.h
+ *
+ * Text commands over a serial line ("rgb FF8000", "servo 1500", "stats").
+ *
+ * The RXC ISR only collects characters into one of two line buffers
+ * (command_line_rx_char(), a few compares per byte). CR or LF hands the
+ * line to main and the ISR goes on in the other buffer. If main still holds
+ * the previous line the new one is dropped and counted, so is a line longer
+ * than COMMAND_LINE_SIZE - 1. Backspace removes the last character.
+ *
+ * Main splits the line in place (the spaces become '\0', argv points into
+ * the buffer) and looks up the first word in a command table in flash. The
+ * table checks the number of arguments, the handler parses them with
+ * command_line_parse_hex() / command_line_parse_u16() (no strtol(), no
+ * library calls, only shifts and adds).
+ *
+ * Flash: like Lookup_Table, the table stays in the mapped flash with
+ * avr-gcc 14+ (__AVR_HAVE_FLMAP__), older toolchains put it into program
+ * memory (PROGMEM) and the dispatcher copies one entry at a time. Tables must
+ * be declared with COMMAND_LINE_FLASH and read with command_line_get_entry().
+ *
+ * Usage:
+ *  static const command_line_entry_t Commands[] COMMAND_LINE_FLASH = {
+ *      { "rgb", 1, 1, cmd_rgb },                       // name, min and max number of arguments, handler
+ *  };
+ *  ISR(USART3_RXC_vect) { uint8_t c; if (usart_driver_rx_read(&Serial, &c)) command_line_rx_char(c); }
+ *  main: char *line = command_line_receive();
+ *        if (line) { status = command_line_dispatch(Commands, 1, line); command_line_release(); }
+ */
+
+#ifndef COMMAND_LINE_H_
+#define COMMAND_LINE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#if defined(__AVR_HAVE_FLMAP__) && defined(__AVR_RODATA_IN_RAM__) && (__AVR_RODATA_IN_RAM__ == 0)
+#define COMMAND_LINE_FLASH									// .rodata already stays in the mapped flash
+#else
+#include <avr/pgmspace.h>
+#define COMMAND_LINE_FLASH PROGMEM
+#endif
+
+#ifndef COMMAND_LINE_SIZE
+#define COMMAND_LINE_SIZE 32								// Per line buffer, including the '\0'
+#endif
+
+#define COMMAND_LINE_MAX_ARGS 4								// Command name and up to 3 arguments
+#define COMMAND_LINE_NAME_SIZE 8
+
+typedef enum {
+	COMMAND_LINE_OK,
+	COMMAND_LINE_EMPTY,										// Only spaces
+	COMMAND_LINE_UNKNOWN,									// No command with this name
+	COMMAND_LINE_BAD_ARGS,									// Wrong number of arguments or a value the handler rejected
+	COMMAND_LINE_FAILED										// Handler could not execute it
+} command_line_status_t;
+
+// argv[0] is the command name, argv[1 ... argc - 1] the arguments
+typedef command_line_status_t (*command_line_handler_t)(uint8_t argc, char *argv[]);
+
+typedef struct {
+	char name[COMMAND_LINE_NAME_SIZE];						// Up to 7 characters, in the entry so it is in flash with the table
+	uint8_t min_args;
+	uint8_t max_args;
+	command_line_handler_t handler;
+} command_line_entry_t;
+
+typedef struct {
+	uint16_t lines;											// Lines handed to main
+	uint16_t too_long;										// Lines longer than COMMAND_LINE_SIZE - 1
+	uint16_t dropped;										// Lines lost because main still held the previous one
+} command_line_stats_t;
+
+void command_line_init(void);
+void command_line_rx_char(uint8_t c);
+
+char *command_line_receive(void);
+void command_line_release(void);
+
+uint8_t command_line_split(char *line, char *argv[], uint8_t max_args);
+command_line_status_t command_line_dispatch(const command_line_entry_t *table, uint8_t count, char *line);
+void command_line_get_entry(const command_line_entry_t *table, uint8_t index, command_line_entry_t *entry);
+const char *command_line_status_text(command_line_status_t status);
+
+bool command_line_parse_hex(const char *text, uint32_t *value);
+bool command_line_parse_u16(const char *text, uint16_t *value);
+
+void command_line_get_stats(command_line_stats_t *stats);
+
+#endif /* COMMAND_LINE_H_ */
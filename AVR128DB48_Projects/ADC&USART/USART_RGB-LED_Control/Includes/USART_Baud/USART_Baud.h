@@ -0,0 +1,66 @@
+/*
+ * USART_Baud.h
+ *
+ * Baud rate arithmetic for the USARTs, shared by USART_Driver, Debug_USART and
+ * the projects that set up a USART directly (ADC_Streaming), so all of them
+ * compute the BAUD register and check the rate error the same way.
+ *
+ * The BAUD register holds 64 * F_CPU / (samples per bit * baud), its low
+ * 6 bits are a fraction, so the rounding error is small even for high rates.
+ * In double speed mode (CLK2X, 8 instead of 16 samples per bit) the highest
+ * rate is F_CPU / 8 (500000 at 4MHz, 1M needs 8MHz), in normal mode
+ * F_CPU / 16. All values are computed by the compiler, USART_BAUD_CHECK()
+ * stops the build if the register is out of range or the rate error is above
+ * the recommended receiver tolerance.
+ *
+ * Usage:
+ *  USART_BAUD_CHECK(115200, USART_NORMAL_SPEED);         // At file scope
+ *  USART3.BAUD = USART_BAUD_VALUE(115200);
+ *  or with the mode chosen by the compiler:
+ *  USART3.BAUD = (uint16_t)USART_BAUD_REGISTER(baud, USART_BAUD_SPEED(baud));
+ */
+
+#ifndef USART_BAUD_H_
+#define USART_BAUD_H_
+
+#include <stdint.h>
+
+#ifndef F_CPU
+#define F_CPU 4000000UL
+#endif
+
+// Samples per bit
+typedef enum {
+	USART_NORMAL_SPEED = 16,
+	USART_DOUBLE_SPEED = 8				// CLK2X: twice the rate for the same BAUD register, less tolerance
+} usart_speed_t;
+
+// BAUD register: 64 * F_CPU / (speed * baud), rounded, integer math only
+#define USART_BAUD_REGISTER(baud, speed) ((64ULL * F_CPU / (speed) + (baud) / 2) / (baud))
+#define USART_BAUD_VALUE(baud) ((uint16_t)USART_BAUD_REGISTER(baud, USART_NORMAL_SPEED))
+#define USART_BAUD_VALUE_2X(baud) ((uint16_t)USART_BAUD_REGISTER(baud, USART_DOUBLE_SPEED))
+
+// Normal speed while its BAUD register stays >= 64 (up to F_CPU / 16), double speed above
+#define USART_BAUD_SPEED(baud) \
+	(USART_BAUD_REGISTER(baud, USART_NORMAL_SPEED) >= 64 ? USART_NORMAL_SPEED : USART_DOUBLE_SPEED)
+
+// Baud rate the hardware really generates
+#define USART_BAUD_ACTUAL(baud, speed) \
+	(64ULL * F_CPU / (speed) / (USART_BAUD_REGISTER(baud, speed) ? USART_BAUD_REGISTER(baud, speed) : 1))
+
+// Rate error in 0.01% (e.g. 8 = 0.08%), rounded
+#define USART_BAUD_ERROR_X100(baud, speed) \
+	(((USART_BAUD_ACTUAL(baud, speed) > (baud) ? USART_BAUD_ACTUAL(baud, speed) - (baud) \
+		: (baud) - USART_BAUD_ACTUAL(baud, speed)) * 10000ULL + (baud) / 2) / (baud))
+
+// Recommended max. receiver error for 8 data bits (data sheet): 2.0% normal, 1.5% double speed
+#define USART_BAUD_MAX_ERROR_X100(speed) ((speed) == USART_DOUBLE_SPEED ? 150 : 200)
+
+// Compile time check of a baud rate for F_CPU (at file scope)
+#define USART_BAUD_CHECK(baud, speed) \
+	_Static_assert(USART_BAUD_REGISTER(baud, speed) >= 64 && USART_BAUD_REGISTER(baud, speed) <= 0xFFFF, \
+		"Baud rate out of range for F_CPU (BAUD register 64 ... 65535), try the other speed mode"); \
+	_Static_assert(USART_BAUD_ERROR_X100(baud, speed) <= USART_BAUD_MAX_ERROR_X100(speed), \
+		"Baud rate error too high for F_CPU")
+
+#endif /* USART_BAUD_H_ */
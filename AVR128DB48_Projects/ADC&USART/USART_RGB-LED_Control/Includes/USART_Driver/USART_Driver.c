@@ -0,0 +1,275 @@
+/*
+ * USART_Driver.c
+ *
+ * Single producer / single consumer rings, one per direction:
+ *  RX: the RXC ISR writes rx_head, main writes rx_tail
+ *  TX: main writes tx_head, the DRE ISR writes tx_tail
+ * The number of bytes in a ring is (head - tail) in 8-bit arithmetic.
+ * A slot is filled before its head index is published.
+ *
+ * The ring buffers are not volatile, so in main a compiler barrier keeps the
+ * buffer accesses in front of the index store that hands the slots over (as
+ * in Event_Queue). The ISRs need none: main cannot run before they return.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "USART_Driver.h"
+
+// Memory accesses are not moved across it, no instruction is generated
+#define USART_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+// PUBLIC FUNCTIONS //
+
+/*
+	Sets up the USART for 8N1 with receiver, transmitter and RX interrupt.
+	Pins (direction, PORTMUX route) are set by the caller. Call before sei().
+
+	@param usart         Instance from USART_DRIVER_DEFINE()
+	@param hw            Peripheral, e.g. &USART3
+	@param baud_register Value for the BAUD register (USART_BAUD_VALUE() or USART_BAUD_VALUE_2X())
+	@param speed         Sampling mode the register was computed for
+*/
+void usart_driver_init(usart_driver_t *usart, USART_t *hw, uint16_t baud_register, usart_speed_t speed)
+{
+	usart->hw = hw;
+	usart->rx_head = 0;
+	usart->rx_tail = 0;
+	usart->tx_head = 0;
+	usart->tx_tail = 0;
+	usart_driver_clear_errors(usart);
+
+	hw->CTRLB = 0;
+	hw->BAUD = baud_register;
+	hw->CTRLC = USART_CMODE_ASYNCHRONOUS_gc | USART_CHSIZE_8BIT_gc | USART_PMODE_DISABLED_gc | USART_SBMODE_1BIT_gc;
+	hw->CTRLA = USART_RXCIE_bm;										// DREIE only while there is something to send
+	hw->CTRLB = USART_RXEN_bm | USART_TXEN_bm
+		| ((speed == USART_DOUBLE_SPEED) ? USART_RXMODE_CLK2X_gc : USART_RXMODE_NORMAL_gc);
+}
+
+/*
+	Queues one byte.
+
+	@return false if the TX ring is full (counted as rejected)
+*/
+bool usart_driver_put_char(usart_driver_t *usart, char c)
+{
+	return usart_driver_write(usart, (const uint8_t *)&c, 1);
+}
+
+/*
+	Queues all bytes or none, never waits.
+
+	@return false if the TX ring has no room for all of them (counted as rejected)
+*/
+bool usart_driver_write(usart_driver_t *usart, const uint8_t *data, uint8_t length)
+{
+	if (length > usart_driver_tx_free(usart))
+	{
+		uint8_t sreg = SREG;
+		cli();
+		usart->errors.tx_rejected += length;
+		SREG = sreg;
+		return false;
+	}
+
+	uint8_t head = usart->tx_head;
+
+	for (uint8_t i = 0; i < length; i++)
+	{
+		usart->tx_buffer[head & usart->tx_mask] = data[i];
+		head++;
+	}
+
+	USART_BARRIER();
+	usart->tx_head = head;										// Publish after the bytes are in the ring
+	usart->hw->STATUS = USART_TXCIF_bm;							// usart_driver_tx_done() waits for the new bytes
+	usart->hw->CTRLA |= USART_DREIE_bm;							// The DRE ISR sends, it switches itself off at the end
+	return true;
+}
+
+/*
+	Queues a null-terminated string (without the terminator), all or nothing.
+
+	@return false if it doesn't fit into the TX ring (counted as rejected)
+*/
+bool usart_driver_put_string(usart_driver_t *usart, const char *str)
+{
+	uint16_t length = 0;
+
+	while (str[length] != '\0')
+	{
+		length++;
+	}
+
+	if (length > usart->tx_mask + 1U)
+	{
+		uint8_t sreg = SREG;
+		cli();
+		usart->errors.tx_rejected += length;
+		SREG = sreg;
+		return false;
+	}
+
+	return usart_driver_write(usart, (const uint8_t *)str, (uint8_t)length);
+}
+
+/*
+	@return Number of bytes that can be queued right now
+*/
+uint8_t usart_driver_tx_free(const usart_driver_t *usart)
+{
+	return (uint8_t)(usart->tx_mask + 1 - (uint8_t)(usart->tx_head - usart->tx_tail));
+}
+
+/*
+	@return true when every queued byte has left the shift register (e.g. before sleeping)
+*/
+bool usart_driver_tx_done(const usart_driver_t *usart)
+{
+	return usart->tx_head == usart->tx_tail && (usart->hw->STATUS & USART_TXCIF_bm);
+}
+
+/*
+	Takes the oldest received byte.
+
+	@return false if nothing was received
+*/
+bool usart_driver_get_char(usart_driver_t *usart, char *c)
+{
+	uint8_t tail = usart->rx_tail;
+
+	if (tail == usart->rx_head)
+		return false;
+
+	*c = (char)usart->rx_buffer[tail & usart->rx_mask];
+
+	USART_BARRIER();
+	usart->rx_tail = tail + 1;									// Free the slot after reading it
+	return true;
+}
+
+/*
+	Takes up to max_length received bytes.
+
+	@return Number of bytes copied to data
+*/
+uint8_t usart_driver_read(usart_driver_t *usart, uint8_t *data, uint8_t max_length)
+{
+	uint8_t count = 0;
+	char c;
+
+	while (count < max_length && usart_driver_get_char(usart, &c))
+	{
+		data[count++] = (uint8_t)c;
+	}
+
+	return count;
+}
+
+/*
+	@return Number of received bytes waiting in the RX ring
+*/
+uint8_t usart_driver_rx_available(const usart_driver_t *usart)
+{
+	return (uint8_t)(usart->rx_head - usart->rx_tail);
+}
+
+/*
+	Consistent copy of the error counters.
+*/
+void usart_driver_get_errors(const usart_driver_t *usart, usart_errors_t *errors)
+{
+	uint8_t sreg = SREG;
+	cli();
+	errors->rx_overflows = usart->errors.rx_overflows;
+	errors->hw_overruns = usart->errors.hw_overruns;
+	errors->frame_errors = usart->errors.frame_errors;
+	errors->parity_errors = usart->errors.parity_errors;
+	errors->tx_rejected = usart->errors.tx_rejected;
+	SREG = sreg;
+}
+
+void usart_driver_clear_errors(usart_driver_t *usart)
+{
+	uint8_t sreg = SREG;
+	cli();
+	usart->errors.rx_overflows = 0;
+	usart->errors.hw_overruns = 0;
+	usart->errors.frame_errors = 0;
+	usart->errors.parity_errors = 0;
+	usart->errors.tx_rejected = 0;
+	SREG = sreg;
+}
+
+/*
+	Call from USARTn_RXC_vect instead of usart_driver_rx_isr() if the ISR uses
+	the byte itself (the RX ring stays empty). Errors are counted the same way.
+
+	@param data Destination for the received byte
+	@return false if the byte has a framing or parity error (dropped)
+*/
+bool usart_driver_rx_read(usart_driver_t *usart, uint8_t *data)
+{
+	uint8_t status = usart->hw->RXDATAH;						// Error flags of the byte in RXDATAL, read first
+	*data = usart->hw->RXDATAL;									// Reading the data clears RXCIF
+
+	if (status & USART_BUFOVF_bm)
+	{
+		usart->errors.hw_overruns++;							// Earlier bytes were lost, this one is fine
+	}
+
+	if (status & USART_FERR_bm)
+	{
+		usart->errors.frame_errors++;
+		return false;
+	}
+
+	if (status & USART_PERR_bm)
+	{
+		usart->errors.parity_errors++;
+		return false;
+	}
+
+	return true;
+}
+
+/*
+	Call from USARTn_RXC_vect. Stores the received byte or counts why it was lost.
+*/
+void usart_driver_rx_isr(usart_driver_t *usart)
+{
+	uint8_t data;
+
+	if (!usart_driver_rx_read(usart, &data))
+		return;
+
+	uint8_t head = usart->rx_head;
+
+	if ((uint8_t)(head - usart->rx_tail) > usart->rx_mask)
+	{
+		usart->errors.rx_overflows++;
+		return;
+	}
+
+	usart->rx_buffer[head & usart->rx_mask] = data;
+	usart->rx_head = head + 1;
+}
+
+/*
+	Call from USARTn_DRE_vect. Sends the next byte, disables the interrupt when the ring is empty.
+*/
+void usart_driver_dre_isr(usart_driver_t *usart)
+{
+	uint8_t tail = usart->tx_tail;
+
+	if (tail != usart->tx_head)
+	{
+		usart->hw->TXDATAL = usart->tx_buffer[tail & usart->tx_mask];
+		usart->tx_tail = tail + 1;
+	}
+	else
+	{
+		usart->hw->CTRLA &= ~USART_DREIE_bm;
+	}
+}
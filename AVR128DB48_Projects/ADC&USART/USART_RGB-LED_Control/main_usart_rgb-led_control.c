@@ -7,16 +7,20 @@
  * Author : mami4
  */ 
 #define F_CPU 4000000UL																// 4MHz
-#define BAUD_RATE 9600
+#define BAUD_RATE 115200UL
+#define SERVO_MIN_US 500															// Servo pulse limits
+#define SERVO_MAX_US 2500
 
 #include <avr/io.h>
 #include <avr/interrupt.h>
-#include <stdlib.h>																	// For strtol()
-#include <ctype.h>																	// For isxdigit()
+#include <stdio.h>																	// For the stats reply
+#include <string.h>
+#include "USART_Driver.h"
+#include "Command_Line.h"
 
-// Global variables
-volatile char Rx_Buffer[8];															// Buffer to hold incoming Hex String (RRGGBB + null terminator)
-volatile uint8_t Rx_Index = 0;
+// USART3: received characters go straight to Command_Line, the TX ring holds the replies
+USART_DRIVER_DEFINE(Serial, 2, 128);
+USART_BAUD_CHECK(BAUD_RATE, USART_NORMAL_SPEED);
 
 // RGB led controller
 void set_rgb(uint8_t r, uint8_t g, uint8_t b)
@@ -26,29 +30,90 @@ void set_rgb(uint8_t r, uint8_t g, uint8_t b)
 	TCA0.SINGLE.CMP2 = b;
 }
 
-void Process_Color_Command(void)
+/*
+ * Servo on PC4: TCA1 WO0, 1MHz timer clock, 20ms period, the compare value is the pulse in us.
+ */
+void TCA1_init(void)
+{
+	PORTMUX.TCAROUTEA = (PORTMUX.TCAROUTEA & ~PORTMUX_TCA1_gm) | PORTMUX_TCA1_PORTC_gc;
+	PORTC.DIRSET = PIN4_bm;
+	
+	TCA1.SINGLE.CTRLA = 0;
+	TCA1.SINGLE.CTRLESET = TCA_SINGLE_CMD_RESET_gc;
+	TCA1.SINGLE.PER = 19999;														// 20ms
+	TCA1.SINGLE.CMP0 = 1500;														// Centre
+	TCA1.SINGLE.CTRLB = TCA_SINGLE_CMP0EN_bm | TCA_SINGLE_WGMODE_SINGLESLOPE_gc;
+	TCA1.SINGLE.CTRLA = TCA_SINGLE_CLKSEL_DIV4_gc | TCA_SINGLE_ENABLE_bm;
+}
+
+// Command handlers, argv[0] is the command name
+static command_line_status_t cmd_rgb(uint8_t argc, char *argv[]);
+static command_line_status_t cmd_servo(uint8_t argc, char *argv[]);
+static command_line_status_t cmd_stats(uint8_t argc, char *argv[]);
+static command_line_status_t cmd_help(uint8_t argc, char *argv[]);
+
+// Command table in flash: name, min and max number of arguments, handler
+static const command_line_entry_t Commands[] COMMAND_LINE_FLASH = {
+	{ "rgb", 1, 1, cmd_rgb },														// rgb RRGGBB
+	{ "servo", 1, 1, cmd_servo },													// servo 500 ... 2500 (us)
+	{ "stats", 0, 0, cmd_stats },
+	{ "help", 0, 0, cmd_help },
+};
+
+#define COMMAND_COUNT (sizeof(Commands) / sizeof(Commands[0]))
+
+static command_line_status_t cmd_rgb(uint8_t argc, char *argv[])
+{
+	uint32_t Color;
+	
+	// Exactly 6 hex digits: RRGGBB
+	if (strlen(argv[1]) != 6 || !command_line_parse_hex(argv[1], &Color))
+		return COMMAND_LINE_BAD_ARGS;
+	
+	// Buffered compare registers: the new colour starts with the next PWM period
+	TCA0.SINGLE.CMP0BUF = (uint8_t)(Color >> 16);
+	TCA0.SINGLE.CMP1BUF = (uint8_t)(Color >> 8);
+	TCA0.SINGLE.CMP2BUF = (uint8_t)Color;
+	return COMMAND_LINE_OK;
+}
+
+static command_line_status_t cmd_servo(uint8_t argc, char *argv[])
+{
+	uint16_t Pulse_Us;
+	
+	if (!command_line_parse_u16(argv[1], &Pulse_Us) || Pulse_Us < SERVO_MIN_US || Pulse_Us > SERVO_MAX_US)
+		return COMMAND_LINE_BAD_ARGS;
+	
+	TCA1.SINGLE.CMP0BUF = Pulse_Us;
+	return COMMAND_LINE_OK;
+}
+
+static command_line_status_t cmd_stats(uint8_t argc, char *argv[])
 {
-	char hex_str[4];
-	long red, green, blue;
-	
-	// Parse Red (First 2 chars)
-	hex_str[0] = Rx_Buffer[0];
-	hex_str[1] = Rx_Buffer[1];
-	hex_str[2] = '\0';
-	red = strtol(hex_str, NULL, 16);
-	
-	// Parse Green (Middle 2 chars)
-	hex_str[0] = Rx_Buffer[2];
-	hex_str[1] = Rx_Buffer[3];
-	green = strtol(hex_str, NULL, 16);
-	
-	// Parse Blue (Last 2 chars)
-	hex_str[0] = Rx_Buffer[4];
-	hex_str[1] = Rx_Buffer[5];
-	blue = strtol(hex_str, NULL, 16);
-	
-	// Update LED
-	set_rgb((uint8_t)red, (uint8_t)green, (uint8_t)blue);
+	char Msg[80];
+	command_line_stats_t Lines;
+	usart_errors_t Errors;
+	
+	command_line_get_stats(&Lines);
+	usart_driver_get_errors(&Serial, &Errors);
+	snprintf(Msg, sizeof(Msg), "lines %u long %u dropped %u | frame %u overrun %u tx rejected %u\r\n",
+		Lines.lines, Lines.too_long, Lines.dropped, Errors.frame_errors, Errors.hw_overruns, Errors.tx_rejected);
+	
+	return usart_driver_put_string(&Serial, Msg) ? COMMAND_LINE_OK : COMMAND_LINE_FAILED;
+}
+
+static command_line_status_t cmd_help(uint8_t argc, char *argv[])
+{
+	command_line_entry_t Entry;
+	
+	for (uint8_t i = 0; i < COMMAND_COUNT; i++)
+	{
+		command_line_get_entry(Commands, i, &Entry);
+		usart_driver_put_string(&Serial, Entry.name);
+		usart_driver_put_string(&Serial, "\r\n");
+	}
+	
+	return COMMAND_LINE_OK;
 }
 
 void TCA0_init(void)
@@ -82,57 +147,54 @@ void USART3_init(void)
 	// Use default pins PB0/PB1
 	PORTMUX.USARTROUTEA = 0;														//PB0=TX, PB1=RX
 	
-	// Baud Rate Calculation
-	USART3.BAUD = (uint16_t)((float)(4UL * F_CPU) / BAUD_RATE);
-	
 	// Set Pins (PB1 = RX)
 	PORTB.DIR &= ~PIN1_bm;															// RX is Input (Default, but good to be explicit)
+	PORTB.DIRSET = PIN0_bm;
 	
-	// Enable Receiver Only and RX Interrupt
-	USART3.CTRLC = USART_CHSIZE_8BIT_gc | USART_PMODE_DISABLED_gc | USART_SBMODE_1BIT_gc;
-	USART3.CTRLB |= USART_RXEN_bm;
-	USART3.CTRLA |= USART_RXCIE_bm;													// enable RX interrupt
+	// 8N1, RX interrupt fills the ring buffer
+	usart_driver_init(&Serial, &USART3, USART_BAUD_VALUE(BAUD_RATE), USART_NORMAL_SPEED);
 }
 
-// Interrupt Service Routine
-/*
- * UART Receive Complete Interrupt
- * Fires whenever a character arrives from the PC.
- */
+// Interrupt Service Routines: the RX ISR only collects the line, it is parsed in main
 ISR(USART3_RXC_vect)
 {
-    char Rx_Char = USART3.RXDATAL;
+	uint8_t Rx_Char;
+	
+	if (usart_driver_rx_read(&Serial, &Rx_Char))
+	{
+		command_line_rx_char(Rx_Char);
+	}
+}
 
-    if (isxdigit(Rx_Char))
-    {
-	    // Add valid hex char to buffer
-	    Rx_Buffer[Rx_Index++] = Rx_Char;
-	    
-	    // AUTO-TRIGGER: If we have 6 digits, process immediately!
-	    if (Rx_Index == 6)
-	    {
-		    Rx_Buffer[6] = '\0';
-		    Process_Color_Command();
-		    Rx_Index = 0;															// Reset for next color
-	    }
-    }
-    else
-    {
-	    // Received something weird (Space, Newline, 'x', etc.)
-	    // Treat this as a "Clear/Reset" command to sync up
-	    Rx_Index = 0;
-    }
+ISR(USART3_DRE_vect)
+{
+	usart_driver_dre_isr(&Serial);
 }
 
 int main(void)
 {
     TCA0_init();
+    TCA1_init();
+    command_line_init();
     USART3_init();
     
     sei();																			// Enable Interrupts
     
     while (1) 
     {
-        // Everything is handled by Hardware PWM and RX Interrupts.
+        // Complete lines from the RX ISR: split in place, run the command, reply
+        char *Line = command_line_receive();
+        
+        if (Line != NULL)
+        {
+            command_line_status_t Status = command_line_dispatch(Commands, COMMAND_COUNT, Line);
+            command_line_release();
+            
+            if (Status != COMMAND_LINE_EMPTY)
+            {
+                usart_driver_put_string(&Serial, command_line_status_text(Status));
+                usart_driver_put_string(&Serial, "\r\n");
+            }
+        }
     }
 }
\ No newline at end of file
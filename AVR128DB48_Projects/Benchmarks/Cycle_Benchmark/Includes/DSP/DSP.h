@@ -0,0 +1,59 @@
+/*
+ * DSP.h
+ *
+ * Fixed-point frequency analysis of ADC blocks (e.g. from ADC_Burst).
+ *
+ * Goertzel: amplitude of one frequency in a block, 2 multiplications per
+ * sample and state. Cheaper than an FFT when only a few frequencies matter
+ * (e.g. 100Hz and 120Hz light flicker). Accuracy for whole bins and amplitudes
+ * of 500 counts or more, checked by Tools/dsp/dsp_test.c: 0.2% with N = 64,
+ * 0.2 ... 0.3% with larger N, except in the 2 bins next to 0 and
+ * sample_hz / 2, where it is up to 1.1% (N = 256): there the Q14 coefficient
+ * 2cos(w) is too coarse for the narrow detector.
+ *
+ * FFT: in-place radix-2 decimation in time for 64, 128 or 256 points.
+ * 16-bit data, Q15 twiddle factors from a quarter-wave sine table. Every
+ * stage divides by 2, so the result is X[k] / N and can't overflow.
+ * A real sinusoid of amplitude A in bin k gives |X[k]| = A / 2.
+ *
+ * All products are 16 x 16 -> 32 bit, which avr-gcc does with the hardware
+ * multiplier (__mulhisi3, 4 MUL instructions). No floating point and no
+ * division per sample.
+ *
+ * Usage:
+ *  static dsp_goertzel_t Flicker_100;
+ *  dsp_goertzel_init(&Flicker_100, 100, 1280);
+ *  uint16_t amplitude = dsp_goertzel_run(&Flicker_100, samples, 128, mean);
+ *
+ *  int16_t re[128], im[128];  (samples - mean in re[], 0 in im[])
+ *  dsp_fft(re, im, 7);
+ *  uint16_t bin_10 = dsp_magnitude(re[10], im[10]);
+ */
+
+#ifndef DSP_H_
+#define DSP_H_
+
+#include <stdint.h>
+
+// Supported FFT sizes as log2(N)
+#define DSP_FFT_MIN_LOG2 6
+#define DSP_FFT_MAX_LOG2 8
+
+typedef struct {
+	int16_t coeff;						// 2 * cos(2 * pi * f / fs) in Q14
+	int16_t sine;						// sin(2 * pi * f / fs) in Q15
+	int32_t s1;							// Filter state
+	int32_t s2;
+} dsp_goertzel_t;
+
+void dsp_goertzel_init(dsp_goertzel_t *g, uint16_t freq_hz, uint16_t sample_hz);
+uint16_t dsp_goertzel_run(dsp_goertzel_t *g, const uint16_t *samples, uint16_t count, uint16_t offset);
+
+void dsp_fft(int16_t *re, int16_t *im, uint8_t log2n);
+uint16_t dsp_magnitude(int16_t re, int16_t im);
+
+int16_t dsp_sin_q15(uint16_t phase);
+int16_t dsp_cos_q15(uint16_t phase);
+uint16_t dsp_sqrt32(uint32_t x);
+
+#endif /* DSP_H_ */
@@ -0,0 +1,71 @@
+/*
+ * Debug_USART.c
+ */
+
+#include <avr/io.h>
+#include "Debug_USART.h"
+#include "../USART_Baud/USART_Baud.h"
+
+// Normal speed (16 samples per bit) while the BAUD register stays >= 64, above that double speed (CLK2X, 8 samples per bit)
+#define DEBUG_USART_SPEED USART_BAUD_SPEED(DEBUG_USART_BAUD)
+
+USART_BAUD_CHECK(DEBUG_USART_BAUD, DEBUG_USART_SPEED);
+
+/*
+	Enables USART3 transmitter and receiver on PB0/PB1 (no interrupts).
+	Rates above F_CPU / 16 use double speed mode, up to F_CPU / 8.
+*/
+void debug_usart_init(void)
+{
+	PORTMUX.USARTROUTEA &= ~PORTMUX_USART3_gm;					// Default pins PB0 = TX, PB1 = RX
+	PORTB.DIRSET = PIN0_bm;
+	PORTB.DIRCLR = PIN1_bm;
+
+	USART3.BAUD = (uint16_t)USART_BAUD_REGISTER(DEBUG_USART_BAUD, DEBUG_USART_SPEED);
+	USART3.CTRLC = USART_CHSIZE_8BIT_gc | USART_PMODE_DISABLED_gc | USART_SBMODE_1BIT_gc;
+	USART3.CTRLB = USART_TXEN_bm | USART_RXEN_bm
+		| ((DEBUG_USART_SPEED == USART_DOUBLE_SPEED) ? USART_RXMODE_CLK2X_gc : USART_RXMODE_NORMAL_gc);
+}
+
+/*
+	Waits until the data register is free and sends one character.
+*/
+void debug_usart_put_char(char c)
+{
+	while (!(USART3.STATUS & USART_DREIF_bm))
+	{
+		;
+	}
+	USART3.TXDATAL = c;
+}
+
+void debug_usart_put_string(const char *str)
+{
+	while (*str)
+	{
+		debug_usart_put_char(*str++);
+	}
+}
+
+void debug_usart_put_bytes(const uint8_t *data, uint16_t length)
+{
+	while (length--)
+	{
+		debug_usart_put_char((char)*data++);
+	}
+}
+
+/*
+	Non-blocking receive.
+
+	@param c Destination for the received character
+	@return true if a character was available
+*/
+bool debug_usart_get_char(char *c)
+{
+	if (!(USART3.STATUS & USART_RXCIF_bm))
+		return false;
+
+	*c = USART3.RXDATAL;
+	return true;
+}
@@ -0,0 +1,63 @@
+/*
+ * Lookup_Table.c
+ *
+ * The interpolation itself is inline in the header, here are only the
+ * functions that are called once (set-up, thresholds).
+ */
+
+#include "Lookup_Table.h"
+
+// PRIVATE FUNCTIONS //
+
+/*
+	@return Input of the last entry, limited to 16 bits
+*/
+static uint16_t x_end(const lut_t *lut)
+{
+	uint32_t end = (uint32_t)(lut->size - 1) << lut->shift;
+
+	return (end > UINT16_MAX) ? UINT16_MAX : (uint16_t)end;
+}
+
+// PUBLIC FUNCTIONS //
+
+/*
+	@return false if the table can't be used with lut_interpolate()
+*/
+bool lut_valid(const lut_t *lut)
+{
+	return lut->table != 0 && lut->size >= 2 && lut->shift >= 1 && lut->shift <= 15;
+}
+
+/*
+	Reverse lookup for a monotonic table, e.g. to turn a threshold in lux into
+	the mV for a comparator. Binary search with lut_interpolate(), so the
+	result is consistent with the forward direction (16 lookups, no division).
+
+	@param y Output value to find
+	@return Smallest x whose output reaches y (>= y for a rising table, <= y
+	        for a falling one), the end of the table if no x does
+*/
+uint16_t lut_inverse(const lut_t *lut, uint16_t y)
+{
+	uint16_t low = 0;
+	uint16_t high = x_end(lut);
+	bool rising = LUT_READ(&lut->table[lut->size - 1]) >= LUT_READ(&lut->table[0]);
+
+	while (low < high)
+	{
+		uint16_t mid = low + (high - low) / 2;
+		uint16_t value = lut_interpolate(lut, mid);
+
+		if (rising ? (value >= y) : (value <= y))
+		{
+			high = mid;
+		}
+		else
+		{
+			low = mid + 1;
+		}
+	}
+
+	return low;
+}
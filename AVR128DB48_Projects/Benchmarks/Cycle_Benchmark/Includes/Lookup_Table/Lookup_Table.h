@@ -0,0 +1,80 @@
+/*
+ * Lookup_Table.h
+ *
+ * Sensor linearisation with piecewise-linear interpolation in flash tables.
+ *
+ * A table holds the output for equally spaced inputs: entry i belongs to
+ * x = i * 2^shift. lut_interpolate() takes the segment from the high bits of
+ * x and the position inside it from the low bits, so a lookup costs one
+ * 16 x 16 bit multiplication and a shift (a few dozen cycles), no search and
+ * no division. Tables may rise or fall (e.g. LDR lux, NTC temperature).
+ * Tools/lut_generate.py makes the table from calibration points.
+ *
+ * Flash: on the AVR DB a 32KB section of the flash is mapped into the data
+ * space (NVMCTRL FLMAP). Toolchains that support it (avr-gcc 14+, defines
+ * __AVR_HAVE_FLMAP__) keep const data there and read it with normal loads,
+ * no copy in RAM. Older toolchains copy const data to RAM at start-up, there
+ * LUT_FLASH puts the table into program memory instead (PROGMEM, first 64KB)
+ * and LUT_READ() reads it with LPM. Tables must be declared with LUT_FLASH
+ * and only be read through this module.
+ *
+ * Usage:
+ *  static const uint16_t Lux_Table[105] LUT_FLASH = { ... };   // lut_generate.py output
+ *  static const lut_t Lux_Lut = LUT_INIT(Lux_Table, 5);        // 32 input units per segment
+ *  uint16_t lux = lut_interpolate(&Lux_Lut, Voltage_Mv);
+ */
+
+#ifndef LOOKUP_TABLE_H_
+#define LOOKUP_TABLE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#if defined(__AVR_HAVE_FLMAP__) && defined(__AVR_RODATA_IN_RAM__) && (__AVR_RODATA_IN_RAM__ == 0)
+#define LUT_FLASH											// .rodata already stays in the mapped flash
+#define LUT_READ(p) (*(p))
+#else
+#include <avr/pgmspace.h>
+#define LUT_FLASH PROGMEM
+#define LUT_READ(p) pgm_read_word(p)
+#endif
+
+typedef struct {
+	const uint16_t *table;				// LUT_FLASH array
+	uint16_t size;						// Entries, at least 2
+	uint8_t shift;						// 2^shift input units per segment (1 ... 15)
+} lut_t;
+
+// Constant initializer for a table array
+#define LUT_INIT(table, shift) { (table), sizeof(table) / sizeof((table)[0]), (shift) }
+
+bool lut_valid(const lut_t *lut);
+uint16_t lut_inverse(const lut_t *lut, uint16_t y);
+
+/*
+	Output for x, linearly interpolated between the two neighbouring entries
+	and rounded. Inputs beyond the last entry give the last entry.
+
+	@param x Input (e.g. ADC result or mV)
+	@return Interpolated output
+*/
+static inline uint16_t lut_interpolate(const lut_t *lut, uint16_t x)
+{
+	uint16_t segment = x >> lut->shift;
+
+	if (segment >= lut->size - 1)
+		return LUT_READ(&lut->table[lut->size - 1]);
+
+	uint16_t frac = x & ((1U << lut->shift) - 1);
+	uint16_t half = 1U << (lut->shift - 1);
+	uint16_t y0 = LUT_READ(&lut->table[segment]);
+	uint16_t y1 = LUT_READ(&lut->table[segment + 1]);
+
+	// Unsigned 16 x 16 bit products, one direction each
+	if (y1 >= y0)
+		return y0 + (uint16_t)(((uint32_t)(uint16_t)(y1 - y0) * frac + half) >> lut->shift);
+
+	return y0 - (uint16_t)(((uint32_t)(uint16_t)(y0 - y1) * frac + half) >> lut->shift);
+}
+
+#endif /* LOOKUP_TABLE_H_ */
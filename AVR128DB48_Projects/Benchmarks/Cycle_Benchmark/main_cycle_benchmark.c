@@ -0,0 +1,408 @@
+/*
+ * main_cycle_benchmark.c
+ *
+ * Cycle benchmarks for code that runs in ISRs or tight loops.
+ * Every case is called BENCH_ITERATIONS times and timed with the Timestamp
+ * module (TCB1, 1 count = 1 CLK_PER cycle). The call overhead measured with an
+ * empty case is subtracted. Long cases (e.g. an FFT) run BENCH_LONG_ITERATIONS
+ * times with interrupts enabled, so TCB1 overflows are still counted.
+ * Results are printed over USART3 (9600 baud):
+ *
+ *   name                      min / avg / max cycles
+ *
+ * Before the first run the fixed-point scales are compared with the division
+ * formulas for every input value (prints the number of mismatches).
+ *
+ * Send 'b' to run all cases again.
+ */
+
+#define F_CPU 4000000UL                                                                 // CPU Frequency 4MHz
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include "Timestamp.h"
+#include "Debug_USART.h"
+#include "Debounce.h"
+#include "Fixed_Point.h"
+#include "DSP.h"
+#include "Lookup_Table.h"
+
+#define BENCH_ITERATIONS 256                                                            // Calls per case
+#define BENCH_LONG_ITERATIONS 8                                                         // Calls per long case (more than ~30000 cycles)
+#define MS_DEBOUNCE_MAX 10                                                              // Per-pin debouncer: samples for a stable reading
+
+typedef struct {
+    const char *name;
+    void (*run)(void);                                                                  // One call = one measured unit of work
+    bool long_case;                                                                     // Runs with interrupts enabled (TCB1 overflow ISR included)
+} bench_case_t;
+
+// Results are written here so the compiler cannot remove the work
+volatile uint8_t G_Sink = 0;
+
+// **Input pattern: bouncing presses and releases on all 8 pins of a port
+// Each call consumes one sample, so every case sees the same input sequence.
+static const uint8_t Sample_Pattern[32] = {
+    0x00, 0x10, 0x00, 0x30, 0x10, 0x30, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0,
+    0xF0, 0xE0, 0xF0, 0xC0, 0xE0, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+static uint8_t Sample_Index = 0;
+
+static inline uint8_t next_sample(void)
+{
+    return Sample_Pattern[Sample_Index++ & 31];
+}
+// End of input pattern**
+
+// **Case: per-pin debouncer (as used before the Debounce module)
+static bool Pin_Stable_State[8];
+static uint8_t Pin_Debounce_Counter[8];
+
+static void handle_button_debounce(uint8_t pin_value, bool *stable_state, uint8_t *counter, uint8_t button_id)
+{
+    bool current_raw_state = (pin_value != 0);
+
+    if (current_raw_state != *stable_state)
+    {
+        if (*counter < MS_DEBOUNCE_MAX)
+        {
+            (*counter)++;
+        }
+
+        if (*counter >= MS_DEBOUNCE_MAX)
+        {
+            if (current_raw_state == true)
+            {
+                G_Sink = button_id;                                                     // Stands in for event_post()
+            }
+            *stable_state = current_raw_state;
+            *counter = 0;
+        }
+    }
+    else
+    {
+        *counter = 0;
+    }
+}
+
+static void bench_per_pin_2(void)
+{
+    uint8_t port_in = next_sample();
+
+    handle_button_debounce(port_in & PIN4_bm, &Pin_Stable_State[4], &Pin_Debounce_Counter[4], 4);
+    handle_button_debounce(port_in & PIN5_bm, &Pin_Stable_State[5], &Pin_Debounce_Counter[5], 5);
+}
+
+static void bench_per_pin_4(void)
+{
+    uint8_t port_in = next_sample();
+
+    handle_button_debounce(port_in & PIN4_bm, &Pin_Stable_State[4], &Pin_Debounce_Counter[4], 4);
+    handle_button_debounce(port_in & PIN5_bm, &Pin_Stable_State[5], &Pin_Debounce_Counter[5], 5);
+    handle_button_debounce(port_in & PIN6_bm, &Pin_Stable_State[6], &Pin_Debounce_Counter[6], 6);
+    handle_button_debounce(port_in & PIN7_bm, &Pin_Stable_State[7], &Pin_Debounce_Counter[7], 7);
+}
+
+static void bench_per_pin_8(void)
+{
+    uint8_t port_in = next_sample();
+
+    for (uint8_t pin = 0; pin < 8; pin++)
+    {
+        handle_button_debounce(port_in & (1 << pin), &Pin_Stable_State[pin], &Pin_Debounce_Counter[pin], pin);
+    }
+}
+// End of per-pin debouncer**
+
+// **Case: vertical counter debouncer (Debounce module, all 8 pins)
+static debounce_t Port_Buttons;
+
+static void bench_vertical_8(void)
+{
+    uint8_t changed = debounce_update(&Port_Buttons, next_sample());
+    G_Sink = DEBOUNCE_PRESSED(&Port_Buttons, changed);
+}
+// End of vertical counter debouncer**
+
+// **Case: scaling an ADC result, 32-bit division against Fixed_Point
+#define ADC_FULL_SCALE 16380U                                                           // 14-bit result of the ADC projects
+#define TEMP_CAL_EXAMPLE 2152U                                                          // Typical SIGROW.TEMPSENSE0/1 value
+
+static const fixed_scale_t Mv_Scale = FIXED_SCALE(3300, ADC_FULL_SCALE);
+static const fixed_scale_t Duty_Scale = FIXED_SCALE(256, 100);
+static fixed_scale_t Temp_K_Scale;                                                      // Runtime divisor, set in bench_run_all()
+volatile uint16_t Cal_Val = TEMP_CAL_EXAMPLE;                                           // volatile: the compiler can't treat it as a constant
+
+// Input sweep over the 14-bit range (0 ... 16320), one value per call
+static inline uint16_t next_adc(void)
+{
+    return (uint16_t)Sample_Index++ * 64;
+}
+
+static void bench_div_mv(void)
+{
+    G_Sink = ((uint32_t)next_adc() * 3300) / ADC_FULL_SCALE;
+}
+
+static void bench_fixed_mv(void)
+{
+    G_Sink = fixed_scale(&Mv_Scale, next_adc());
+}
+
+static void bench_div_cal(void)
+{
+    G_Sink = ((uint32_t)(next_adc() >> 2) * 358) / Cal_Val;
+}
+
+static void bench_fixed_cal(void)
+{
+    G_Sink = fixed_scale(&Temp_K_Scale, next_adc() >> 2);
+}
+
+static void bench_double_duty(void)
+{
+    G_Sink = (uint8_t)(((double)(Sample_Index++ & 63) / 100.0) * 256.0 - 1);
+}
+
+static void bench_fixed_duty(void)
+{
+    G_Sink = fixed_scale(&Duty_Scale, Sample_Index++ & 63) - 1;
+}
+
+static void bench_q_mul(void)
+{
+    G_Sink = fixed_q_mul((int16_t)next_adc(), FIXED_Q(0.8, 8), 8);
+}
+
+/**
+ * @brief Compares the fixed-point scales with the division formulas for every input.
+ */
+static void bench_check_fixed(void)
+{
+    uint32_t mismatches = 0;
+    char line[64];
+
+    for (uint16_t x = 0; x <= ADC_FULL_SCALE; x++)
+    {
+        if (fixed_scale(&Mv_Scale, x) != ((uint32_t)x * 3300) / ADC_FULL_SCALE) mismatches++;
+        if (x <= 4095 && fixed_scale(&Temp_K_Scale, x) != ((uint32_t)x * 358) / Cal_Val) mismatches++;
+        if (x <= 100 && x > 0 && fixed_scale(&Duty_Scale, x) - 1 != (uint8_t)(((double)x / 100.0) * 256.0 - 1)) mismatches++;
+    }
+
+    sprintf(line, "fixed_scale check: %lu mismatches\r\n", mismatches);
+    debug_usart_put_string(line);
+}
+// End of scaling**
+
+// **Case: DSP kernels on one block (1280Hz light flicker set-up: 100Hz in 256 samples)
+#define DSP_BLOCK 256
+
+static uint16_t Dsp_Block[DSP_BLOCK];
+static int16_t Fft_Re[DSP_BLOCK];
+static int16_t Fft_Im[DSP_BLOCK];
+static dsp_goertzel_t Goertzel_100;
+
+static void bench_goertzel_128(void)
+{
+    G_Sink = dsp_goertzel_run(&Goertzel_100, Dsp_Block, 128, 2048);
+}
+
+static void bench_goertzel_256(void)
+{
+    G_Sink = dsp_goertzel_run(&Goertzel_100, Dsp_Block, 256, 2048);
+}
+
+// The FFT works in place on its own output, the run time does not depend on the data
+static void bench_fft_64(void)
+{
+    dsp_fft(Fft_Re, Fft_Im, 6);
+}
+
+static void bench_fft_128(void)
+{
+    dsp_fft(Fft_Re, Fft_Im, 7);
+}
+
+static void bench_fft_256(void)
+{
+    dsp_fft(Fft_Re, Fft_Im, 8);
+}
+
+static void bench_magnitude(void)
+{
+    G_Sink = dsp_magnitude((int16_t)next_adc(), -1234);
+}
+
+/**
+ * @brief Fills the DSP input with a 100Hz sine at 1280Hz sampling (amplitude 1000 around 2048).
+ */
+static void bench_dsp_init(void)
+{
+    dsp_goertzel_init(&Goertzel_100, 100, 1280);
+
+    for (uint16_t i = 0; i < DSP_BLOCK; i++)
+    {
+        int16_t s = dsp_sin_q15((uint16_t)(i * 5120UL));                               // 65536 * 100 / 1280 per sample
+        Dsp_Block[i] = 2048 + (int16_t)(((int32_t)s * 1000) >> 15);
+        Fft_Re[i] = (int16_t)(Dsp_Block[i] - 2048);
+        Fft_Im[i] = 0;
+    }
+}
+// End of DSP kernels**
+
+// **Case: LDR linearisation (mV -> lux) with the ADC Photoresistor flash table against the model formula
+// (GL5528: 15k at 10 lux, gamma 0.7, 10k to GND)
+static const uint16_t Lux_Table[105] LUT_FLASH = {
+        0,     0,     0,     0,     0,     0,     0,     1,     1,     1,     1,     1,
+        1,     1,     1,     1,     2,     2,     2,     2,     2,     3,     3,     3,
+        3,     4,     4,     4,     4,     5,     5,     6,     6,     6,     7,     7,
+        8,     8,     8,     9,     9,    10,    11,    11,    12,    13,    14,    14,
+       15,    16,    17,    18,    19,    20,    21,    23,    24,    25,    26,    28,
+       29,    30,    33,    35,    38,    40,    43,    46,    50,    53,    57,    60,
+       64,    68,    73,    77,    82,    87,    92,    98,   107,   118,   131,   145,
+      160,   177,   195,   215,   236,   260,   285,   325,   391,   468,   560,   668,
+      797,   948,  1287,  1851,  2653,  4986, 10000, 10000, 10000,
+};
+static const lut_t Lux_Lut = LUT_INIT(Lux_Table, 5);
+
+// Input sweep 400 ... 3172 mV, one value per call
+static inline uint16_t next_mv(void)
+{
+    return 400 + (Sample_Index++ & 63) * 44;
+}
+
+static void bench_lux_double(void)
+{
+    double r = 10000.0 * (3300.0 / next_mv() - 1.0);
+    G_Sink = (uint8_t)(10.0 * pow(r / 15000.0, -1.0 / 0.7));
+}
+
+static void bench_lux_lut(void)
+{
+    G_Sink = lut_interpolate(&Lux_Lut, next_mv());
+}
+// End of LDR linearisation**
+
+static void bench_empty(void)
+{
+    G_Sink = next_sample();
+}
+
+// Add new cases here. The first entry is the reference for the call overhead.
+static const bench_case_t Bench_Cases[] = {
+    { "empty (overhead)",        bench_empty, false },
+    { "debounce per-pin x2",     bench_per_pin_2, false },
+    { "debounce per-pin x4",     bench_per_pin_4, false },
+    { "debounce per-pin x8",     bench_per_pin_8, false },
+    { "debounce vertical x8",    bench_vertical_8, false },
+    { "scale mV 32-bit div",     bench_div_mv, false },
+    { "scale mV fixed_scale",    bench_fixed_mv, false },
+    { "temp K 32-bit div",       bench_div_cal, false },
+    { "temp K fixed_scale",      bench_fixed_cal, false },
+    { "duty double",             bench_double_duty, false },
+    { "duty fixed_scale",        bench_fixed_duty, false },
+    { "q8.8 multiply",           bench_q_mul, false },
+    { "dsp magnitude (sqrt)",    bench_magnitude, false },
+    { "goertzel 128 samples",    bench_goertzel_128, false },
+    { "goertzel 256 samples",    bench_goertzel_256, true },
+    { "fft 64 points",           bench_fft_64, false },
+    { "fft 128 points",          bench_fft_128, true },
+    { "fft 256 points",          bench_fft_256, true },
+    { "lux double pow()",        bench_lux_double, false },
+    { "lux lut_interpolate",     bench_lux_lut, false },
+};
+
+#define BENCH_CASE_COUNT (sizeof(Bench_Cases) / sizeof(Bench_Cases[0]))
+
+/**
+ * @brief Calls one case BENCH_ITERATIONS times and prints min / avg / max cycles per call.
+ * @param overhead Cycles of the empty case, subtracted from every result.
+ * @return Minimum cycles per call (before subtracting the overhead)
+ */
+static uint16_t bench_run(const bench_case_t *bench, uint16_t overhead)
+{
+    uint32_t min = UINT32_MAX;
+    uint32_t max = 0;
+    uint32_t sum = 0;
+    uint16_t iterations = bench->long_case ? BENCH_LONG_ITERATIONS : BENCH_ITERATIONS;
+    char line[64];
+
+    Sample_Index = 0;
+
+    for (uint16_t i = 0; i < iterations; i++)
+    {
+        // Interrupts stay off for one call so the TCB1 overflow ISR is not counted.
+        // A long case would miss more than one overflow, it keeps them on (~40 cycles per 65536).
+        if (!bench->long_case)
+        {
+            cli();
+        }
+        uint32_t start = timestamp_cycles();
+        bench->run();
+        uint32_t cycles = timestamp_elapsed_cycles(start);
+        sei();
+
+        if (cycles < min) min = cycles;
+        if (cycles > max) max = cycles;
+        sum += cycles;
+    }
+
+    uint32_t avg = sum / iterations;
+
+    sprintf(line, "%-24s %6lu / %6lu / %6lu\r\n", bench->name,
+            (min > overhead) ? min - overhead : 0,
+            (avg > overhead) ? avg - overhead : 0,
+            (max > overhead) ? max - overhead : 0);
+    debug_usart_put_string(line);
+
+    return (uint16_t)min;
+}
+
+/**
+ * @brief Runs all cases, the empty case first to get the overhead.
+ */
+static void bench_run_all(void)
+{
+    debounce_init(&Port_Buttons, 0);
+    fixed_scale_init(&Temp_K_Scale, 358, Cal_Val, 4095);
+    for (uint8_t pin = 0; pin < 8; pin++)
+    {
+        Pin_Stable_State[pin] = false;
+        Pin_Debounce_Counter[pin] = 0;
+    }
+
+    debug_usart_put_string("\r\n--- Cycle benchmark (min / avg / max CLK_PER cycles per call) ---\r\n");
+
+    uint16_t overhead = bench_run(&Bench_Cases[0], 0);
+
+    for (uint8_t i = 1; i < BENCH_CASE_COUNT; i++)
+    {
+        bench_run(&Bench_Cases[i], overhead);
+    }
+}
+
+int main(void)
+{
+    char c;
+
+    timestamp_init();
+    debug_usart_init();
+    sei();
+
+    fixed_scale_init(&Temp_K_Scale, 358, Cal_Val, 4095);
+    bench_dsp_init();
+    bench_check_fixed();
+    bench_run_all();
+
+    while (1)
+    {
+        if (debug_usart_get_char(&c) && c == 'b')
+        {
+            bench_run_all();
+        }
+    }
+}
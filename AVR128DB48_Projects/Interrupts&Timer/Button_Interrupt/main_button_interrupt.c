@@ -6,6 +6,8 @@
  *
  * Implements non-blocking debouncing and rising edge detection
  * using a Timer ISR to toggle an RGB LED state.
+ * The timer only runs while the button bounces: a pin-change interrupt
+ * starts it, it stops itself once the input is stable again.
  *
  * Microcontroller: AVR128DB48
  * LED: RGB connected to PE0, PE1, PE2 (using PE2 for demonstration)
@@ -16,17 +18,21 @@
 #include <avr/interrupt.h>
 #include <stdbool.h>
 #include <stdint.h>							// Include for uint32_t used by Xorshift
+#include <avr/sleep.h>
+#include "Debounce.h"
 
-// Debounce constants: 
-// Timer runs at 1kHz (1ms period). 
-// 10 cycles = 10ms stable time required.
-#define DEBOUNCE_MAX 10 
+// Debounce: the timer runs at 1kHz (1ms period) while the button bounces,
+// DEBOUNCE_SAMPLES (8) equal samples = 8ms stable time required.
+#define BUTTON_MASK PIN4_bm
 
 // Tracks the last confirmed, stable state of the button (true = pressed, false = released)
 volatile bool G_Last_Stable_State = false;
 
-// Counter for debouncing
-volatile uint8_t G_Debounce_Counter = 0;
+// Debounce state of port C (only used by the ISRs)
+static debounce_t G_Button;
+
+// True while TCA0 samples the button
+volatile bool G_Debounce_Running = false;
 
 // State variable (seed) for the Xorshift32 PRNG.
 // Change this value to alter the sequence of random numbers.
@@ -53,53 +59,81 @@ uint32_t xorshift32(void)
     return x;
 }
 
-// interrupt service routine for the button
+// Starts the 1ms sampling timer and masks the pin-change interrupt (no ISR per bounce edge)
+static void debounce_start(void)
+{
+	PORTC.PIN4CTRL = PORT_ISC_INTDISABLE_gc;
+	PORTC.INTFLAGS = BUTTON_MASK;
+	
+	TCA0.SINGLE.CNT = 0;
+	TCA0.SINGLE.INTFLAGS = TCA_SINGLE_OVF_bm;
+	TCA0.SINGLE.CTRLA |= TCA_SINGLE_ENABLE_bm;
+	G_Debounce_Running = true;
+}
+
+// Stops the timer and waits for the next edge again
+static void debounce_stop(void)
+{
+	TCA0.SINGLE.CTRLA &= ~TCA_SINGLE_ENABLE_bm;
+	G_Debounce_Running = false;
+	
+	PORTC.INTFLAGS = BUTTON_MASK;
+	PORTC.PIN4CTRL = PORT_ISC_BOTHEDGES_gc;
+	
+	// An edge between the last sample and re-arming would be missed, so check the pin once more
+	if ((PORTC.IN & BUTTON_MASK) != G_Button.state)
+	{
+		debounce_start();
+	}
+}
+
+// Called for the new stable pressed edge
+static void button_pressed(void)
+{
+	// Random Color Generation
+	uint32_t random_val = xorshift32();
+	
+	// Extract 3 bits for the R, G, B pins (PE0, PE1, PE2)
+	color_bits = (uint8_t)(random_val & 0x07); // Mask to keep only the lower 3 bits (0b111)
+	
+	// Do not turn the LED off: avoid color_bits == 0b000
+	if (color_bits == 0) {
+		color_bits = 1; // Force to Red (0b001) if 0 is generated
+	}
+}
+
+// Pin-change interrupt: first edge of a press or release
+ISR(PORTC_PORT_vect)
+{
+	PORTC.INTFLAGS = BUTTON_MASK;
+	debounce_start();
+}
+
+// interrupt service routine for the button (only runs while the input bounces)
 ISR(TCA0_OVF_vect)
 {
 	// Clear interrupt flag
 	TCA0.SINGLE.INTFLAGS = TCA_SINGLE_OVF_bm;
 	
 	// Read raw button state (PC4 is 1 when pressed, 0 when released due to pull-down)
-	bool Raw_State = (PORTC.IN & PIN4_bm) != 0;
-
-	// Check if the current raw reading differs from the last confirmed stable state
-	if (Raw_State != G_Last_Stable_State)
+	uint8_t Changed = debounce_update(&G_Button, PORTC.IN & BUTTON_MASK);
+	
+	if (Changed)
 	{
-		// State change detected, start/continue counting
-		if (G_Debounce_Counter < DEBOUNCE_MAX)
-		{
-			G_Debounce_Counter++;
-		}
+		// 1. Update the last confirmed stable state
+		G_Last_Stable_State = (G_Button.state & BUTTON_MASK) != 0;
 		
-		// Stable edge reached
-		else {
-			// 1. Update the last confirmed stable state
-			G_Last_Stable_State = Raw_State;
-			
-			// 2. Rising Edge Detection (only act if the new stable state is HIGH/Pressed)
-			if (G_Last_Stable_State == true)
-			{
-				// Random Color Generation
-				uint32_t random_val = xorshift32();
-				
-				// Extract 3 bits for the R, G, B pins (PE0, PE1, PE2)
-				color_bits = (uint8_t)(random_val & 0x07); // Mask to keep only the lower 3 bits (0b111)
-				
-				// Do not turn the LED off: avoid color_bits == 0b000
-				if (color_bits == 0) {
-					color_bits = 1; // Force to Red (0b001) if 0 is generated
-				}
-			}
-			
-			// 3. Reset the counter (ready to count the next transition)
-			G_Debounce_Counter = 0;
+		// 2. Rising Edge Detection (only act if the new stable state is HIGH/Pressed)
+		if (DEBOUNCE_PRESSED(&G_Button, Changed))
+		{
+			button_pressed();
 		}
 	}
-	else
+	
+	// Input stable again: no more timer interrupts until the next edge
+	if (debounce_idle(&G_Button))
 	{
-		// The button state matches the last stable state, so reset the counter.
-		// Wait for the next transition.
-		G_Debounce_Counter = 0;
+		debounce_stop();
 	}
 }
 
@@ -112,7 +146,7 @@ void timer_init(void)
 	TCA0.SINGLE.PER = 4000; 		   // Set period for 1ms overflow (FIXED: Removed stray '\240' chars)
 	TCA0.SINGLE.CTRLA = TCA_SINGLE_CLKSEL_DIV1_gc; // No prescaler (use CLK_PER)
 	TCA0.SINGLE.INTCTRL = TCA_SINGLE_OVF_bm; // Enable overflow interrupt (FIXED: Removed stray '\240' chars)
-	TCA0.SINGLE.CTRLA |= TCA_SINGLE_ENABLE_bm; // Enable timer
+	// The timer is not enabled here: debounce_start() runs it only while the button bounces
 }
 
 
@@ -121,8 +155,9 @@ int main(void)
 	// --- Port Configuration ---
 	PORTC.DIRCLR = PIN4_bm;								// Set PC4 as input (button)
 	// Since you have external pull-down resistors, we don't need internal pull-ups.
-	// We also don't use PORT_ISC_RISING_gc because the timer is doing the polling.
-	PORTC.PIN4CTRL = 0x00; 
+	// Both edges interrupt: a press and a release both have to be debounced.
+	PORTC.PIN4CTRL = PORT_ISC_BOTHEDGES_gc;
+	debounce_init(&G_Button, PORTC.IN & BUTTON_MASK);
 	
 	// Set PE0, PE1, and PE2 as output (RGB LED)
 	PORTE.DIRSET = PIN0_bm | PIN1_bm | PIN2_bm;
@@ -148,5 +183,14 @@ int main(void)
 			if (color_bits & PIN1_bm) { PORTE.OUTSET = PIN1_bm; }
 			if (color_bits & PIN2_bm) { PORTE.OUTSET = PIN2_bm; }
 		}
+		
+		// Sleep until the next interrupt. Without the debounce timer only the pin change
+		// can wake the CPU (works in power-down with PORT_ISC_BOTHEDGES_gc).
+		cli();
+		set_sleep_mode(G_Debounce_Running ? SLEEP_MODE_IDLE : SLEEP_MODE_PWR_DOWN);
+		sleep_enable();
+		sei();
+		sleep_cpu();
+		sleep_disable();
     }
 }
\ No newline at end of file
@@ -0,0 +1,18 @@
+/*
+ * Debounce.c
+ */
+
+#include "Debounce.h"
+
+/*
+	Clears all counters and sets the debounced state.
+
+	@param initial Start state, usually the current port input so no edges are reported at startup
+*/
+void debounce_init(debounce_t *db, uint8_t initial)
+{
+	db->state = initial;
+	db->c0 = 0;
+	db->c1 = 0;
+	db->c2 = 0;
+}
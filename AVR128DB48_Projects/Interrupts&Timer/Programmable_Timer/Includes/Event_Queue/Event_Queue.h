@@ -0,0 +1,60 @@
+/*
+ * Event_Queue.h
+ *
+ * Lock-free ISR -> main event queue with table-based dispatch.
+ *
+ * ISRs post small typed events (type, source, payload, timestamp) into a
+ * ring buffer and main() drains it through a handler table. Unlike a single
+ * volatile flag, every event is kept until main gets to it, so two button
+ * presses between two polls are both seen.
+ *
+ * Usage:
+ *  1. Call event_queue_init() once before sei().
+ *  2. Call event_tick() from the 1ms timer ISR (timestamps are in ms). A project
+ *     without a 1ms tick leaves it out, event_t.timestamp is then always 0.
+ *  3. Post from ISRs with event_post(). From main, wrap event_post() in cli()/sei().
+ *  4. In the main loop call event_dispatch(Handler_Table, EVENT_TYPE_COUNT).
+ */
+
+#ifndef EVENT_QUEUE_H_
+#define EVENT_QUEUE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Number of slots in the queue. Must be a power of 2 and at most 128.
+#ifndef EVENT_QUEUE_SIZE
+#define EVENT_QUEUE_SIZE 16
+#endif
+
+#define EVENT_QUEUE_MASK (EVENT_QUEUE_SIZE - 1)
+
+#if (EVENT_QUEUE_SIZE & EVENT_QUEUE_MASK) != 0 || EVENT_QUEUE_SIZE > 128
+#error "EVENT_QUEUE_SIZE must be a power of 2 and <= 128"
+#endif
+
+// Type 0 is reserved, applications number their own event types from 1.
+#define EVENT_NONE 0
+
+typedef struct {
+	uint8_t  type;				// Application defined event type (index into the handler table)
+	uint8_t  source;			// Who raised the event (e.g. pin number of a button)
+	uint16_t payload;			// Event data (e.g. ADC result)
+	uint16_t timestamp;			// event_now() at the time the event was posted (ms), 0 without event_tick()
+} event_t;
+
+typedef void (*event_handler_t)(const event_t *event);
+
+void event_queue_init(void);
+
+void event_tick(void);
+uint16_t event_now(void);
+
+bool event_post(uint8_t type, uint8_t source, uint16_t payload);
+bool event_get(event_t *event);
+uint8_t event_pending(void);
+uint8_t event_dropped(void);
+
+void event_dispatch(const event_handler_t *handlers, uint8_t handler_count);
+
+#endif /* EVENT_QUEUE_H_ */
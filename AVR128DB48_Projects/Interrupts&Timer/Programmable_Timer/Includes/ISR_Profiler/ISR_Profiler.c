@@ -0,0 +1,214 @@
+/*
+ * ISR_Profiler.c
+ *
+ * isr_profiler_record() runs inside the profiled ISR (interrupts are disabled there),
+ * so the statistics are updated without further locking. Main copies a profile
+ * with interrupts disabled before formatting it.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <stdio.h>
+#include <string.h>
+#include "ISR_Profiler.h"
+#include "../Debug_USART/Debug_USART.h"
+
+// VARIABLES //
+static isr_profile_t Profiles[ISR_PROFILER_VECTORS];
+static const char *const *Profile_Names = NULL;
+static uint8_t Profile_Count = 0;
+
+// PRIVATE FUNCTIONS //
+
+/*
+	@return Histogram bin for a value: 0 for 0, otherwise 1 + floor(log2(value))
+*/
+static uint8_t log2_bin(uint16_t value)
+{
+	uint8_t bin = 0;
+
+	while (value)
+	{
+		value >>= 1;
+		bin++;
+	}
+	return bin;
+}
+
+static void count_saturated(uint16_t *counter)
+{
+	if (*counter != ISR_PROFILER_SATURATED)
+	{
+		(*counter)++;
+	}
+}
+
+static void print_histogram(const char *label, const uint16_t *hist)
+{
+	char line[24];
+
+	debug_usart_put_string(label);
+	for (uint8_t bin = 0; bin < ISR_PROFILER_BINS; bin++)
+	{
+		if (hist[bin] == 0)
+			continue;
+
+		// Bin covers [2^(bin-1), 2^bin - 1], print its exclusive upper bound
+		sprintf(line, " <%lu:%u", 1UL << bin, hist[bin]);
+		debug_usart_put_string(line);
+	}
+	debug_usart_put_string("\r\n");
+}
+
+// PUBLIC FUNCTIONS //
+
+/*
+	@param names Name of each profiled vector, indexed by id (used in the report)
+	@param count Number of profiled vectors (max ISR_PROFILER_VECTORS)
+*/
+void isr_profiler_init(const char *const *names, uint8_t count)
+{
+	Profile_Names = names;
+	Profile_Count = (count > ISR_PROFILER_VECTORS) ? ISR_PROFILER_VECTORS : count;
+	isr_profiler_reset();
+}
+
+/*
+	Clears all statistics. Budgets are kept.
+*/
+void isr_profiler_reset(void)
+{
+	uint8_t sreg = SREG;
+	cli();
+
+	for (uint8_t id = 0; id < ISR_PROFILER_VECTORS; id++)
+	{
+		uint16_t budget = Profiles[id].exec_budget;
+
+		memset(&Profiles[id], 0, sizeof(isr_profile_t));
+		Profiles[id].latency_min = 0xFFFF;
+		Profiles[id].exec_min = 0xFFFF;
+		Profiles[id].exec_budget = budget;
+	}
+
+	SREG = sreg;
+}
+
+/*
+	@param id     Profiled vector
+	@param cycles Allowed execution time, every longer run is counted as overrun (0 = off)
+*/
+void isr_profiler_set_budget(uint8_t id, uint16_t cycles)
+{
+	if (id < ISR_PROFILER_VECTORS)
+	{
+		uint8_t sreg = SREG;
+		cli();
+		Profiles[id].exec_budget = cycles;
+		SREG = sreg;
+	}
+}
+
+/*
+	Adds one sample. Called by ISR_PROFILE_END() from within the ISR.
+*/
+void isr_profiler_record(uint8_t id, uint16_t latency, uint16_t exec_cycles)
+{
+	if (id >= ISR_PROFILER_VECTORS)
+		return;
+
+	isr_profile_t *p = &Profiles[id];
+
+	if (p->count != ISR_PROFILER_SATURATED)
+	{
+		p->count++;
+		p->exec_sum += exec_cycles;								// Average stays that of the first 65535 samples
+	}
+
+	if (latency < p->latency_min) p->latency_min = latency;
+	if (latency > p->latency_max) p->latency_max = latency;
+	if (exec_cycles < p->exec_min) p->exec_min = exec_cycles;
+	if (exec_cycles > p->exec_max) p->exec_max = exec_cycles;
+
+	if (p->exec_budget != 0 && exec_cycles > p->exec_budget)
+		count_saturated(&p->budget_overruns);
+
+	count_saturated(&p->latency_hist[log2_bin(latency)]);
+	count_saturated(&p->exec_hist[log2_bin(exec_cycles)]);
+}
+
+/*
+	Copies the profile of one vector (consistent snapshot).
+*/
+void isr_profiler_get(uint8_t id, isr_profile_t *profile)
+{
+	if (id >= ISR_PROFILER_VECTORS)
+		return;
+
+	uint8_t sreg = SREG;
+	cli();
+	*profile = Profiles[id];
+	SREG = sreg;
+}
+
+/*
+	Prints all profiles over Debug_USART. Blocking, run from main only.
+
+	Format per vector (n>=65535: counters saturated, avg of the first 65535 samples):
+	  <name> n=<count> lat=<min>/<max> exec=<min>/<avg>/<max> over=<budget overruns>
+	  lat  <2:12 <4:3 ...   (bin upper bound : samples)
+	  exec <128:950 <256:50 ...
+*/
+void isr_profiler_report(void)
+{
+	char line[80];
+	isr_profile_t p;
+
+	debug_usart_put_string("--- ISR profile (latency: timer counts, exec: CLK_PER cycles) ---\r\n");
+
+	for (uint8_t id = 0; id < Profile_Count; id++)
+	{
+		isr_profiler_get(id, &p);
+
+		if (p.count == 0)
+		{
+			sprintf(line, "%s n=0\r\n", Profile_Names[id]);
+			debug_usart_put_string(line);
+			continue;
+		}
+
+		sprintf(line, "%s n%s%u lat=%u/%u exec=%u/%lu/%u over=%u\r\n",
+		        Profile_Names[id], (p.count == ISR_PROFILER_SATURATED) ? ">=" : "=", p.count,
+		        p.latency_min, p.latency_max,
+		        p.exec_min, (unsigned long)(p.exec_sum / p.count), p.exec_max,
+		        p.budget_overruns);
+		debug_usart_put_string(line);
+
+		print_histogram("  lat ", p.latency_hist);
+		print_histogram("  exec", p.exec_hist);
+	}
+}
+
+/*
+	Handles a request character received from the host (main only).
+	'p' prints the report, 'r' resets the statistics.
+
+	@return true if the character was a profiler command
+*/
+bool isr_profiler_command(char c)
+{
+	if (c == 'p')
+	{
+		isr_profiler_report();
+	}
+	else if (c == 'r')
+	{
+		isr_profiler_reset();
+		debug_usart_put_string("ISR profile reset\r\n");
+	}
+	else
+	{
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,88 @@
+/*
+ * ISR_Profiler.h
+ *
+ * Opt-in latency and execution time profiler for interrupt service routines.
+ *
+ * For every profiled vector it records:
+ *  - entry latency: timer counts between the compare match and the first line of the ISR
+ *  - execution time: CLK_PER cycles from ISR_PROFILE_BEGIN to ISR_PROFILE_END
+ *  - count, min, max, sum and a log2 histogram of both values
+ *  - overruns of an optional cycle budget
+ *
+ * The 16-bit counters saturate at 65535 (about 65s for a 1kHz vector): from
+ * then on count and the execution time sum (average) stay at the first 65535
+ * samples, min/max keep being updated and histogram bins and overruns stop
+ * at 65535 each. The report marks a saturated profile with n>=65535.
+ *
+ * The execution time is taken from TCB1.CNT, so the Timestamp module must be running.
+ * Without ISR_PROFILER_ENABLE the macros expand to nothing and the ISR is unchanged.
+ *
+ * Usage:
+ *  #define ISR_PROFILER_ENABLE (before including this header, or as project symbol)
+ *
+ *  ISR(TCB0_INT_vect)
+ *  {
+ *      ISR_PROFILE_BEGIN(PROF_TCB0, TCB0.CNT);    // TCB0.CNT = counts since the match in periodic mode
+ *      ...
+ *      ISR_PROFILE_END(PROF_TCB0);
+ *  }
+ *
+ *  main: timestamp_init(); debug_usart_init(); isr_profiler_init(Names, count); sei();
+ *        while (1) { if (debug_usart_get_char(&c)) isr_profiler_command(c); ... }   // 'p' = report, 'r' = reset
+ */
+
+#ifndef ISR_PROFILER_H_
+#define ISR_PROFILER_H_
+
+#include <avr/io.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Maximum number of profiled vectors
+#ifndef ISR_PROFILER_VECTORS
+#define ISR_PROFILER_VECTORS 4
+#endif
+
+// Histogram bin n counts values v with 2^(n-1) <= v < 2^n (bin 0: v == 0)
+#define ISR_PROFILER_BINS 17
+
+#define ISR_PROFILER_SATURATED 0xFFFF
+
+typedef struct {
+	uint16_t count;								// Stops at ISR_PROFILER_SATURATED
+	uint16_t latency_min;
+	uint16_t latency_max;
+	uint16_t exec_min;
+	uint16_t exec_max;
+	uint32_t exec_sum;							// For the average, of the first count samples
+	uint16_t exec_budget;						// 0 = no budget
+	uint16_t budget_overruns;
+	uint16_t latency_hist[ISR_PROFILER_BINS];
+	uint16_t exec_hist[ISR_PROFILER_BINS];
+} isr_profile_t;
+
+#ifdef ISR_PROFILER_ENABLE
+
+#define ISR_PROFILE_BEGIN(id, latency) \
+	uint16_t isr_profile_start_ = TCB1.CNT; \
+	uint16_t isr_profile_latency_ = (uint16_t)(latency)
+
+#define ISR_PROFILE_END(id) \
+	isr_profiler_record((id), isr_profile_latency_, (uint16_t)(TCB1.CNT - isr_profile_start_))
+
+#else
+
+#define ISR_PROFILE_BEGIN(id, latency)
+#define ISR_PROFILE_END(id)
+
+#endif
+
+void isr_profiler_init(const char *const *names, uint8_t count);
+void isr_profiler_reset(void);
+void isr_profiler_set_budget(uint8_t id, uint16_t cycles);
+void isr_profiler_record(uint8_t id, uint16_t latency, uint16_t exec_cycles);
+void isr_profiler_get(uint8_t id, isr_profile_t *profile);
+void isr_profiler_report(void);
+bool isr_profiler_command(char c);
+
+#endif /* ISR_PROFILER_H_ */
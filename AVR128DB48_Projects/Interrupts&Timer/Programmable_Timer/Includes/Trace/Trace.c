@@ -0,0 +1,106 @@
+/*
+ * Trace.c
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "Trace.h"
+#include "../Debug_USART/Debug_USART.h"
+
+// VARIABLES //
+trace_record_t Trace_Buffer[TRACE_BUFFER_SIZE];
+volatile uint8_t Trace_Index = 0;							// Next slot (masked), wraps at 256
+volatile uint16_t Trace_Written = 0;						// Total records written, saturates so a full ring stays full
+volatile uint8_t Trace_Frozen = 0;							// Set while dumping, writes are ignored
+
+// PRIVATE FUNCTIONS //
+
+static void put_u16(uint16_t value)
+{
+	debug_usart_put_char((char)(value & 0xFF));
+	debug_usart_put_char((char)(value >> 8));
+}
+
+static void put_u32(uint32_t value)
+{
+	put_u16((uint16_t)value);
+	put_u16((uint16_t)(value >> 16));
+}
+
+// PUBLIC FUNCTIONS //
+
+void trace_init(void)
+{
+	trace_clear();
+}
+
+/*
+	Discards all records.
+*/
+void trace_clear(void)
+{
+	uint8_t sreg = SREG;
+	cli();
+	Trace_Index = 0;
+	Trace_Written = 0;
+	Trace_Frozen = 0;
+	SREG = sreg;
+}
+
+/*
+	Sends the buffer over Debug_USART (blocking, main only).
+	Recording is paused during the dump so the records stay consistent,
+	events in that time are not recorded.
+*/
+void trace_dump(void)
+{
+	uint8_t sreg = SREG;
+	cli();
+	Trace_Frozen = 1;
+	uint8_t index = Trace_Index;
+	uint16_t written = Trace_Written;
+	SREG = sreg;
+
+	uint8_t count = (written < TRACE_BUFFER_SIZE) ? (uint8_t)written : TRACE_BUFFER_SIZE;
+	uint8_t first = (uint8_t)(index - count) & TRACE_BUFFER_MASK;		// Oldest record
+
+	debug_usart_put_string("TRC1");
+	put_u32(F_CPU);
+	put_u16(written);
+	debug_usart_put_char((char)count);
+
+	for (uint8_t i = 0; i < count; i++)
+	{
+		const trace_record_t *r = &Trace_Buffer[(first + i) & TRACE_BUFFER_MASK];
+
+		debug_usart_put_char((char)r->id);
+		debug_usart_put_char((char)r->seq);
+		put_u16(r->arg);
+		put_u32(r->cycles);
+	}
+
+	Trace_Frozen = 0;
+}
+
+/*
+	Handles a request character received from the host (main only).
+	't' dumps the buffer, 'c' clears it.
+
+	@return true if the character was a trace command
+*/
+bool trace_command(char c)
+{
+	if (c == 't')
+	{
+		trace_dump();
+	}
+	else if (c == 'c')
+	{
+		trace_clear();
+	}
+	else
+	{
+		return false;
+	}
+	return true;
+}
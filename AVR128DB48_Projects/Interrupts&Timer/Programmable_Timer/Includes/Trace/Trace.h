@@ -0,0 +1,100 @@
+/*
+ * Trace.h
+ *
+ * Compact binary event trace.
+ *
+ * TRACE(id, arg) stores a fixed-size record (event id, 16-bit argument,
+ * 32-bit cycle timestamp from the Timestamp module) in a RAM ring buffer.
+ * The buffer always holds the newest TRACE_BUFFER_SIZE records. On request the
+ * buffer is dumped over Debug_USART and Tools/trace_decode.py turns the dump
+ * into a Chrome trace (chrome://tracing or https://ui.perfetto.dev).
+ *
+ * Without TRACE_ENABLE the TRACE() macro compiles to nothing.
+ *
+ * Usage:
+ *  #define TRACE_ENABLE (before including this header, or as project symbol)
+ *  enum { TRC_BUTTON = 1, TRC_LCD_BEGIN, TRC_LCD_END };   // ids, names ending in _BEGIN/_END become spans
+ *  main: timestamp_init(); debug_usart_init(); trace_init(); sei();
+ *        while (1) { if (debug_usart_get_char(&c)) trace_command(c); ... }   // 't' = dump, 'c' = clear
+ *  anywhere (ISR or main): TRACE(TRC_BUTTON, 4);
+ *
+ * Dump format (little endian):
+ *  "TRC1", uint32 F_CPU, uint16 total records written (stops at 65535), uint8 record count,
+ *  then <count> records of 8 bytes, oldest first: uint8 id, uint8 seq, uint16 arg, uint32 cycles
+ */
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "../Timestamp/Timestamp.h"
+
+// Number of records kept (8 bytes each). Must be a power of 2 and at most 128.
+#ifndef TRACE_BUFFER_SIZE
+#define TRACE_BUFFER_SIZE 64
+#endif
+
+#define TRACE_BUFFER_MASK (TRACE_BUFFER_SIZE - 1)
+
+#if (TRACE_BUFFER_SIZE & TRACE_BUFFER_MASK) != 0 || TRACE_BUFFER_SIZE > 128
+#error "TRACE_BUFFER_SIZE must be a power of 2 and <= 128"
+#endif
+
+typedef struct {
+	uint8_t  id;						// Application event id (0 is reserved)
+	uint8_t  seq;						// Write index (wraps at 256), lets the decoder spot gaps
+	uint16_t arg;						// Event argument
+	uint32_t cycles;					// timestamp_cycles() when the event was recorded
+} trace_record_t;
+
+// Shared with the inline writer below, do not use directly
+extern trace_record_t Trace_Buffer[TRACE_BUFFER_SIZE];
+extern volatile uint8_t Trace_Index;
+extern volatile uint16_t Trace_Written;
+extern volatile uint8_t Trace_Frozen;
+
+/*
+	Appends one record. Safe in ISRs and main: interrupts are disabled only while
+	the timestamp is taken and the slot is claimed and filled, so the records
+	are in timestamp order.
+*/
+static inline void trace_write(uint8_t id, uint16_t arg)
+{
+	uint8_t sreg = SREG;
+	cli();
+
+	if (!Trace_Frozen)
+	{
+		uint8_t index = Trace_Index;
+		trace_record_t *r = &Trace_Buffer[index & TRACE_BUFFER_MASK];
+
+		r->id = id;
+		r->seq = index;
+		r->arg = arg;
+		r->cycles = timestamp_cycles();				// Nests its own SREG save / restore
+		Trace_Index = index + 1;
+
+		if (Trace_Written != 0xFFFF)
+		{
+			Trace_Written++;
+		}
+	}
+
+	SREG = sreg;
+}
+
+#ifdef TRACE_ENABLE
+#define TRACE(id, arg) trace_write((id), (uint16_t)(arg))
+#else
+#define TRACE(id, arg) ((void)sizeof((id) + (arg)))		// Not evaluated, keeps arguments "used"
+#endif
+
+void trace_init(void);
+void trace_clear(void);
+void trace_dump(void);
+bool trace_command(char c);
+
+#endif /* TRACE_H_ */
@@ -12,13 +12,29 @@
 #include <stdio.h>
 #include <string.h>
 #include "I2C_LCD.h" // For LCD functions
+#include "Event_Queue.h" // ISR -> main event queue
+#include "Debounce.h" // Vertical counter debouncer for port C
 
 // Define the clock frequency (4 MHz)
 #define F_CPU 4000000UL 
 
+// Uncomment to profile the TCB0 ISR. Send 'p' over USART3 (9600 baud) for a report, 'r' to reset.
+//#define ISR_PROFILER_ENABLE
+
+// Uncomment to record an event trace. Send 't' over USART3 to dump it (decode with Tools/trace_decode.py), 'c' to clear.
+//#define TRACE_ENABLE
+
+#if defined(ISR_PROFILER_ENABLE) || defined(TRACE_ENABLE)
+#define DEBUG_PORT_USED
+#include "Timestamp.h"
+#include "Debug_USART.h"
+#endif
+#include "ISR_Profiler.h"
+#include "Trace.h"
+
 // --- Configuration Constants ---
 #define MS_PER_SECOND 1000
-#define MS_DEBOUNCE_MAX 10 // 10ms for stable button reading
+#define BUTTONS_MASK (PIN4_bm | PIN5_bm) // PC4 (Add Time), PC5 (Start/Pause)
 #define TIME_ADD_SECONDS 5 // Amount of time to add with PC4
 
 // --- State Definitions ---
@@ -29,6 +45,29 @@ typedef enum {
     TIMER_EXPIRED
 } timer_state_t;
 
+// --- Event Definitions (posted by the ISR, handled in main) ---
+
+typedef enum {
+    EVENT_BUTTON = 1,   // Stable rising edge, source = pin number (4 or 5)
+    EVENT_SECOND,       // One second of the countdown elapsed
+    EVENT_EXPIRED,      // Countdown reached zero
+    EVENT_TYPE_COUNT
+} app_event_t;
+
+// Profiled vectors
+enum {
+    PROF_TCB0,
+    PROF_COUNT
+};
+
+// Trace event ids (_BEGIN/_END pairs are shown as spans by the decoder)
+enum {
+    TRC_BUTTON = 1,     // arg = pin number
+    TRC_STATE,          // arg = new timer_state_t
+    TRC_LCD_BEGIN,      // arg = seconds shown
+    TRC_LCD_END
+};
+
 // --- Global Volatile Variables (Shared with ISR) ---
 
 // **Timer Variables**
@@ -36,18 +75,8 @@ volatile timer_state_t G_Timer_State = TIMER_EXPIRED;
 volatile uint32_t G_Remaining_Seconds = 0;
 volatile uint16_t G_ms_Accumulator = 0; // Counts 0 to 999 for 1 second
 
-// Flag to determine if the string that will be printed changed
-volatile bool G_Status_Changed = true;
-
-// **Button Debounce Variables (PC4: Add Time)**
-volatile bool G_PC4_Stable_State = false; 
-volatile uint8_t G_PC4_Debounce_Counter = 0;
-volatile bool G_PC4_Request = false; 
-
-// **Button Debounce Variables (PC5: Start/Pause)**
-volatile bool G_PC5_Stable_State = false;
-volatile uint8_t G_PC5_Debounce_Counter = 0;
-volatile bool G_PC5_Request = false;
+// **Button Debounce State (port C, only used by the ISR)**
+static debounce_t G_Buttons;
 
 // --- Hardware Control Macros ---
 
@@ -60,7 +89,7 @@ volatile bool G_PC5_Request = false;
 // --- Function Declarations ---
 static void update_display(uint32_t seconds, timer_state_t state);
 static void update_led(timer_state_t state);
-static void handle_button_debounce(uint8_t pin_value, volatile bool *stable_state, volatile uint8_t *counter, volatile bool *request_flag);
+static void refresh_outputs(void);
 
 // --- Timer Initialization ---
 
@@ -82,25 +111,30 @@ void timer_init(void)
 /**
  * @brief Timer/Counter B0 (TCB0) Interrupt Service Routine (1ms tick).
  * * Handles button debouncing and second-level timing logic.
+ * Results are posted as events, so no press or second is lost while main is busy with the LCD.
  */
 ISR(TCB0_INT_vect)
 {
-	TCB0.INTFLAGS = TCB_CAPT_bm; // Clear the interrupt flag
+	ISR_PROFILE_BEGIN(PROF_TCB0, TCB0.CNT); // TCB0.CNT = cycles since the compare match (entry latency)
 	
-	// --- 1. Debounce Logic for PC4 (Add Time) and PC5 (Start/Pause) ---
-	uint8_t current_portc_in = PORTC.IN;
+	TCB0.INTFLAGS = TCB_CAPT_bm; // Clear the interrupt flag
+	event_tick();                // Advance event timestamps (1ms)
 	
-	// Handle PC4 (Add Time)
-	handle_button_debounce((current_portc_in & PIN4_bm), 
-	                       &G_PC4_Stable_State, 
-	                       &G_PC4_Debounce_Counter, 
-	                       &G_PC4_Request);
+	// --- 1. Debounce Logic for PC4 (Add Time) and PC5 (Start/Pause), both pins at once ---
+	uint8_t changed = debounce_update(&G_Buttons, PORTC.IN & BUTTONS_MASK);
+	uint8_t pressed = DEBOUNCE_PRESSED(&G_Buttons, changed);
 	
-	// Handle PC5 (Start/Pause)
-	handle_button_debounce((current_portc_in & PIN5_bm), 
-	                       &G_PC5_Stable_State, 
-	                       &G_PC5_Debounce_Counter, 
-	                       &G_PC5_Request);
+	// Queue every stable rising edge, source = pin number
+	if (pressed & PIN4_bm)
+	{
+		TRACE(TRC_BUTTON, 4);
+		event_post(EVENT_BUTTON, 4, 0);
+	}
+	if (pressed & PIN5_bm)
+	{
+		TRACE(TRC_BUTTON, 5);
+		event_post(EVENT_BUTTON, 5, 0);
+	}
 	
 	// --- 2. Timing Logic (Executed every 1ms) ---
 	if (G_Timer_State == TIMER_RUNNING)
@@ -117,55 +151,20 @@ ISR(TCB0_INT_vect)
 			if (G_Remaining_Seconds > 0)
 			{
 				G_Remaining_Seconds--;
-				G_Status_Changed = true;						// Signal main loop for display update
+				event_post(EVENT_SECOND, 0, (uint16_t)G_Remaining_Seconds);	// Signal main loop for display update
 			}
 			
 			// Check for timer expiration
 			if (G_Remaining_Seconds == 0)
 			{
 				G_Timer_State = TIMER_EXPIRED;
-				G_Status_Changed = true;						// Signal main loop for display update
-			}
-		}
-	}
-}
-
-/**
- * @brief Generic debounce and rising edge detection logic.
- * Sets the request_flag upon a stable rising edge.
- */
-static void handle_button_debounce(uint8_t pin_value, volatile bool *stable_state, volatile uint8_t *counter, volatile bool *request_flag)
-{
-    // Button is pressed if pin_value is non-zero
-	bool current_raw_state = (pin_value != 0);
-
-	if (current_raw_state != *stable_state)
-	{
-		if (*counter < MS_DEBOUNCE_MAX)
-		{
-			(*counter)++;
-		}
-		
-		if (*counter >= MS_DEBOUNCE_MAX)
-		{
-			// Stable edge reached
-			
-			// 1. Check for RISING EDGE
-			if (current_raw_state == true)
-			{
-				*request_flag = true; // **ISR sets button request flag**
+				TRACE(TRC_STATE, TIMER_EXPIRED);
+				event_post(EVENT_EXPIRED, 0, 0);				// Signal main loop for display update
 			}
-			
-			// 2. Update the stable state and reset counter
-			*stable_state = current_raw_state;
-			*counter = 0;
 		}
 	}
-	else
-	{
-		// State matches stable state, reset counter to wait for a change
-		*counter = 0;
-	}
+	
+	ISR_PROFILE_END(PROF_TCB0);
 }
 
 // --- Display and LED Control Functions (Run in main) ---
@@ -210,12 +209,84 @@ static void update_display(uint32_t seconds, timer_state_t state)
 }
 
 
+/**
+ * @brief Redraws LCD and LED from a consistent snapshot of the shared timer state.
+ */
+static void refresh_outputs(void)
+{
+	cli();
+	uint32_t seconds = G_Remaining_Seconds;
+	timer_state_t state = G_Timer_State;
+	sei();
+	
+	TRACE(TRC_LCD_BEGIN, seconds);
+	update_display((state == TIMER_EXPIRED) ? 0 : seconds, state);
+	update_led(state);
+	TRACE(TRC_LCD_END, 0);
+}
+
+// --- Event Handlers (Run in main) ---
+
+/**
+ * @brief PC5 toggles Start/Pause, PC4 adds TIME_ADD_SECONDS.
+ */
+static void on_button(const event_t *event)
+{
+	// Critical Section: Protect shared state variables
+	cli();
+	if (event->source == 5)
+	{
+		if (G_Timer_State == TIMER_RUNNING) {
+			G_Timer_State = TIMER_PAUSED;						// Pause
+		} else if (G_Remaining_Seconds > 0) {
+			G_Timer_State = TIMER_RUNNING;						// Start
+		} else if (G_Timer_State == TIMER_EXPIRED) {
+			// If expired, pressing start/pause resets it to PAUSED
+			G_Remaining_Seconds = 0; 
+			G_Timer_State = TIMER_PAUSED;
+		}
+	}
+	else if (event->source == 4)
+	{
+		G_Remaining_Seconds += TIME_ADD_SECONDS;				// **Add time**
+		
+		// If we add time while expired, we reset the state to PAUSED
+		if (G_Timer_State == TIMER_EXPIRED) {
+			G_Timer_State = TIMER_PAUSED;
+			G_ms_Accumulator = 0;								// Clear ms counter too
+		}
+	}
+	timer_state_t new_state = G_Timer_State;
+	sei();
+	
+	TRACE(TRC_STATE, new_state);
+	refresh_outputs();
+}
+
+/**
+ * @brief A second elapsed or the countdown expired: redraw.
+ */
+static void on_timer_update(const event_t *event)
+{
+	(void)event;
+	refresh_outputs();
+}
+
+// Handler table, indexed by app_event_t
+static const event_handler_t Event_Handlers[EVENT_TYPE_COUNT] = {
+	[EVENT_BUTTON]  = on_button,
+	[EVENT_SECOND]  = on_timer_update,
+	[EVENT_EXPIRED] = on_timer_update,
+};
+
+
 int main(void)
 {
 	// --- Port Configuration ---
 	PORTC.DIRCLR = PIN4_bm | PIN5_bm; // Set PC4 and PC5 as inputs (buttons)
 	PORTC.PIN4CTRL = 0x00;           
 	PORTC.PIN5CTRL = 0x00;
+	debounce_init(&G_Buttons, PORTC.IN & BUTTONS_MASK);
 	
 	// Set PE0 (R), PE1 (G), and PE2 (B) as output (RGB LED)
 	PORTE.DIRSET = PIN0_bm | PIN1_bm | PIN2_bm;
@@ -238,79 +309,40 @@ int main(void)
 	update_led(G_Timer_State);									// Initialize LED to blue
 	update_display(G_Remaining_Seconds, G_Timer_State);
 	
+#ifdef DEBUG_PORT_USED
+	timestamp_init();
+	debug_usart_init();
+#endif
+#ifdef ISR_PROFILER_ENABLE
+	static const char *const Profile_Names[PROF_COUNT] = { "TCB0" };
+	isr_profiler_init(Profile_Names, PROF_COUNT);
+	isr_profiler_set_budget(PROF_TCB0, 400);					// 10% of the 1ms tick
+#endif
+#ifdef TRACE_ENABLE
+	trace_init();
+#endif
+	
+	event_queue_init();
 	timer_init();
 	sei();														// Enable global interrupts
 	
     while (1) 
     {
-        // --- 1. Handle START/PAUSE Request (PC5) ---
-        if (G_PC5_Request)
-        {
-            G_PC5_Request = false;									// Consume request
-            
-            // Critical Section: Protect shared state variables
-            cli();
-            if (G_Timer_State == TIMER_RUNNING) {
-                G_Timer_State = TIMER_PAUSED;						// Pause
-            } else if (G_Remaining_Seconds > 0) {
-                G_Timer_State = TIMER_RUNNING;						// Start
-            } else if (G_Timer_State == TIMER_EXPIRED) {
-                // If expired, pressing start/pause resets it to PAUSED
-                G_Remaining_Seconds = 0; 
-                G_Timer_State = TIMER_PAUSED;
-            }
-            sei();
-            
-            update_display(G_Remaining_Seconds, G_Timer_State);
-            update_led(G_Timer_State);
-        }
-        
-        // --- 2. Handle ADD 5s Request (PC4) ---
-        if (G_PC4_Request)
-        {
-            G_PC4_Request = false; // Consume request
-            
-            // Critical Section: Protect shared seconds counter
-            cli();
-            G_Remaining_Seconds += TIME_ADD_SECONDS; // **Add time**
-			G_Status_Changed = true;
-            
-            // If we add time while expired, we reset the state to PAUSED
-            if (G_Timer_State == TIMER_EXPIRED) {
-                G_Timer_State = TIMER_PAUSED;
-                G_ms_Accumulator = 0; // Clear ms counter too
-            }
-            sei();
-        }
-		
-        // --- 3. Handle Timer Expiration or Second Update (ISR Trigger) ---
+        // Every event posted by the ISR is handled exactly once, in the order it happened.
+        event_dispatch(Event_Handlers, EVENT_TYPE_COUNT);
 		
-        // Check for state changes set by the ISR
-        if (G_Timer_State == TIMER_EXPIRED)
+#ifdef DEBUG_PORT_USED
+        // Diagnostic requests from the host
+        char Cmd;
+        if (debug_usart_get_char(&Cmd))
         {
-			if (G_Status_Changed)
-			{
-				// Reading the time is not strictly atomic here since it's checked right after
-				// the flag is set, but cli/sei on the read ensures safety.
-				cli();
-				G_Status_Changed = false;
-				sei();
-				
-				update_display(0, G_Timer_State);
-				update_led(G_Timer_State);
-			}
+#ifdef ISR_PROFILER_ENABLE
+            isr_profiler_command(Cmd);
+#endif
+#ifdef TRACE_ENABLE
+            trace_command(Cmd);
+#endif
         }
-        else 
-		{
-			if (G_Status_Changed) 
-			{
-				cli();
-				G_Status_Changed = false; 
-				sei();
-
-				update_display(G_Remaining_Seconds, G_Timer_State);
-				update_led(G_Timer_State);
-			}
-		}
+#endif
     }
 }
\ No newline at end of file
@@ -0,0 +1,273 @@
+/*
+ * RTC_Clock.c
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/cpufunc.h>
+#include "RTC_Clock.h"
+
+#define XOSC32K_STARTUP_LOOPS 60000UL				// ~0.5s at 4MHz before falling back to OSC32K
+#define CALIBRATION_DEADBAND_PPM 1000				// Do not tune for errors below 0.1% (about one TUNE step)
+#define OSCHFTUNE_MIN (-32)
+#define OSCHFTUNE_MAX 31
+
+// PIT event on EVSYS channel 1 (odd channels offer DIV64 ... DIV512)
+#if RTC_CLOCK_PIT_DIV == 512
+#define PIT_EVENT EVSYS_CHANNEL1_RTC_PIT_DIV512_gc
+#elif RTC_CLOCK_PIT_DIV == 256
+#define PIT_EVENT EVSYS_CHANNEL1_RTC_PIT_DIV256_gc
+#elif RTC_CLOCK_PIT_DIV == 128
+#define PIT_EVENT EVSYS_CHANNEL1_RTC_PIT_DIV128_gc
+#else
+#define PIT_EVENT EVSYS_CHANNEL1_RTC_PIT_DIV64_gc
+#endif
+
+#define PIT_EVENTS_PER_SECOND (RTC_CLOCK_HZ / RTC_CLOCK_PIT_DIV)
+
+// VARIABLES //
+static volatile uint32_t Seconds = 0;
+static rtc_clock_callback_t Second_Callback = 0;
+static bool Crystal_Running = false;
+
+// Calibration, main only
+static uint32_t Cycles_Per_Second = F_CPU;			// From the last TCB3 capture
+static bool Measured = false;						// Cycles_Per_Second holds a measurement
+static bool Skip_Capture = true;					// The next capture may be partial or mix two TUNE settings
+
+// PRIVATE FUNCTIONS //
+
+/*
+	Starts the external 32.768kHz crystal and waits for it to become stable.
+	@return true if the crystal is running
+*/
+static bool xosc32k_start(void)
+{
+	ccp_write_io((void *)&CLKCTRL.XOSC32KCTRLA, CLKCTRL_ENABLE_bm | CLKCTRL_RUNSTDBY_bm | CLKCTRL_CSUT_1K_gc);
+
+	for (uint32_t i = 0; i < XOSC32K_STARTUP_LOOPS; i++)
+	{
+		if (CLKCTRL.MCLKSTATUS & CLKCTRL_XOSC32KS_bm)
+			return true;
+	}
+
+	ccp_write_io((void *)&CLKCTRL.XOSC32KCTRLA, 0);	// No crystal, switch it off again
+	return false;
+}
+
+/*
+	TCB3 counts CLK_PER and captures the count at every rising edge of the
+	PIT event (frequency measurement mode), no interrupt.
+*/
+static void capture_init(void)
+{
+	TCB3.CTRLA = 0;
+	TCB3.CTRLB = TCB_CNTMODE_FRQ_gc;
+	TCB3.EVCTRL = TCB_CAPTEI_bm;
+	TCB3.INTCTRL = 0;
+	TCB3.INTFLAGS = TCB_CAPT_bm | TCB_OVF_bm;
+	TCB3.CTRLA = TCB_CLKSEL_DIV1_gc | TCB_ENABLE_bm;
+
+	EVSYS.CHANNEL1 = PIT_EVENT;
+	EVSYS.USERTCB3CAPT = EVSYS_USER_CHANNEL1_gc;
+}
+
+/*
+	Takes the latest TCB3 capture if there is a new one.
+*/
+static void capture_update(void)
+{
+	if (TCB3.INTFLAGS & TCB_OVF_bm)					// A period did not fit into 16 bits, the capture is wrong
+	{
+		TCB3.INTFLAGS = TCB_CAPT_bm | TCB_OVF_bm;
+		Skip_Capture = true;
+		return;
+	}
+
+	if (!(TCB3.INTFLAGS & TCB_CAPT_bm))
+		return;
+
+	uint16_t period = TCB3.CCMP;					// Reading CCMP clears CAPT
+
+	if (Skip_Capture)
+	{
+		Skip_Capture = false;
+		return;
+	}
+
+	Cycles_Per_Second = (uint32_t)period * PIT_EVENTS_PER_SECOND;
+	Measured = true;
+}
+
+// PUBLIC FUNCTIONS //
+
+/*
+	Selects the 32.768kHz source, starts the RTC counter with one overflow
+	interrupt per second and the calibration capture.
+
+	@param use_crystal Try the external crystal first
+	@return true if the crystal is used, false if the internal OSC32K is used
+*/
+bool rtc_clock_init(bool use_crystal)
+{
+	Crystal_Running = use_crystal && xosc32k_start();
+
+	while (RTC.STATUS || RTC.PITSTATUS)				// Wait for pending synchronizations
+	{
+		;
+	}
+
+	// The clock source can only be changed while RTC and PIT are off
+	RTC.PITCTRLA = 0;
+	RTC.CTRLA = 0;
+	while (RTC.STATUS || RTC.PITSTATUS)
+	{
+		;
+	}
+	RTC.CLKSEL = Crystal_Running ? RTC_CLKSEL_XOSC32K_gc : RTC_CLKSEL_OSC32K_gc;
+
+	Seconds = 0;
+	Measured = false;
+	Skip_Capture = true;
+
+	RTC.CNT = 0;
+	RTC.PER = (uint16_t)(RTC_CLOCK_HZ - 1);			// 32768 ticks = 1 second
+	RTC.INTFLAGS = RTC_OVF_bm;
+	RTC.INTCTRL = RTC_OVF_bm;
+	while (RTC.STATUS)
+	{
+		;
+	}
+	RTC.CTRLA = RTC_PRESCALER_DIV1_gc | RTC_RUNSTDBY_bm | RTC_RTCEN_bm;
+
+	// The PIT only provides the calibration event, its interrupt stays off
+	RTC.PITINTCTRL = 0;
+	RTC.PITCTRLA = RTC_PERIOD_CYC32768_gc | RTC_PITEN_bm;
+
+	capture_init();
+
+	return Crystal_Running;
+}
+
+/*
+	Registers a function that is called from the RTC overflow ISR once per second (NULL to remove).
+*/
+void rtc_clock_set_callback(rtc_clock_callback_t callback)
+{
+	uint8_t sreg = SREG;
+	cli();
+	Second_Callback = callback;
+	SREG = sreg;
+}
+
+/*
+	@return Seconds since rtc_clock_init()
+*/
+uint32_t rtc_clock_seconds(void)
+{
+	uint8_t sreg = SREG;
+	cli();
+	uint32_t s = Seconds;
+	SREG = sreg;
+
+	return s;
+}
+
+/*
+	Returns the current time with millisecond resolution.
+
+	@param seconds Whole seconds since rtc_clock_init()
+	@param millis  Fraction of the current second (0 ... 999)
+*/
+void rtc_clock_now(uint32_t *seconds, uint16_t *millis)
+{
+	uint8_t sreg = SREG;
+	cli();
+	uint32_t s = Seconds;
+	uint16_t count = RTC.CNT;
+
+	if (RTC.INTFLAGS & RTC_OVF_bm)					// Overflow not handled yet: count may be from before or after it
+	{
+		count = RTC.CNT;							// Surely after it now
+		s++;
+	}
+	SREG = sreg;
+
+	*seconds = s;
+	*millis = (uint16_t)(((uint32_t)count * 1000UL) >> 15);		// count / 32768 s
+}
+
+/*
+	@return CLK_PER cycles per reference second, from the last calibration capture
+	        (F_CPU until measured). Main only.
+*/
+uint32_t rtc_clock_cycles_per_second(void)
+{
+	capture_update();
+	return Cycles_Per_Second;
+}
+
+/*
+	@return Deviation of the main clock from F_CPU in ppm (positive = too fast). Main only.
+*/
+int32_t rtc_clock_error_ppm(void)
+{
+	int32_t diff = (int32_t)rtc_clock_cycles_per_second() - (int32_t)F_CPU;
+
+	return (int32_t)((int64_t)diff * 1000000LL / (int64_t)F_CPU);
+}
+
+/*
+	Moves CLKCTRL.OSCHFTUNE one step towards the nominal F_CPU.
+	Call about once per second from main, each call uses the latest capture.
+	Only done with the crystal: the internal OSC32K is less accurate than the main oscillator.
+
+	@return true if the tuning was changed
+*/
+bool rtc_clock_calibrate(void)
+{
+	if (!Crystal_Running)
+		return false;
+
+	int32_t error = rtc_clock_error_ppm();
+
+	if (!Measured)
+		return false;
+
+	int8_t tune = (int8_t)CLKCTRL.OSCHFTUNE;
+
+	if (error > CALIBRATION_DEADBAND_PPM && tune > OSCHFTUNE_MIN)
+	{
+		tune--;											// Too fast
+	}
+	else if (error < -CALIBRATION_DEADBAND_PPM && tune < OSCHFTUNE_MAX)
+	{
+		tune++;											// Too slow
+	}
+	else
+	{
+		return false;
+	}
+
+	ccp_write_io((void *)&CLKCTRL.OSCHFTUNE, (uint8_t)tune);
+
+	TCB3.INTFLAGS = TCB_CAPT_bm;						// Captures so far are from the old setting
+	Measured = false;
+	Skip_Capture = true;								// The next one mixes old and new setting
+	return true;
+}
+
+/*
+	One second elapsed on the 32.768kHz reference.
+*/
+ISR(RTC_CNT_vect)
+{
+	RTC.INTFLAGS = RTC_OVF_bm;
+
+	Seconds++;
+
+	if (Second_Callback)
+	{
+		Second_Callback(Seconds);
+	}
+}
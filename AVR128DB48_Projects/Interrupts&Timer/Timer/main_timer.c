@@ -10,23 +10,17 @@
 #include <stdbool.h> // For the boolean flag
 #include <stdint.h>  // For uint16_t and uint32_t
 #include "I2C_LCD.h" // For LCD functions
+#include "Event_Queue.h" // ISR -> main event queue
+#include "RTC_Clock.h" // Seconds from the RTC counter (1 interrupt per second)
 
 // Define the clock frequency (4 MHz as per your I2C files)
 #define F_CPU 4000000UL 
 
-// The TCB is configured to overflow every 1ms (1kHz).
-// We need 1000 such events to make 1 second.
-#define MS_PER_SECOND 1000
-
-// --- Global State Variables ---
-// Flag set by the ISR when 1ms has elapsed
-volatile bool G_Second_Changed = false;
-
-// Variable to store the running count of seconds
-volatile uint32_t G_Second_Counter = 0;
-
-// Variable to store the running count of milliseconds (0 to 999)
-volatile uint16_t G_ms_Accumulator = 0;
+// --- Event Definitions ---
+typedef enum {
+	EVENT_SECOND = 1,		// A full second elapsed, payload = low 16 bits of the second counter
+	EVENT_TYPE_COUNT
+} app_event_t;
 
 
 void to_str(uint32_t num, char *str) {
@@ -62,55 +56,55 @@ void to_str(uint32_t num, char *str) {
 }
 
 /**
- * @brief Initializes Timer/Counter B0 (TCB0) for 1ms periodic interrupts.
- * * TCB0 is configured in Periodic Interrupt Mode to interrupt at a 1kHz frequency (1ms).
- * CLK_PER = 4 MHz. We need a count value (CCMP) such that:
- * TCB0_Frequency = CLK_PER / (CCMP + 1)
- * 1000 Hz = 4,000,000 Hz / (CCMP + 1)
- * CCMP + 1 = 4000
- * CCMP = 3999
+ * @brief Called by the RTC overflow interrupt once per second.
+ * * The old 1ms TCB0 tick (1000 interrupts per second) is replaced by this one interrupt, TCB0 is free.
+ * Only posts an event, the LCD is updated in the main loop.
+ * There is no 1ms tick any more, so event_tick() is not called and event timestamps stay 0
+ * (the handlers only use the payload).
  */
-void timer_init(void)
+static void second_elapsed(uint32_t seconds)
 {
-	// 1. Set the compare value for 1ms
-	TCB0.CCMP = 3999;
-	
-	// 2. Configure TCB in Periodic Interrupt Mode (CLKSEL = CLK_PER, MODE = Periodic)
-	TCB0.CTRLA = TCB_CLKSEL_DIV1_gc; // No prescaler, use CLK_PER
-	TCB0.CTRLB = TCB_CNTMODE_INT_gc; // Set to Periodic Interrupt Mode (INT)
-	
-	// 3. Enable the interrupt
-	TCB0.INTCTRL = TCB_CAPT_bm; // Enable Capture/Compare interrupt
-	
-	// 4. Enable the timer
-	TCB0.CTRLA |= TCB_ENABLE_bm; 
+	// Tell the main loop a second has passed (queued, so none is missed during a slow LCD update)
+	event_post(EVENT_SECOND, 0, (uint16_t)seconds);
 }
 
 
 /**
- * @brief Timer/Counter B0 (TCB0) Interrupt Service Routine.
- * * This ISR executes exactly every 1ms. Its only job is to update the
- * millisecond accumulator and second counter, and set a flag for the main loop.
+ * @brief Shows the second counter and the measured main clock error on the LCD.
  */
-ISR(TCB0_INT_vect)
+static void on_second(const event_t *event)
 {
-	// 1. Clear the interrupt flag (mandatory)
-	TCB0.INTFLAGS = TCB_CAPT_bm;
+	(void)event;
 	
-	// 2. Increment the millisecond accumulator
-	G_ms_Accumulator++;
+	uint32_t Seconds = rtc_clock_seconds();
+	int32_t Error_ppm = rtc_clock_error_ppm();
 	
-	// 3. Check if a full second has elapsed (1000ms)
-	if (G_ms_Accumulator >= MS_PER_SECOND)
-	{
-		G_ms_Accumulator = 0;
-		G_Second_Counter++;
-		
-		// Set flag for the main loop to know a second has passed
-		G_Second_Changed = true;
-	}
+	// Trim the main oscillator against the 32.768kHz crystal (measured by TCB3 in hardware, one step per second at most)
+	rtc_clock_calibrate();
+	
+	char Str[12];
+	
+	lcd_clear();
+	
+	// First line: deviation of the 4MHz clock, e.g. "Clk -2400ppm"
+	lcd_moveCursor(0, 0);
+	lcd_putString(Error_ppm < 0 ? "Clk -" : "Clk +");
+	to_str((uint32_t)(Error_ppm < 0 ? -Error_ppm : Error_ppm), Str);
+	lcd_putString(Str);
+	lcd_putString("ppm");
+	
+	to_str(Seconds, Str);
+	
+	// Move cursor to the second line and display the string
+	lcd_moveCursor(0, 1);
+	lcd_putString(Str);
 }
 
+// Handler table, indexed by app_event_t
+static const event_handler_t Event_Handlers[EVENT_TYPE_COUNT] = {
+	[EVENT_SECOND] = on_second,
+};
+
 
 int main(void)
 {
@@ -126,31 +120,18 @@ int main(void)
 		} 
 	}
 
-	timer_init();
+	event_queue_init();
+	
+	// Seconds from the 32.768kHz crystal (falls back to the internal OSC32K)
+	rtc_clock_init(true);
+	rtc_clock_set_callback(second_elapsed);
     sei(); // Enable global interrupts
 	
     while (1) 
     {
-		// Second Update Check
-		// Check the flag set by the ISR every time a full second (1000ms) has passed.
-		if (G_Second_Changed)
-		{
-			// Reset the flag immediately
-			G_Second_Changed = false;
-
-			cli();
-			sei();
-				
-			char Str[12];
-				
-			to_str(G_Second_Counter, Str);
-				
-			lcd_clear();
-			// Move cursor to the second line and display the string
-			lcd_moveCursor(0, 1);
-			lcd_putString(Str);
-		}
+		// Handle every EVENT_SECOND posted by the ISR (one per elapsed second)
+		event_dispatch(Event_Handlers, EVENT_TYPE_COUNT);
 		
-		// Idle loop continues to run here, waiting for G_1ms_Flag to be set
+		// Idle loop continues to run here, waiting for the next event
     }
 }
\ No newline at end of file
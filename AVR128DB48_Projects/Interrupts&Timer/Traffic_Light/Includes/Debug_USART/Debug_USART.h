@@ -0,0 +1,32 @@
+/*
+ * Debug_USART.h
+ *
+ * Minimal polled USART3 for diagnostic output (profiler reports, trace dumps).
+ * Uses the Curiosity Nano virtual COM port: PB0 = TX, PB1 = RX, 8N1.
+ *
+ * The functions busy-wait on the hardware, so only call them from main
+ * and only for diagnostics. Application traffic should use an interrupt driven driver.
+ */
+
+#ifndef DEBUG_USART_H_
+#define DEBUG_USART_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef F_CPU
+#define F_CPU 4000000UL
+#endif
+
+// Up to F_CPU / 8 (double speed mode above F_CPU / 16), the build fails if USART_BAUD_CHECK() rejects the rate
+#ifndef DEBUG_USART_BAUD
+#define DEBUG_USART_BAUD 9600UL
+#endif
+
+void debug_usart_init(void);
+void debug_usart_put_char(char c);
+void debug_usart_put_string(const char *str);
+void debug_usart_put_bytes(const uint8_t *data, uint16_t length);
+bool debug_usart_get_char(char *c);
+
+#endif /* DEBUG_USART_H_ */
@@ -9,13 +9,29 @@
 #include <avr/interrupt.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include "Debounce.h"
 
 // Define the clock frequency (4 MHz)
 #define F_CPU 4000000UL 
 
+// Uncomment to profile the TCB0 ISR. Send 'p' over USART3 (9600 baud) for a report, 'r' to reset.
+//#define ISR_PROFILER_ENABLE
+
+#ifdef ISR_PROFILER_ENABLE
+#include "Timestamp.h"
+#include "Debug_USART.h"
+#endif
+#include "ISR_Profiler.h"
+
+// Profiled vectors
+enum {
+    PROF_TCB0,
+    PROF_COUNT
+};
+
 // --- Configuration Constants ---
 #define MS_PER_SECOND 1000
-#define MS_DEBOUNCE_MAX 10 // 10ms for stable button reading
+#define BUTTONS_MASK (PIN4_bm | PIN5_bm) // PC4 (Request GREEN), PC5 (Request RED)
 
 // Traffic Light Phase Durations (in milliseconds)
 #define RED_TIME_MS     4000 // 4 seconds
@@ -36,13 +52,8 @@ typedef enum {
 volatile traffic_state_t G_Traffic_State = STATE_RED; // Initial state
 volatile uint32_t G_Time_Remaining_ms = RED_TIME_MS; // Time remaining in current phase
 
-// **Button Debounce Variables (PC4)**
-volatile bool G_PC4_Stable_State = false; 
-volatile uint8_t G_PC4_Debounce_Counter = 0;
-
-// **Button Debounce Variables (PC5)**
-volatile bool G_PC5_Stable_State = false;
-volatile uint8_t G_PC5_Debounce_Counter = 0;
+// **Button Debounce State (port C, only used by the ISR)**
+static debounce_t G_Buttons;
 
 // **Request Flags**
 volatile bool G_Request_Green = false; // Set when PC4 is pressed
@@ -58,7 +69,6 @@ volatile bool G_Request_Red = false;   // Set when PC5 is pressed
 
 // --- Function Declarations ---
 static void update_traffic_light_output(void);
-static void handle_button_debounce(uint8_t pin_value, volatile bool *stable_state, volatile uint8_t *counter, bool is_pc4);
 
 // --- Timer Initialization ---
 
@@ -82,19 +92,22 @@ void timer_init(void)
  */
 ISR(TCB0_INT_vect)
 {
+	ISR_PROFILE_BEGIN(PROF_TCB0, TCB0.CNT); // TCB0.CNT = cycles since the compare match (entry latency)
+	
 	TCB0.INTFLAGS = TCB_CAPT_bm; // Clear the interrupt flag
 	
-	// Handle PC4 (Request GREEN)
-	handle_button_debounce((PORTC.IN & PIN4_bm), 
-	                       &G_PC4_Stable_State, 
-	                       &G_PC4_Debounce_Counter, 
-	                       true); // is_pc4 = true
+	// --- 1. Debounce both buttons at once, set a request flag on a stable rising edge ---
+	uint8_t changed = debounce_update(&G_Buttons, PORTC.IN & BUTTONS_MASK);
+	uint8_t pressed = DEBOUNCE_PRESSED(&G_Buttons, changed);
 	
-	// Handle PC5 (Request RED)
-	handle_button_debounce((PORTC.IN & PIN5_bm), 
-	                       &G_PC5_Stable_State, 
-	                       &G_PC5_Debounce_Counter, 
-	                       false); // is_pc4 = false
+	if (pressed & PIN4_bm)
+	{
+		G_Request_Green = true; // PC4
+	}
+	if (pressed & PIN5_bm)
+	{
+		G_Request_Red = true;   // PC5
+	}
 	
 	// --- 2. Timing Logic (Executed every 1ms) ---
 	if (G_Time_Remaining_ms > 0)
@@ -128,51 +141,8 @@ ISR(TCB0_INT_vect)
 		// Update the LED output immediately after state change
 		update_traffic_light_output();
 	}
-}
-
-/**
- * @brief Generic debounce and rising edge detection logic for one button.
- * The ISR sets the appropriate G_Request_X flag upon a stable rising edge.
- */
-static void handle_button_debounce(uint8_t pin_value, volatile bool *stable_state, volatile uint8_t *counter, bool is_pc4)
-{
-    // Button is pressed if pin_value is non-zero
-	bool current_raw_state = (pin_value != 0);
-
-	if (current_raw_state != *stable_state)
-	{
-		if (*counter < MS_DEBOUNCE_MAX)
-		{
-			(*counter)++;
-		}
-		
-		if (*counter >= MS_DEBOUNCE_MAX)
-		{
-			// Stable edge reached
-			
-			// 1. Check for RISING EDGE (Transition from stable low to stable high)
-			if (current_raw_state == true)
-			{
-				if (is_pc4)
-				{
-					G_Request_Green = true;
-				}
-				else // PC5
-				{
-					G_Request_Red = true;
-				}
-			}
-			
-			// 2. Update the stable state and reset counter
-			*stable_state = current_raw_state;
-			*counter = 0;
-		}
-	}
-	else
-	{
-		// State matches stable state, reset counter to wait for a change
-		*counter = 0;
-	}
+	
+	ISR_PROFILE_END(PROF_TCB0);
 }
 
 // --- Hardware and State Functions ---
@@ -245,6 +215,7 @@ int main(void)
 	PORTC.DIRCLR = PIN4_bm | PIN5_bm; // Set PC4 and PC5 as inputs (buttons)
 	PORTC.PIN4CTRL = 0x00;           // No internal pull-ups (assuming external pull-downs)
 	PORTC.PIN5CTRL = 0x00;
+	debounce_init(&G_Buttons, PORTC.IN & BUTTONS_MASK);
 	
 	// Set PE0 (R), PE1 (G) as output (RGB LED)
 	PORTE.DIRSET = PIN0_bm | PIN1_bm;
@@ -252,6 +223,14 @@ int main(void)
 	// Start in RED state
 	LED_RED_ON();
 	
+#ifdef ISR_PROFILER_ENABLE
+	static const char *const Profile_Names[PROF_COUNT] = { "TCB0" };
+	timestamp_init();
+	debug_usart_init();
+	isr_profiler_init(Profile_Names, PROF_COUNT);
+	isr_profiler_set_budget(PROF_TCB0, 400); // 10% of the 1ms tick
+#endif
+	
 	timer_init();
 	sei(); // Enable global interrupts
 	
@@ -261,6 +240,14 @@ int main(void)
         // This keeps the ISR minimal and handles the state transitions safely.
         handle_requests();
 		
+#ifdef ISR_PROFILER_ENABLE
+		char Cmd;
+		if (debug_usart_get_char(&Cmd))
+		{
+			isr_profiler_command(Cmd);
+		}
+#endif
+		
 		// The MCU spends most of its time in the idle loop, waiting for the 1ms TCB0 interrupt.
     }
 }
\ No newline at end of file
@@ -0,0 +1,229 @@
+/*
+ * Input.c
+ *
+ * The recogniser keeps three ms counters per pin: how long the pin has been
+ * held, how long until its next auto-repeat, and how long ago it was released
+ * (while a double click is still possible). The repeat is a countdown that
+ * restarts at every INPUT_REPEAT, so it keeps going however long the pin is
+ * held (held_ms saturates at 65535). Pins that are idle cost only the mask test in input_tick().
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "Input.h"
+#include "../Debounce/Debounce.h"
+#include "../Event_Queue/Event_Queue.h"
+
+#define INPUT_PINS 8
+
+// Per-pin flags
+#define FLAG_LONG_SENT		0x01				// INPUT_LONG_PRESS already posted for this press
+#define FLAG_CLICK_PENDING	0x02				// Released, waiting for a second press
+#define FLAG_SECOND_PRESS	0x04				// This press is the second one of a double click
+
+typedef struct {
+	uint16_t held_ms;							// Time since the press (while pressed)
+	uint16_t released_ms;						// Time since the release (while FLAG_CLICK_PENDING)
+	uint16_t repeat_ms;							// Countdown to the next INPUT_REPEAT (while pressed)
+	uint8_t flags;
+} input_pin_t;
+
+// VARIABLES //
+static debounce_t Input_Debounce;
+static input_pin_t Input_Pins[INPUT_PINS];
+static input_timing_t Input_Timing = {
+	INPUT_LONG_PRESS_MS, INPUT_DOUBLE_CLICK_MS, INPUT_REPEAT_DELAY_MS, INPUT_REPEAT_RATE_MS, 0
+};
+static uint8_t Input_Event_Type = EVENT_NONE;
+static uint8_t Input_Pin_Mask = 0;
+static uint8_t Input_Active_Low = 0;
+static uint8_t Input_Active = 0;				// Pins that are pressed or have a pending click
+
+// PRIVATE FUNCTIONS //
+
+static inline void post(uint8_t pin, input_gesture_t gesture)
+{
+	event_post(Input_Event_Type, pin, gesture);
+}
+
+/*
+	Debounced press of one pin.
+*/
+static void on_press(uint8_t pin, input_pin_t *p)
+{
+	post(pin, INPUT_PRESS);
+
+	if ((p->flags & FLAG_CLICK_PENDING) && Input_Timing.double_click_ms != 0)
+	{
+		post(pin, INPUT_DOUBLE_CLICK);
+		p->flags = FLAG_SECOND_PRESS;			// The matching release must not produce a click
+	}
+	else
+	{
+		p->flags = 0;
+	}
+
+	p->held_ms = 0;
+	p->repeat_ms = Input_Timing.repeat_delay_ms;
+}
+
+/*
+	Debounced release of one pin.
+*/
+static void on_release(uint8_t pin, input_pin_t *p)
+{
+	post(pin, INPUT_RELEASE);
+
+	if (p->flags & (FLAG_LONG_SENT | FLAG_SECOND_PRESS))
+	{
+		p->flags = 0;							// Long press or double click, no single click
+	}
+	else if (Input_Timing.double_click_ms == 0)
+	{
+		post(pin, INPUT_CLICK);
+		p->flags = 0;
+	}
+	else
+	{
+		p->flags = FLAG_CLICK_PENDING;			// Decided when the double click window is over
+		p->released_ms = 0;
+	}
+}
+
+/*
+	Time based gestures of one pin, once per ms.
+	@return true while the pin still needs ticks (pressed or click pending)
+*/
+static bool pin_tick(uint8_t pin, input_pin_t *p, bool pressed)
+{
+	if (pressed)
+	{
+		if (p->held_ms < UINT16_MAX)
+		{
+			p->held_ms++;
+		}
+
+		if (Input_Timing.long_press_ms != 0 && !(p->flags & FLAG_LONG_SENT) && p->held_ms >= Input_Timing.long_press_ms)
+		{
+			post(pin, INPUT_LONG_PRESS);
+			p->flags |= FLAG_LONG_SENT;
+		}
+
+		if (Input_Timing.repeat_mask & (1 << pin))
+		{
+			if (p->repeat_ms <= 1)					// Delay 0 or 1: repeat on the first tick
+			{
+				post(pin, INPUT_REPEAT);
+				p->repeat_ms = Input_Timing.repeat_rate_ms;
+			}
+			else
+			{
+				p->repeat_ms--;
+			}
+		}
+		return true;
+	}
+
+	if (p->flags & FLAG_CLICK_PENDING)
+	{
+		if (++p->released_ms >= Input_Timing.double_click_ms)
+		{
+			post(pin, INPUT_CLICK);				// No second press in time
+			p->flags = 0;
+			return false;
+		}
+		return true;
+	}
+
+	return false;
+}
+
+// PUBLIC FUNCTIONS //
+
+/*
+	Sets up the recogniser. Call before interrupts are enabled.
+
+	@param event_type Event_Queue type used for all input events
+	@param pin_mask Pins of the port that are buttons
+	@param active_low_mask Buttons that read 0 when pressed
+	@param port_in Current port input, so buttons held at startup are not reported
+*/
+void input_init(uint8_t event_type, uint8_t pin_mask, uint8_t active_low_mask, uint8_t port_in)
+{
+	Input_Event_Type = event_type;
+	Input_Pin_Mask = pin_mask;
+	Input_Active_Low = active_low_mask;
+	Input_Active = 0;
+
+	for (uint8_t pin = 0; pin < INPUT_PINS; pin++)
+	{
+		Input_Pins[pin].flags = 0;
+	}
+
+	debounce_init(&Input_Debounce, (port_in ^ active_low_mask) & pin_mask);
+}
+
+/*
+	Changes the gesture timing (copied, safe to call with interrupts enabled).
+*/
+void input_set_timing(const input_timing_t *timing)
+{
+	uint8_t sreg = SREG;
+	cli();
+	Input_Timing = *timing;
+	if (Input_Timing.repeat_rate_ms == 0)
+	{
+		Input_Timing.repeat_rate_ms = 1;
+	}
+	SREG = sreg;
+}
+
+/*
+	Call every 1ms from a timer ISR.
+
+	@param port_in Raw port input (e.g. PORTC.IN)
+*/
+void input_tick(uint8_t port_in)
+{
+	uint8_t changed = debounce_update(&Input_Debounce, (port_in ^ Input_Active_Low) & Input_Pin_Mask);
+	uint8_t state = Input_Debounce.state;
+	uint8_t active = Input_Active | changed;
+
+	if (active == 0)
+	{
+		return;									// Nothing pressed, nothing pending
+	}
+
+	for (uint8_t pin = 0; pin < INPUT_PINS; pin++)
+	{
+		uint8_t bit = 1 << pin;
+
+		if (!(active & bit))
+			continue;
+
+		input_pin_t *p = &Input_Pins[pin];
+
+		if (changed & bit)
+		{
+			if (state & bit)
+				on_press(pin, p);
+			else
+				on_release(pin, p);
+		}
+
+		if (!pin_tick(pin, p, (state & bit) != 0))
+		{
+			active &= ~bit;
+		}
+	}
+
+	Input_Active = active;
+}
+
+/*
+	@return Debounced state of the button pins (1 = pressed)
+*/
+uint8_t input_state(void)
+{
+	return Input_Debounce.state;
+}
@@ -0,0 +1,71 @@
+/*
+ * Input.h
+ *
+ * Button input subsystem: debounced edges and gestures as queued events.
+ *
+ * input_tick() runs in the 1ms timer ISR. It debounces the port with the
+ * Debounce module and feeds every pin through a small recogniser. The results
+ * are posted to the Event_Queue (type = the type given to input_init(),
+ * source = pin number, payload = input_gesture_t), so each event carries the
+ * ms timestamp of the moment it was detected. Main handles them whenever it
+ * has time, a slow LCD update does not lose a press (up to EVENT_QUEUE_SIZE events).
+ *
+ * Gestures:
+ *  - INPUT_PRESS / INPUT_RELEASE: every debounced edge, without delay
+ *  - INPUT_CLICK: press and release shorter than long_press_ms, no second press within double_click_ms
+ *  - INPUT_DOUBLE_CLICK: second press within double_click_ms (replaces both clicks)
+ *  - INPUT_LONG_PRESS: once, when held for long_press_ms
+ *  - INPUT_REPEAT: pins in repeat_mask, after repeat_delay_ms every repeat_rate_ms while held
+ *
+ * Usage:
+ *  1. event_queue_init(); input_init(EVENT_INPUT, PIN4_bm | PIN5_bm, active_low_mask, PORTC.IN);
+ *  2. 1ms ISR: event_tick(); input_tick(PORTC.IN);
+ *  3. Handler for EVENT_INPUT: switch (event->payload) { case INPUT_CLICK: ... }
+ */
+
+#ifndef INPUT_H_
+#define INPUT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Default timing in ms (input_tick() is called every 1ms)
+#ifndef INPUT_LONG_PRESS_MS
+#define INPUT_LONG_PRESS_MS 800
+#endif
+
+#ifndef INPUT_DOUBLE_CLICK_MS
+#define INPUT_DOUBLE_CLICK_MS 250
+#endif
+
+#ifndef INPUT_REPEAT_DELAY_MS
+#define INPUT_REPEAT_DELAY_MS 500
+#endif
+
+#ifndef INPUT_REPEAT_RATE_MS
+#define INPUT_REPEAT_RATE_MS 100
+#endif
+
+typedef enum {
+	INPUT_PRESS = 1,
+	INPUT_RELEASE,
+	INPUT_CLICK,
+	INPUT_DOUBLE_CLICK,
+	INPUT_LONG_PRESS,
+	INPUT_REPEAT
+} input_gesture_t;
+
+typedef struct {
+	uint16_t long_press_ms;				// 0 = no INPUT_LONG_PRESS
+	uint16_t double_click_ms;			// 0 = INPUT_CLICK right at the release, no INPUT_DOUBLE_CLICK
+	uint16_t repeat_delay_ms;			// Hold time before the first INPUT_REPEAT, 0 = at the first tick
+	uint16_t repeat_rate_ms;			// Time between two INPUT_REPEAT
+	uint8_t repeat_mask;				// Pins that auto-repeat
+} input_timing_t;
+
+void input_init(uint8_t event_type, uint8_t pin_mask, uint8_t active_low_mask, uint8_t port_in);
+void input_set_timing(const input_timing_t *timing);
+void input_tick(uint8_t port_in);
+uint8_t input_state(void);
+
+#endif /* INPUT_H_ */
@@ -0,0 +1,201 @@
+/*
+ * Keypad.c
+ *
+ * The 16 matrix keys are debounced as two bytes (rows 0-1 and rows 2-3) and
+ * the direct buttons as a third byte, each with its own vertical counters.
+ */
+
+#include <avr/interrupt.h>
+#include "Keypad.h"
+#include "../Debounce/Debounce.h"
+#include "../Event_Queue/Event_Queue.h"
+
+#define KEYPAD_COL_MASK (0x0F << KEYPAD_COL_SHIFT)
+
+// VARIABLES //
+static debounce_t Keypad_Matrix[2];					// [0] = rows 0-1, [1] = rows 2-3, one nibble per row
+static debounce_t Keypad_Direct;
+static uint8_t Keypad_Frame[KEYPAD_ROWS];			// Raw columns of every row (1 = pressed)
+static uint8_t Keypad_Row = 0;						// Row that is driven low right now
+static uint8_t Keypad_Event_Type = EVENT_NONE;
+static volatile uint16_t Keypad_Ghost_Frames = 0;
+
+// Labels of a standard 4x4 keypad
+static const char Keypad_Labels[KEYPAD_MATRIX_KEYS] = {
+	'1', '2', '3', 'A',
+	'4', '5', '6', 'B',
+	'7', '8', '9', 'C',
+	'*', '0', '#', 'D'
+};
+
+// PRIVATE FUNCTIONS //
+
+/*
+	Drives one row low, all other rows are Hi-Z so two pressed keys in one column do not short two outputs.
+*/
+static inline void select_row(uint8_t row)
+{
+	KEYPAD_PORT.DIRCLR = KEYPAD_ROW_MASK;
+	KEYPAD_PORT.DIRSET = (uint8_t)(1 << row);
+}
+
+/*
+	Posts one event per changed key.
+
+	@param changed Changed bits of one debounced byte
+	@param state Debounced state of that byte
+	@param first Key code of bit 0
+*/
+static void post_changes(uint8_t changed, uint8_t state, uint8_t first)
+{
+	for (uint8_t bit = 0; changed != 0; bit++, changed >>= 1)
+	{
+		if (changed & 0x01)
+		{
+			event_post(Keypad_Event_Type, first + bit, (state & (1 << bit)) ? KEYPAD_PRESS : KEYPAD_RELEASE);
+		}
+	}
+}
+
+/*
+	Rows that take part in a possible ghost: two rows with two or more common pressed columns.
+*/
+static uint8_t ghost_rows(const uint8_t *frame)
+{
+	uint8_t rows = 0;
+
+#ifndef KEYPAD_HAS_DIODES
+	for (uint8_t r1 = 0; r1 < KEYPAD_ROWS - 1; r1++)
+	{
+		for (uint8_t r2 = r1 + 1; r2 < KEYPAD_ROWS; r2++)
+		{
+			uint8_t common = frame[r1] & frame[r2];
+
+			if (common & (common - 1))				// More than one bit set
+			{
+				rows |= (1 << r1) | (1 << r2);
+			}
+		}
+	}
+#else
+	(void)frame;
+#endif
+
+	return rows;
+}
+
+/*
+	A complete frame was read: filter ghosts, debounce and post the changes.
+*/
+static void frame_done(void)
+{
+	uint8_t rows = ghost_rows(Keypad_Frame);
+
+	if (rows)
+	{
+		Keypad_Ghost_Frames++;
+	}
+
+	for (uint8_t half = 0; half < 2; half++)
+	{
+		uint8_t lo_row = half * 2;
+		uint8_t lo = Keypad_Frame[lo_row];
+		uint8_t hi = Keypad_Frame[lo_row + 1];
+
+		// Ambiguous rows keep their debounced state (no change is counted)
+		if (rows & (1 << lo_row))
+			lo = Keypad_Matrix[half].state & 0x0F;
+		if (rows & (1 << (lo_row + 1)))
+			hi = Keypad_Matrix[half].state >> 4;
+
+		uint8_t changed = debounce_update(&Keypad_Matrix[half], lo | (hi << 4));
+		post_changes(changed, Keypad_Matrix[half].state, half * 8);
+	}
+
+#if KEYPAD_DIRECT_MASK != 0
+	uint8_t changed = debounce_update(&Keypad_Direct, (uint8_t)~KEYPAD_DIRECT_PORT.IN & KEYPAD_DIRECT_MASK);
+	post_changes(changed, Keypad_Direct.state, KEYPAD_DIRECT_FIRST);
+#endif
+}
+
+// PUBLIC FUNCTIONS //
+
+/*
+	Configures the matrix pins and clears the key state. Call before interrupts are enabled.
+
+	@param event_type Event_Queue type used for all key events
+*/
+void keypad_init(uint8_t event_type)
+{
+	Keypad_Event_Type = event_type;
+
+	// Rows: output low when selected, columns: inputs with pull-up
+	KEYPAD_PORT.OUTCLR = KEYPAD_ROW_MASK;
+	KEYPAD_PORT.DIRCLR = KEYPAD_ROW_MASK | KEYPAD_COL_MASK;
+	KEYPAD_PORT.PINCONFIG = PORT_PULLUPEN_bm;
+	KEYPAD_PORT.PINCTRLUPD = KEYPAD_COL_MASK;
+
+	debounce_init(&Keypad_Matrix[0], 0);
+	debounce_init(&Keypad_Matrix[1], 0);
+	debounce_init(&Keypad_Direct, (uint8_t)~KEYPAD_DIRECT_PORT.IN & KEYPAD_DIRECT_MASK);
+
+	for (uint8_t row = 0; row < KEYPAD_ROWS; row++)
+	{
+		Keypad_Frame[row] = 0;
+	}
+
+	Keypad_Row = 0;
+	select_row(0);
+}
+
+/*
+	Call every 1ms from a timer ISR. Never waits: reads one row and selects the next.
+*/
+void keypad_tick(void)
+{
+	// Columns of the row selected during the previous tick
+	uint8_t cols = (uint8_t)~KEYPAD_PORT.IN & KEYPAD_COL_MASK;
+	Keypad_Frame[Keypad_Row] = cols >> KEYPAD_COL_SHIFT;
+
+	Keypad_Row = (Keypad_Row + 1) & (KEYPAD_ROWS - 1);
+	select_row(Keypad_Row);
+
+	if (Keypad_Row == 0)
+	{
+		frame_done();
+	}
+}
+
+/*
+	@return Debounced state of all keys, bit n = key code n (1 = pressed)
+*/
+uint32_t keypad_state(void)
+{
+	uint8_t sreg = SREG;
+	cli();
+	uint32_t state = Keypad_Matrix[0].state | ((uint16_t)Keypad_Matrix[1].state << 8) | ((uint32_t)Keypad_Direct.state << KEYPAD_DIRECT_FIRST);
+	SREG = sreg;
+
+	return state;
+}
+
+/*
+	@return Number of frames in which a ghost key was possible
+*/
+uint16_t keypad_ghost_frames(void)
+{
+	uint8_t sreg = SREG;
+	cli();
+	uint16_t n = Keypad_Ghost_Frames;
+	SREG = sreg;
+
+	return n;
+}
+
+/*
+	@return Label of a matrix key ('0'-'9', 'A'-'D', '*', '#'), 0 for direct buttons
+*/
+char keypad_char(uint8_t key)
+{
+	return (key < KEYPAD_MATRIX_KEYS) ? Keypad_Labels[key] : 0;
+}
@@ -0,0 +1,70 @@
+/*
+ * Keypad.h
+ *
+ * Non-blocking scanner for a 4x4 matrix keypad plus optional direct buttons.
+ *
+ * keypad_tick() runs in the 1ms timer ISR and handles one matrix row per call:
+ * it reads the columns of the row selected in the previous call (1ms to settle)
+ * and selects the next row. A full frame of 4 rows takes 4ms and is debounced
+ * with the Debounce module, so a key change needs 8 stable frames (32ms).
+ * Every key has its own debounced bit (N-key rollover) and each change is
+ * posted to the Event_Queue (type = the type given to keypad_init(),
+ * source = key code, payload = keypad_action_t).
+ *
+ * Ghosting: without diodes, three keys on the corners of a rectangle make the
+ * fourth corner look pressed. A frame where two rows share two or more pressed
+ * columns is ambiguous, the affected rows then keep their previous state until
+ * the frame is clean again. Define KEYPAD_HAS_DIODES to skip the check.
+ *
+ * Wiring (default): rows on PD0..PD3 (driven low one at a time, otherwise Hi-Z),
+ * columns on PD4..PD7 (internal pull-ups, low = pressed).
+ * Key codes: row * 4 + column (0 ... 15), direct buttons KEYPAD_DIRECT_FIRST + pin.
+ *
+ * Usage:
+ *  1. event_queue_init(); keypad_init(EVENT_KEY);
+ *  2. 1ms ISR: event_tick(); keypad_tick();
+ *  3. Handler for EVENT_KEY: if (event->payload == KEYPAD_PRESS) c = keypad_char(event->source);
+ */
+
+#ifndef KEYPAD_H_
+#define KEYPAD_H_
+
+#include <avr/io.h>
+#include <stdint.h>
+
+// Matrix port: rows on the low nibble, columns on the high nibble
+#ifndef KEYPAD_PORT
+#define KEYPAD_PORT PORTD
+#endif
+
+#define KEYPAD_ROWS 4
+#define KEYPAD_COLS 4
+#define KEYPAD_ROW_MASK 0x0F
+#define KEYPAD_COL_SHIFT 4
+#define KEYPAD_MATRIX_KEYS (KEYPAD_ROWS * KEYPAD_COLS)
+
+// Active low direct buttons (with external or internal pull-ups), 0 = none
+#ifndef KEYPAD_DIRECT_PORT
+#define KEYPAD_DIRECT_PORT PORTC
+#endif
+
+#ifndef KEYPAD_DIRECT_MASK
+#define KEYPAD_DIRECT_MASK 0
+#endif
+
+#define KEYPAD_DIRECT_FIRST KEYPAD_MATRIX_KEYS		// Key code of direct pin 0
+#define KEYPAD_NO_KEY 0xFF
+
+typedef enum {
+	KEYPAD_PRESS = 1,
+	KEYPAD_RELEASE
+} keypad_action_t;
+
+void keypad_init(uint8_t event_type);
+void keypad_tick(void);
+
+uint32_t keypad_state(void);
+uint16_t keypad_ghost_frames(void);
+char keypad_char(uint8_t key);
+
+#endif /* KEYPAD_H_ */
@@ -5,13 +5,28 @@
  * Author : mami4
  */ 
 
-#define F_CPU 16000000UL
+#define F_CPU 4000000UL							// Default clock of the AVR128DB48 (the TCB0 tick depends on it)
 #include <avr/io.h>
+#include <avr/interrupt.h>
 #include <stdbool.h>
-#include <util/delay.h>
 #include "I2C_LCD.h"
+#include "Event_Queue.h"
+#include "Input.h"
+#include "Keypad.h"
 
 #define WAIT_TIME 5000
+#define BUTTON_PINS (PIN7_bm | PIN6_bm | PIN5_bm | PIN4_bm)	// Active low buttons on PC7 ... PC4
+
+// --- Event Definitions ---
+typedef enum {
+	EVENT_INPUT = 1,						// Button gesture, source = pin number, payload = input_gesture_t
+	EVENT_KEY,								// 4x4 keypad on PORTD, source = key code, payload = keypad_action_t
+	EVENT_TYPE_COUNT
+} app_event_t;
+
+// Result of the calculator, only changed by the input handler in main
+int32_t G_Result = 0;
+bool G_Result_Changed = true;				// Flag to track if we need to update the LCD (it is true to show the '0' at the first itteration)
 
 void busy_waiting(uint32_t number)
 {
@@ -67,50 +82,109 @@ void to_str(int32_t num, char *str) {
 	}
 }
 
-// Returns the key pressed
-static uint8_t single_button_debounce_filter(PORT_t port) {
+/**
+ * @brief Initializes Timer/Counter B0 (TCB0) for 1ms periodic interrupts (4MHz / 4000 = 1kHz).
+ */
+void timer_init(void)
+{
+	TCB0.CCMP = 3999;
+	TCB0.CTRLA = TCB_CLKSEL_DIV1_gc;		// No prescaler, use CLK_PER
+	TCB0.CTRLB = TCB_CNTMODE_INT_gc;		// Periodic Interrupt Mode
+	TCB0.INTCTRL = TCB_CAPT_bm;				// Enable Capture/Compare interrupt
+	TCB0.CTRLA |= TCB_ENABLE_bm;
+}
 
-	uint8_t buffer    = 0x01;
-	uint8_t pin        = 0x00;
-	const uint8_t button_pins = PIN7_bm | PIN6_bm | PIN5_bm | PIN4_bm;
+/**
+ * @brief 1ms tick: samples the buttons and one keypad row, both modules queue their events.
+ */
+ISR(TCB0_INT_vect)
+{
+	TCB0.INTFLAGS = TCB_CAPT_bm;
+	event_tick();
+	input_tick(PORTC.IN);
+	keypad_tick();
+}
+
+/**
+ * @brief Applies one button gesture to the result.
+ * PC4 (+1) and PC5 (-1) act on the press and repeat while held.
+ * PC6 (*2) and PC7 (/2) act on a click, a double click applies them twice, a long press clears the result.
+ */
+static void on_input(const event_t *event)
+{
+	int32_t Old_Result = G_Result;
 	
-	while (buffer != 0xFF) {
-		
-		buffer <<= 1;
-		
-		_delay_us(500);
-		
-		switch ((~port.IN) & button_pins) {
-			
-			case PIN4_bm:
-			pin = PIN4_bp;
-			buffer |= 0x01;
-			break;
-			
-			case PIN5_bm:
-			pin = PIN5_bp;
-			buffer |= 0x01;
+	switch (event->payload)
+	{
+		case INPUT_PRESS:
+		case INPUT_REPEAT:
+			if (event->source == 4) G_Result++;
+			if (event->source == 5) G_Result--;
 			break;
-			
-			case PIN6_bm:
-			pin = PIN6_bp;
-			buffer |= 0x01;
+		
+		case INPUT_CLICK:
+			if (event->source == 6) G_Result <<= 1;		// Multiply by 2
+			if (event->source == 7) G_Result >>= 1;		// Divide by 2
 			break;
-			
-			case PIN7_bm:
-			pin = PIN7_bp;
-			buffer |= 0x01;
+		
+		case INPUT_DOUBLE_CLICK:
+			if (event->source == 6) G_Result <<= 2;		// Multiply by 4
+			if (event->source == 7) G_Result >>= 2;		// Divide by 4
 			break;
-			
-			case 0xFF:
+		
+		case INPUT_LONG_PRESS:
+			if (event->source == 6 || event->source == 7) G_Result = 0;
 			break;
-			
-			default:
-			return 0xFF;
-		}
 	}
-	return pin;
+	
+	if (G_Result != Old_Result)
+	{
+		G_Result_Changed = true;
+	}
 }
+
+/**
+ * @brief Applies one keypad key to the result.
+ * 0-9 append a decimal digit, A/B/C/D work like PC4/PC5/PC6/PC7, * clears and # changes the sign.
+ */
+static void on_key(const event_t *event)
+{
+	if (event->payload != KEYPAD_PRESS)
+		return;
+	
+	char Key = keypad_char(event->source);
+	
+	if (Key >= '0' && Key <= '9')
+	{
+		int32_t Digit = Key - '0';
+		
+		// Ignore digits that would overflow the 32-bit result
+		if (G_Result <= (INT32_MAX - 9) / 10 && G_Result >= (INT32_MIN + 9) / 10)
+		{
+			G_Result = G_Result * 10 + (G_Result < 0 ? -Digit : Digit);
+		}
+	}
+	else
+	{
+		switch (Key)
+		{
+			case 'A': G_Result++;		break;
+			case 'B': G_Result--;		break;
+			case 'C': G_Result <<= 1;	break;	// Multiply by 2
+			case 'D': G_Result >>= 1;	break;	// Divide by 2
+			case '*': G_Result = 0;		break;
+			case '#': G_Result = -G_Result;	break;
+		}
+	}
+	
+	G_Result_Changed = true;
+}
+
+// Handler table, indexed by app_event_t
+static const event_handler_t Event_Handlers[EVENT_TYPE_COUNT] = {
+	[EVENT_INPUT] = on_input,
+	[EVENT_KEY] = on_key,
+};
 
 int main(void)
 {
@@ -121,10 +195,6 @@ int main(void)
 	PORTC.PIN6CTRL = 0x00;
 	PORTC.PIN7CTRL = 0x00;						// Configurations set to default
 	
-	int32_t Result = 0;							// Variable for result
-	
-	bool result_changed = true;					// Flag to track if we need to update the LCD (it is true to show the '0' at the first itteration)
-	
 	// 1. Initialize the I2C Bus and the LCD
 	// The lcd_init() function internally calls i2c_init().
 	i2c_status status = lcd_init();
@@ -139,37 +209,27 @@ int main(void)
 	
 	char Result_Str[13];							// Result can be max 11 digits including '-' + "\0"
 	
+	// Buttons are sampled by the 1ms timer, presses made during an LCD update wait in the queue
+	input_timing_t Timing = {
+		INPUT_LONG_PRESS_MS, INPUT_DOUBLE_CLICK_MS, INPUT_REPEAT_DELAY_MS, INPUT_REPEAT_RATE_MS,
+		PIN4_bm | PIN5_bm						// +1 / -1 repeat while held
+	};
+	event_queue_init();
+	input_init(EVENT_INPUT, BUTTON_PINS, BUTTON_PINS, PORTC.IN);
+	input_set_timing(&Timing);
+	keypad_init(EVENT_KEY);						// Rows PD0-PD3, columns PD4-PD7
+	timer_init();
+	sei();
+	
 	while (1)
 	{
-		uint8_t Button = single_button_debounce_filter(PORTC);
-
-		switch (Button)
-		{
-			case 4:
-				result_changed = true;
-				Result++;
-				break;
-			
-			case 5:
-				result_changed = true;
-				Result--;
-				break;
-
-			case 6:
-				result_changed = true;
-				Result <<= 1;					// Multiply by 2
-				break;
-			
-			case 7:
-				result_changed = true;
-				Result >>= 1;					// Divide by 2
-				break;
-		}
+		// Apply every queued gesture first, then draw the result once
+		event_dispatch(Event_Handlers, EVENT_TYPE_COUNT);
 		
 		// Only update the LCD if the result changed
-		if (result_changed)
+		if (G_Result_Changed)
 		{
-			to_str(Result, Result_Str);
+			to_str(G_Result, Result_Str);
 			
 			lcd_moveCursor(0, 0);
 			// Clears any leftover characters from previous, longer numbers
@@ -179,7 +239,7 @@ int main(void)
 			status = lcd_putString(Result_Str);
 		}
 		
-		result_changed = false;
+		G_Result_Changed = false;
 	}
 }
 
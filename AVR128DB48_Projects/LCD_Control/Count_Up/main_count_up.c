@@ -6,15 +6,11 @@
  */ 
 
 #include <avr/io.h>
+#include <avr/interrupt.h>
 #include "I2C_LCD.h"
+#include "Timestamp.h"
 
-#define WAIT_TIME 100000
-
-void busy_waiting(uint32_t number)
-{
-	volatile uint32_t i;
-	for(i = 0; i < number; i++);
-}
+#define WAIT_TIME_MS 500						// Delay between two updates
 
 void to_str(uint32_t num, char *str) {
 	int i = 0;
@@ -60,6 +56,10 @@ int main(void)
 {
     uint32_t Counter = 0;
 	
+    // Start the timestamp service (TCB1) used for the delays
+    timestamp_init();
+    sei();
+    
     // 1. Initialize the I2C Bus and the LCD
     // The lcd_init() function internally calls i2c_init().
     i2c_status status = lcd_init();
@@ -68,7 +68,7 @@ int main(void)
     {
 	    while (1)
 	    {
-		    busy_waiting(WAIT_TIME);
+		    timestamp_delay_ms(WAIT_TIME_MS);
 	    }
     }
 	
@@ -109,7 +109,7 @@ int main(void)
 			status = lcd_putString(Str);
 		}
 		
-		busy_waiting(WAIT_TIME);
+		timestamp_delay_ms(WAIT_TIME_MS);
 		
 		Counter++;
 		status = lcd_clear();
@@ -6,20 +6,20 @@
  */
 
 #include <avr/io.h>
+#include <avr/interrupt.h>
 #include "I2C_LCD.h"
+#include "Timestamp.h"
 
 #define MESSAGE "Hello Display"
-#define WAIT_TIME 100000
-
-void busy_waiting(uint32_t number)
-{
-	volatile uint32_t i;
-	for(i = 0; i < number; i++);
-}
+#define WAIT_TIME_MS 500						// Delay between two updates
 
 
 int main(void)
 {
+	// Start the timestamp service (TCB1) used for the delays
+	timestamp_init();
+	sei();
+	
 	// 1. Initialize the I2C Bus and the LCD
 	// The lcd_init() function internally calls i2c_init().
 	i2c_status status = lcd_init();
@@ -28,7 +28,7 @@ int main(void)
 	{
 		while (1)
 		{
-			busy_waiting(WAIT_TIME);
+			timestamp_delay_ms(WAIT_TIME_MS);
 		}
 	}
 	
@@ -43,7 +43,7 @@ int main(void)
 	while (1)
 	{
 		//Do nothing
-		busy_waiting(WAIT_TIME);
+		timestamp_delay_ms(WAIT_TIME_MS);
 	}
 	
 }
@@ -6,15 +6,11 @@
  */ 
 
 #include <avr/io.h>
+#include <avr/interrupt.h>
 #include "I2C_LCD.h"
+#include "Timestamp.h"
 
-#define WAIT_TIME 100000
-
-void busy_waiting(uint32_t number)
-{
-	volatile uint32_t i;
-	for(i = 0; i < number; i++);
-}
+#define WAIT_TIME_MS 500						// Delay between two updates
 
 //fills display with '0'
 void lcd_fill()
@@ -31,6 +27,10 @@ void lcd_fill()
 
 int main(void)
 {
+	// Start the timestamp service (TCB1) used for the delays
+	timestamp_init();
+	sei();
+	
 	// 1. Initialize the I2C Bus and the LCD
 	// The lcd_init() function internally calls i2c_init().
 	i2c_status status = lcd_init();
@@ -39,7 +39,7 @@ int main(void)
 	{
 		while (1)
 		{
-			busy_waiting(WAIT_TIME);
+			timestamp_delay_ms(WAIT_TIME_MS);
 		}
 	}
 	
@@ -58,7 +58,7 @@ int main(void)
 				lcd_moveCursor((Column-1), 0);
 				lcd_putChar('0');
 			}
-			busy_waiting(WAIT_TIME);
+			timestamp_delay_ms(WAIT_TIME_MS);
 		}
 			
 		// make 16. column '0' before moving on to the next line
@@ -76,7 +76,7 @@ int main(void)
 				lcd_moveCursor((Column +1), 1);
 				lcd_putChar('0');
 			}
-			busy_waiting(WAIT_TIME);
+			timestamp_delay_ms(WAIT_TIME_MS);
 		}
 			
 		// make 0. column '0' before moving on to the next line
@@ -0,0 +1,35 @@
+/*
+ * ADC_Fast_Path.c
+ *
+ * Only the start-up check lives here, the per-sample work is inline in the header.
+ */
+
+#include "ADC_Fast_Path.h"
+
+// PUBLIC FUNCTIONS //
+
+/*
+	Checks a path against the channel it is used with: every possible result
+	must index into the table, or give a 16-bit output with the transform.
+	adc_fast_path_apply() does no range checks, so call this once before the
+	ADC is started.
+
+	@param path    Path to check
+	@param channel Channel whose results are passed to adc_fast_path_apply()
+	@return false if a result could read past the table or overflow the output
+*/
+bool adc_fast_path_valid(const adc_fast_path_t *path, const adc_channel_t *channel)
+{
+	uint16_t full_scale = adc_driver_full_scale(channel);
+
+	if (!path->target)
+		return false;
+
+	if (path->lut)
+		return (full_scale >> path->lut_shift) < path->lut_size;
+
+	if (path->scale.den == 0 || !FIXED_SCALE_FITS(path->scale.num, path->scale.den, full_scale))
+		return false;
+
+	return (uint32_t)path->offset + (uint32_t)full_scale * path->scale.num / path->scale.den <= 0xFFFFUL;
+}
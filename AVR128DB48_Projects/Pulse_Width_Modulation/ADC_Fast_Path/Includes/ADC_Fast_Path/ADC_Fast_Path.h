@@ -0,0 +1,85 @@
+/*
+ * ADC_Fast_Path.h
+ *
+ * ADC result straight to an actuator, inside the RESRDY ISR.
+ *
+ * A path maps the result of one channel either through a lookup table or
+ * with a fixed-point transform (offset + value * num / den) and writes it
+ * directly into a 16-bit target: a TCA0 compare buffer (LED brightness) or
+ * the pulse width a servo timer reads. Main is not involved, so the output
+ * follows the sample within microseconds instead of waiting for a flag poll
+ * in the main loop (and the LCD code in it).
+ *
+ * adc_fast_path_apply() is inline: the ISR does not have to save all call-used
+ * registers for a function call, and with a const path the compiler folds the
+ * table address, shift and scale into the code. The output is limited to
+ * path->max, so a noisy or wrong input can never drive a servo past its end stop.
+ *
+ * Usage:
+ *  static const adc_fast_path_t Led = ADC_FAST_PATH_LUT(Gamma, 256, 4, 1023, &TCA0.SINGLE.CMP0BUF);
+ *  static const adc_fast_path_t Servo = ADC_FAST_PATH_SCALE(2000, 2000, 4095, 4000, &Pulse_Cycles);
+ *  adc_fast_path_valid(&Led, &Pot) once at start-up
+ *  RESRDY ISR: uint16_t value = adc_driver_result(&Pot, ADC0.RES);
+ *              adc_fast_path_apply(&Led, value);
+ *              adc_fast_path_apply(&Servo, value);
+ *
+ * Latency: with the ADC_Trigger TCB2 source, TCB2.CNT at the start of the ISR
+ * is the time since the conversion was started (TCB2 clock = CLK_PER/2), use it
+ * as latency in ISR_PROFILE_BEGIN(). The execution time then runs to the write.
+ * A TCA0 compare buffer takes effect at the next UPDATE (end of the PWM period),
+ * a servo pulse width with the next pulse.
+ */
+
+#ifndef ADC_FAST_PATH_H_
+#define ADC_FAST_PATH_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../ADC_Driver/ADC_Driver.h"
+#include "../Fixed_Point/Fixed_Point.h"
+
+typedef struct {
+	const uint16_t *lut;				// Lookup table, 0 for the fixed-point transform
+	uint16_t lut_size;					// Entries in lut
+	uint8_t lut_shift;					// LUT index = value >> lut_shift
+	fixed_scale_t scale;				// Transform: offset + value * num / den
+	uint16_t offset;
+	uint16_t max;						// Upper limit of the output (e.g. TCA0 PER or the longest servo pulse)
+	volatile uint16_t *target;			// TCA0.SINGLE.CMPnBUF, pulse width variable, ...
+} adc_fast_path_t;
+
+// Constant initializers
+#define ADC_FAST_PATH_LUT(lut, size, shift, max, target) \
+	{ (lut), (size), (shift), { 0, 0, 1 }, 0, (max), (target) }
+
+#define ADC_FAST_PATH_SCALE(offset, num, den, max, target) \
+	{ 0, 0, 0, FIXED_SCALE(num, den), (offset), (max), (target) }
+
+bool adc_fast_path_valid(const adc_fast_path_t *path, const adc_channel_t *channel);
+
+/*
+	Maps one result and writes it to the target. Call it from the RESRDY ISR.
+
+	@param value Result of the channel the path was checked for (adc_driver_result())
+*/
+static inline void adc_fast_path_apply(const adc_fast_path_t *path, uint16_t value)
+{
+	uint16_t out;
+
+	if (path->lut)
+	{
+		out = path->lut[value >> path->lut_shift];
+	}
+	else
+	{
+		out = path->offset + fixed_scale(&path->scale, value);
+	}
+
+	if (out > path->max)
+	{
+		out = path->max;
+	}
+	*path->target = out;						// 16-bit write, low byte first (TEMP register)
+}
+
+#endif /* ADC_FAST_PATH_H_ */
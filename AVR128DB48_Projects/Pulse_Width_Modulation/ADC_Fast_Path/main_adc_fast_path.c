@@ -0,0 +1,195 @@
+/*
+ * main_adc_fast_path.c
+ *
+ * The potentiometer on AIN19 (PF3) drives the brightness of the red LED (PD0)
+ * and the angle of the servo (PF4) without going through main.
+ *
+ * TCB2 starts a conversion every 1/SAMPLE_RATE_HZ s through the Event System.
+ * The RESRDY ISR maps the result with ADC_Fast_Path:
+ *  - LED:   gamma lookup table -> TCA0 CMP0BUF (10-bit single-slope PWM)
+ *  - Servo: 1000us + value * 1000us / 4095 -> pulse width of the TCB0 software PWM
+ *
+ * With ISR_PROFILER_ENABLE the profiler measures the sample-to-output latency:
+ * send 'p' over USART3 (9600 baud) for a report, 'r' to reset.
+ *  FAST_PATH lat = TCB2 counts (0.5us) from the conversion start to the ISR
+ *  FAST_PATH exec = CLK_PER cycles (0.25us) from there to the last write
+ */
+
+#define F_CPU 4000000UL													// Set CPU Frequency to 4MHz
+#define SAMPLE_RATE_HZ 1000												// Conversions per second
+
+// Comment out to remove the latency measurement (the ISRs are then unchanged)
+#define ISR_PROFILER_ENABLE
+
+#include <avr/io.h>
+#include <avr/interrupt.h>												// Required for ISR usage
+#include <stdbool.h>													// Used for bool variables
+#ifdef ISR_PROFILER_ENABLE
+#include "Timestamp.h"
+#include "Debug_USART.h"
+#endif
+#include "ISR_Profiler.h"
+#include "ADC_Driver.h"
+#include "ADC_Trigger.h"
+#include "Fixed_Point.h"
+#include "ADC_Fast_Path.h"
+
+// Profiled vectors
+enum {
+	PROF_FAST_PATH,
+	PROF_SERVO,
+	PROF_COUNT
+};
+
+#define FAST_PATH_BUDGET_CYCLES 200										// 50us, counted as overrun in the report
+
+// LED PWM: 10-bit single slope at 4MHz = 3.9kHz, a new compare value is used after at most 256us
+#define LED_PWM_TOP 1023U
+#define GAMMA_LUT_SIZE 256												// Index = 12-bit result >> 4
+
+// Servo timing, TCB0 @ CLK_PER/2 (0.5us per count)
+#define CYCLES_PER_us 2U
+#define LEFT_PULSE_us 1000U
+#define RIGHT_PULSE_us 2000U
+#define CYCLES_PER_SIGNAL (20000U * CYCLES_PER_us)						// 20ms frame (50Hz)
+
+#define SERVO_PIN_bm PIN4_bm
+#define SERVO_PORT PORTF
+
+// Potentiometer: single 12-bit conversions, one conversion (~15us) per sample keeps the latency low
+static const adc_channel_t Pot_Channel = {
+	ADC_MUXPOS_AIN19_gc, VREF_REFSEL_VDD_gc, ADC_RESSEL_12BIT_gc, ADC_SAMPNUM_ACC1_gc, 0, 0
+};
+
+static uint16_t Gamma_Lut[GAMMA_LUT_SIZE];								// Filled by gamma_lut_init()
+
+static volatile uint16_t Servo_Pulse_Cycles = (LEFT_PULSE_us + RIGHT_PULSE_us) / 2 * CYCLES_PER_us;
+
+static const adc_fast_path_t Led_Path =
+	ADC_FAST_PATH_LUT(Gamma_Lut, GAMMA_LUT_SIZE, 4, LED_PWM_TOP, &TCA0.SINGLE.CMP0BUF);
+
+static const adc_fast_path_t Servo_Path =
+	ADC_FAST_PATH_SCALE(LEFT_PULSE_us * CYCLES_PER_us, (RIGHT_PULSE_us - LEFT_PULSE_us) * CYCLES_PER_us, 4095,
+						RIGHT_PULSE_us * CYCLES_PER_us, &Servo_Pulse_Cycles);
+
+/**
+ * @brief Quadratic brightness curve: Gamma_Lut[i] = i^2 * 1023 / 255^2.
+ * The eye sees the LED change evenly over the whole pot range.
+ */
+static void gamma_lut_init(void)
+{
+	static const fixed_scale_t Gamma_Scale = FIXED_SCALE(LED_PWM_TOP, 255U * 255U);
+
+	for (uint16_t i = 0; i < GAMMA_LUT_SIZE; i++)
+	{
+		Gamma_Lut[i] = fixed_scale(&Gamma_Scale, i * i);
+	}
+}
+
+/**
+ * @brief Red LED on PD0 (TCA0 WO0), 10-bit single-slope PWM.
+ */
+void TCA0_init(void)
+{
+	PORTMUX.TCAROUTEA = (PORTMUX.TCAROUTEA & ~PORTMUX_TCA0_gm) | PORTMUX_TCA0_PORTD_gc;
+	PORTD.DIRSET = PIN0_bm;
+
+	TCA0.SINGLE.CTRLA = 0;
+	TCA0.SINGLE.CTRLESET = TCA_SINGLE_CMD_RESET_gc;
+	TCA0.SINGLE.PER = LED_PWM_TOP;
+	TCA0.SINGLE.CMP0 = 0;												// LED off until the first sample
+	TCA0.SINGLE.CTRLB = TCA_SINGLE_CMP0EN_bm | TCA_SINGLE_WGMODE_SINGLESLOPE_gc;
+	TCA0.SINGLE.CTRLA = TCA_SINGLE_CLKSEL_DIV1_gc | TCA_SINGLE_ENABLE_bm;
+}
+
+/**
+ * @brief Servo on PF4, software PWM with the TCB0 interrupt (see Waving_Servomotor).
+ */
+void TCB0_init(void)
+{
+	SERVO_PORT.DIRSET = SERVO_PIN_bm;
+	SERVO_PORT.OUTCLR = SERVO_PIN_bm;
+
+	TCB0.CCMP = 100;													// First interrupt right away
+	TCB0.CNT = 0;
+	TCB0.INTCTRL = TCB_CAPT_bm;
+	TCB0.CTRLA = TCB_CLKSEL_DIV2_gc | TCB_ENABLE_bm;					// Periodic interrupt mode, CLK_PER / 2
+}
+
+void ADC0_init(void)
+{
+	// Disable the digital input buffer of PF3
+	PORTF.PIN3CTRL = PORT_ISC_INPUT_DISABLE_gc;
+
+	// ADC Clock = 4MHz / 4 = 1MHz, Result Ready Interrupt enabled
+	adc_driver_init(ADC_PRESC_DIV4_gc, true);
+	adc_driver_select(&Pot_Channel);
+}
+
+// Interrupt Service Routine: the sample goes straight to both outputs
+ISR(ADC0_RESRDY_vect)
+{
+	ISR_PROFILE_BEGIN(PROF_FAST_PATH, TCB2.CNT);						// TCB2 counts since the conversion was started
+
+	uint16_t Value = adc_driver_result(&Pot_Channel, ADC0.RES);		// Reading RES clears the flag
+	adc_fast_path_apply(&Led_Path, Value);
+	adc_fast_path_apply(&Servo_Path, Value);
+
+	ISR_PROFILE_END(PROF_FAST_PATH);
+}
+
+// Interrupt Service Routine: servo pulse, the width is read at the start of every pulse
+ISR(TCB0_INT_vect)
+{
+	ISR_PROFILE_BEGIN(PROF_SERVO, TCB0.CNT);							// Counts since the compare match = edge delay
+
+	TCB0.INTFLAGS = TCB_CAPT_bm;
+
+	if (SERVO_PORT.OUT & SERVO_PIN_bm)
+	{
+		SERVO_PORT.OUTCLR = SERVO_PIN_bm;								// End of the pulse, wait for the rest of the frame
+		TCB0.CCMP = CYCLES_PER_SIGNAL - TCB0.CCMP;
+	}
+	else
+	{
+		SERVO_PORT.OUTSET = SERVO_PIN_bm;								// Start of the frame
+		TCB0.CCMP = Servo_Pulse_Cycles;
+	}
+
+	ISR_PROFILE_END(PROF_SERVO);
+}
+
+int main(void)
+{
+#ifdef ISR_PROFILER_ENABLE
+	static const char *const Profile_Names[PROF_COUNT] = { "FAST_PATH", "SERVO" };
+	timestamp_init();
+	debug_usart_init();
+	isr_profiler_init(Profile_Names, PROF_COUNT);
+	isr_profiler_set_budget(PROF_FAST_PATH, FAST_PATH_BUDGET_CYCLES);
+#endif
+
+	gamma_lut_init();
+	TCA0_init();
+	TCB0_init();
+	ADC0_init();
+	sei();
+
+	// The ISR does no range checks, so only start the ADC with paths that fit the channel
+	if (adc_fast_path_valid(&Led_Path, &Pot_Channel) && adc_fast_path_valid(&Servo_Path, &Pot_Channel))
+	{
+		adc_trigger_init(ADC_TRIGGER_TCB2, SAMPLE_RATE_HZ);
+	}
+
+	while (1)
+	{
+		// Nothing to do for the outputs, main only answers the profiler commands
+#ifdef ISR_PROFILER_ENABLE
+		char Cmd;
+		if (debug_usart_get_char(&Cmd))
+		{
+			isr_profiler_command(Cmd);
+		}
+#endif
+	}
+}
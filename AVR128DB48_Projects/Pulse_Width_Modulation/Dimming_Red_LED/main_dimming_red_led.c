@@ -7,7 +7,7 @@
 
 #include <avr/io.h>
 #include <stdint.h>
-#include <math.h>											// math.h library is used for floating point.
+#include "Fixed_Point.h"									// Integer scaling instead of floating point.
 
 // Define the CPU frequency. AVR128DB48 defaults to 4MHz.
 #define F_CPU 4000000UL 
@@ -15,6 +15,9 @@
 // Setting brightness percentage (0 to 100).
 #define TARGET_BRIGHTNESS 25U 
 
+// (Percentage / 100) * 256 as a reciprocal multiplication, same result as the old double formula
+static const fixed_scale_t Duty_Scale = FIXED_SCALE(256, 100);
+
 
 /**
  * @brief Sets the brightness of the Red LED (PD0) using TCA0 PWM.
@@ -28,11 +31,11 @@ void set_red_led_brightness(uint8_t percentage) {
 	    percentage = 100;
     }
     
-	double compare_val;
+	uint16_t compare_val;
 	    
     // Calculate the Compare Value (CMP0).
     // (Percentage / 100) * 256 - 1
-    compare_val = ( (double)percentage / 100.0 ) * 256.0 - 1;
+    compare_val = fixed_scale(&Duty_Scale, percentage) - 1;
 	
 	// Safety check
 	if (percentage == 0) {
@@ -12,6 +12,22 @@
 
 #define F_CPU 4000000UL											// Period is 0.25us
 
+// Uncomment to profile the servo ISR. Send 'p' over USART3 (9600 baud) for a report, 'r' to reset.
+// The latency is in TCB0 counts (0.5us), so it directly shows the jitter of the pulse edges.
+//#define ISR_PROFILER_ENABLE
+
+#ifdef ISR_PROFILER_ENABLE
+#include "Timestamp.h"
+#include "Debug_USART.h"
+#endif
+#include "ISR_Profiler.h"
+
+// Profiled vectors
+enum {
+    PROF_SERVO,
+    PROF_COUNT
+};
+
 // Servo Position Definitions
 #define NEUTRAL_PULSE_us	1500U								// 1500us or 1.5ms
 #define LEFT_PULSE_us		1000U
@@ -73,6 +89,8 @@ void set_servo_position(uint16_t Pulse_us) {
  * @brief ISR for TCB0. Generates Software PWM and counts system ticks.
  */
 ISR(TCB0_INT_vect) {
+    ISR_PROFILE_BEGIN(PROF_SERVO, TCB0.CNT);					// Counts since the compare match = edge delay
+    
     TCB0.INTFLAGS = TCB_CAPT_bm;								// Clear flag
 
     if (SERVO_PORT.OUT & SERVO_PIN_bm) {
@@ -91,6 +109,8 @@ ISR(TCB0_INT_vect) {
         // Wait for Pulse Duration
         TCB0.CCMP = G_Current_Pulse_Cycles;
     }
+    
+    ISR_PROFILE_END(PROF_SERVO);
 }
 
 /**
@@ -98,6 +118,13 @@ ISR(TCB0_INT_vect) {
  * Executes an infinite, continuous sweep from Left to Right and back.
  */
 int main(void) {
+#ifdef ISR_PROFILER_ENABLE
+    static const char *const Profile_Names[PROF_COUNT] = { "SERVO" };
+    timestamp_init();
+    debug_usart_init();
+    isr_profiler_init(Profile_Names, PROF_COUNT);
+#endif
+    
     initialize_tcb0();
     sei();
 
@@ -130,5 +157,12 @@ int main(void) {
             // Apply the new position to the servo
             set_servo_position(Current_Position_us);
         }
+        
+#ifdef ISR_PROFILER_ENABLE
+        char Cmd;
+        if (debug_usart_get_char(&Cmd)) {
+            isr_profiler_command(Cmd);
+        }
+#endif
     }
 }
\ No newline at end of file
@@ -0,0 +1,240 @@
+/*
+ * Filter.c
+ */
+
+#include "Filter.h"
+
+/*
+	@return acc / 2^shift, rounded
+*/
+static uint16_t filter_ema_output(const filter_ema_t *f)
+{
+	if (f->shift == 0)
+	{
+		return (uint16_t)f->acc;
+	}
+	return (uint16_t)((f->acc + (1UL << (f->shift - 1))) >> f->shift);
+}
+
+/*
+	@param shift alpha = 1 / 2^shift (0 ... 16), e.g. 3: every sample moves the output by 1/8 of the difference
+*/
+void filter_ema_init(filter_ema_t *f, uint8_t shift)
+{
+	f->acc = 0;
+	f->shift = (shift > 16) ? 16 : shift;
+	f->primed = false;
+}
+
+/*
+	Exponential moving average, acc holds the output with shift fractional bits.
+
+	@return Filtered value (rounded)
+*/
+uint16_t filter_ema_update(filter_ema_t *f, uint16_t x)
+{
+	if (!f->primed)
+	{
+		f->acc = (uint32_t)x << f->shift;
+		f->primed = true;
+	}
+	else
+	{
+		// acc = acc - y + x: y is the rounded output, so the state settles on x
+		// from both sides (with acc >> shift small steps toward 0 would be lost)
+		f->acc = f->acc - filter_ema_output(f) + x;
+	}
+	
+	return filter_ema_output(f);
+}
+
+/*
+	@param size Window, odd and at most FILTER_MEDIAN_MAX (3, 5 or 7)
+	@return false if the size is not supported
+*/
+bool filter_median_init(filter_median_t *f, uint8_t size)
+{
+	if (size == 0 || size > FILTER_MEDIAN_MAX || (size & 1) == 0)
+	{
+		return false;
+	}
+	
+	f->size = size;
+	f->count = 0;
+	f->head = 0;
+	return true;
+}
+
+/*
+	Sliding median. The sorted copy of the window is updated in place: the
+	oldest sample is taken out and the new one is inserted in one pass, no
+	sorting of the whole window.
+
+	@return Median of the last size samples (of all samples while the window fills)
+*/
+uint16_t filter_median_update(filter_median_t *f, uint16_t x)
+{
+	uint8_t i;
+	
+	if (f->count < f->size)
+	{
+		// Window not full yet: insertion into the sorted part
+		i = f->count;
+		while (i > 0 && f->sorted[i - 1] > x)
+		{
+			f->sorted[i] = f->sorted[i - 1];
+			i--;
+		}
+		f->sorted[i] = x;
+		f->ring[f->count] = x;
+		f->count++;
+		return f->sorted[f->count / 2];
+	}
+	
+	// Position of the oldest sample in the sorted window
+	uint16_t oldest = f->ring[f->head];
+	i = 0;
+	while (f->sorted[i] != oldest)
+	{
+		i++;
+	}
+	
+	// Its slot moves to where x belongs, the samples in between shift by one
+	while (i + 1 < f->size && f->sorted[i + 1] < x)
+	{
+		f->sorted[i] = f->sorted[i + 1];
+		i++;
+	}
+	while (i > 0 && f->sorted[i - 1] > x)
+	{
+		f->sorted[i] = f->sorted[i - 1];
+		i--;
+	}
+	f->sorted[i] = x;
+	
+	f->ring[f->head] = x;
+	if (++f->head >= f->size)
+	{
+		f->head = 0;
+	}
+	
+	return f->sorted[f->size / 2];
+}
+
+/*
+	@param band Input changes up to +-band around the output are ignored
+*/
+void filter_deadband_init(filter_deadband_t *f, uint16_t band)
+{
+	f->out = 0;
+	f->band = band;
+	f->primed = false;
+}
+
+/*
+	Deadband (backlash): the output stays until the input is more than band
+	away and then follows it at a distance of band. Noise smaller than the
+	band never changes the output, so a display is not redrawn for it.
+
+	@return Output value
+*/
+uint16_t filter_deadband_update(filter_deadband_t *f, uint16_t x)
+{
+	if (!f->primed)
+	{
+		f->out = x;
+		f->primed = true;
+	}
+	else if (x > f->out && x - f->out > f->band)
+	{
+		f->out = x - f->band;
+	}
+	else if (x < f->out && f->out - x > f->band)
+	{
+		f->out = x + f->band;
+	}
+	return f->out;
+}
+
+/*
+	@param shift Step = 2^shift
+	@param hysteresis Distance past a step boundary before the level changes (less than the step)
+*/
+void filter_quantize_init(filter_quantize_t *f, uint8_t shift, uint16_t hysteresis)
+{
+	f->level = 0;
+	f->shift = (shift > 15) ? 15 : shift;
+	f->hysteresis = hysteresis;
+	f->primed = false;
+}
+
+/*
+	Quantizer with hysteresis: the level only changes when the input is
+	hysteresis past the lower or upper boundary of the current step.
+
+	@return Quantized value (level << shift)
+*/
+uint16_t filter_quantize_update(filter_quantize_t *f, uint16_t x)
+{
+	uint16_t level = x >> f->shift;
+	
+	if (!f->primed)
+	{
+		f->level = level;
+		f->primed = true;
+	}
+	else if (level > f->level)
+	{
+		// Up only if x is hysteresis above the start of its step
+		if ((uint16_t)(x - (level << f->shift)) >= f->hysteresis || level > f->level + 1)
+		{
+			f->level = level;
+		}
+	}
+	else if (level < f->level)
+	{
+		// Down only if x is hysteresis below the start of the current step
+		if ((uint16_t)((f->level << f->shift) - x) > f->hysteresis || level + 1 < f->level)
+		{
+			f->level = level;
+		}
+	}
+	return f->level << f->shift;
+}
+
+// Stage wrappers for filter_chain_update()
+uint16_t filter_ema_stage(void *f, uint16_t x)
+{
+	return filter_ema_update((filter_ema_t *)f, x);
+}
+
+uint16_t filter_median_stage(void *f, uint16_t x)
+{
+	return filter_median_update((filter_median_t *)f, x);
+}
+
+uint16_t filter_deadband_stage(void *f, uint16_t x)
+{
+	return filter_deadband_update((filter_deadband_t *)f, x);
+}
+
+uint16_t filter_quantize_stage(void *f, uint16_t x)
+{
+	return filter_quantize_update((filter_quantize_t *)f, x);
+}
+
+/*
+	Runs a sample through all stages of a chain.
+
+	@param chain Stages, applied in order
+	@param count Number of stages
+	@return Output of the last stage
+*/
+uint16_t filter_chain_update(const filter_stage_t *chain, uint8_t count, uint16_t x)
+{
+	for (uint8_t i = 0; i < count; i++)
+	{
+		x = chain[i].update(chain[i].filter, x);
+	}
+	return x;
+}
@@ -0,0 +1,98 @@
+/*
+ * Filter.h
+ *
+ * Streaming filters for sensor values. Integer only, no division, constant
+ * work per sample.
+ *
+ *  EMA:        y += (x - y) / 2^shift, the state keeps shift fractional bits
+ *  Median:     median of the last 3, 5 or 7 samples, removes single spikes
+ *  Deadband:   output follows the input only when it moves more than band away
+ *  Quantize:   steps of 2^shift with a hysteresis around every step boundary
+ *
+ * Every filter can be used on its own (filter_xxx_update()) or as a stage of a
+ * chain, the output of one stage is the input of the next:
+ *
+ *  static filter_median_t Red_Median;
+ *  static filter_ema_t Red_Ema;
+ *  static const filter_stage_t Red_Chain[] = { FILTER_MEDIAN_STAGE(&Red_Median), FILTER_EMA_STAGE(&Red_Ema) };
+ *
+ *  filter_median_init(&Red_Median, 3);
+ *  filter_ema_init(&Red_Ema, 2);
+ *  Red = filter_chain_update(Red_Chain, 2, Red_Raw);
+ *
+ * The first sample after init sets the state of a filter, so there is no
+ * slow start from 0.
+ *
+ * The module is plain C without AVR headers, Tools/filter/filter_test.c
+ * checks it on the PC (the median against a sorted window).
+ */
+
+#ifndef FILTER_H_
+#define FILTER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Largest median window
+#define FILTER_MEDIAN_MAX 7
+
+typedef struct {
+	uint32_t acc;						// Output << shift
+	uint8_t shift;						// alpha = 1 / 2^shift
+	bool primed;						// false until the first sample
+} filter_ema_t;
+
+typedef struct {
+	uint16_t ring[FILTER_MEDIAN_MAX];	// Samples in arrival order
+	uint16_t sorted[FILTER_MEDIAN_MAX];	// The same samples, ascending
+	uint8_t size;						// Window (3, 5 or 7)
+	uint8_t count;						// Samples in the window (< size only at the start)
+	uint8_t head;						// Oldest sample in ring[]
+} filter_median_t;
+
+typedef struct {
+	uint16_t out;
+	uint16_t band;						// Allowed distance between input and output
+	bool primed;
+} filter_deadband_t;
+
+typedef struct {
+	uint16_t level;						// Output step, the value is level << shift
+	uint16_t hysteresis;				// Distance past a step boundary needed for a change
+	uint8_t shift;						// Step = 2^shift
+	bool primed;
+} filter_quantize_t;
+
+// One stage of a chain: filter function and its state
+typedef uint16_t (*filter_fn_t)(void *filter, uint16_t x);
+
+typedef struct {
+	filter_fn_t update;
+	void *filter;
+} filter_stage_t;
+
+#define FILTER_EMA_STAGE(f)			{ filter_ema_stage, (f) }
+#define FILTER_MEDIAN_STAGE(f)		{ filter_median_stage, (f) }
+#define FILTER_DEADBAND_STAGE(f)	{ filter_deadband_stage, (f) }
+#define FILTER_QUANTIZE_STAGE(f)	{ filter_quantize_stage, (f) }
+
+void filter_ema_init(filter_ema_t *f, uint8_t shift);
+uint16_t filter_ema_update(filter_ema_t *f, uint16_t x);
+
+bool filter_median_init(filter_median_t *f, uint8_t size);
+uint16_t filter_median_update(filter_median_t *f, uint16_t x);
+
+void filter_deadband_init(filter_deadband_t *f, uint16_t band);
+uint16_t filter_deadband_update(filter_deadband_t *f, uint16_t x);
+
+void filter_quantize_init(filter_quantize_t *f, uint8_t shift, uint16_t hysteresis);
+uint16_t filter_quantize_update(filter_quantize_t *f, uint16_t x);
+
+uint16_t filter_ema_stage(void *f, uint16_t x);
+uint16_t filter_median_stage(void *f, uint16_t x);
+uint16_t filter_deadband_stage(void *f, uint16_t x);
+uint16_t filter_quantize_stage(void *f, uint16_t x);
+
+uint16_t filter_chain_update(const filter_stage_t *chain, uint8_t count, uint16_t x);
+
+#endif /* FILTER_H_ */
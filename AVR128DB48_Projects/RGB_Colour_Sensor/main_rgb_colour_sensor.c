@@ -13,6 +13,7 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include "I2C_LCD.h"
+#include "Filter.h"
 
 // **TCS34725 register definitions start
 #define TCS34725_ADDRESS          0x29
@@ -31,6 +32,30 @@
 #define TCS34725_CMD_AUTO_INC     0x20											// Auto-increment protocol
 // TCS34725 register definitions end**
 
+// **Filter chains, one per colour: median of 3 (removes single spikes) -> EMA 1/4 (smooths) -> deadband +-4 (no redraw for noise)
+#define COLOUR_COUNT 3
+#define CHAIN_LENGTH 3
+
+static filter_median_t Colour_Median[COLOUR_COUNT];
+static filter_ema_t Colour_Ema[COLOUR_COUNT];
+static filter_deadband_t Colour_Deadband[COLOUR_COUNT];
+
+static const filter_stage_t Colour_Chain[COLOUR_COUNT][CHAIN_LENGTH] = {
+    { FILTER_MEDIAN_STAGE(&Colour_Median[0]), FILTER_EMA_STAGE(&Colour_Ema[0]), FILTER_DEADBAND_STAGE(&Colour_Deadband[0]) },
+    { FILTER_MEDIAN_STAGE(&Colour_Median[1]), FILTER_EMA_STAGE(&Colour_Ema[1]), FILTER_DEADBAND_STAGE(&Colour_Deadband[1]) },
+    { FILTER_MEDIAN_STAGE(&Colour_Median[2]), FILTER_EMA_STAGE(&Colour_Ema[2]), FILTER_DEADBAND_STAGE(&Colour_Deadband[2]) },
+};
+
+void filters_init(void) {
+    for (uint8_t i = 0; i < COLOUR_COUNT; i++)
+    {
+        filter_median_init(&Colour_Median[i], 3);
+        filter_ema_init(&Colour_Ema[i], 2);
+        filter_deadband_init(&Colour_Deadband[i], 4);
+    }
+}
+// End of filter chains**
+
 /*
  * @brief Initializes the TCS34725 Sensor
  */
@@ -87,10 +112,15 @@ int main(void)
     lcd_init();																	// Initialize LCD
     lcd_backlight(true);
     sensor_init();																// Initialize Color Sensor
+    filters_init();
 
     while (1) 
     {
         sensor_read_RGB(&Red, &Green, &Blue);									// Read sensor data
+        
+        Red = filter_chain_update(Colour_Chain[0], CHAIN_LENGTH, Red);			// Filtered values: only real colour changes get through
+        Green = filter_chain_update(Colour_Chain[1], CHAIN_LENGTH, Green);
+        Blue = filter_chain_update(Colour_Chain[2], CHAIN_LENGTH, Blue);
 
         if (Red != Last_Red || Green != Last_Green || Blue != Last_Blue)		// Check if values have changed
         {
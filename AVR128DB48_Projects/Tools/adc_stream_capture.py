@@ -0,0 +1,153 @@
+#!/usr/bin/env python3
+"""
+adc_stream_capture.py
+
+Captures the binary ADC stream of ADC_Stream (ADC&USART/ADC_Streaming) and
+reports the sustained throughput, lost frames and checksum errors.
+
+    python3 adc_stream_capture.py --port /dev/ttyACM0 --seconds 10 --csv samples.csv
+    python3 adc_stream_capture.py --input capture.bin
+
+With --port the script sends 's' to start the stream and 'x' when it is done.
+--raw saves the received bytes, they can be decoded again later with --input.
+Reading from a serial port needs pyserial (pip install pyserial).
+
+Frame (little endian, see ADC_Stream.h):
+    0xA5 0x5A | seq u16 | first channel << 4 | channels | n | n * 12-bit packed | checksum
+"""
+
+import argparse
+import sys
+import time
+
+SYNC = b"\xa5\x5a"
+HEADER_SIZE = 6
+
+
+def unpack_samples(payload, count):
+    """Unpacks count 12-bit samples, two samples per 3 bytes."""
+    samples = []
+    for i in range(0, count, 2):
+        b0, b1, b2 = payload[i // 2 * 3:i // 2 * 3 + 3]
+        samples.append(b0 | (b1 & 0x0F) << 8)
+        if i + 1 < count:
+            samples.append(b1 >> 4 | b2 << 4)
+    return samples
+
+
+class StreamDecoder:
+    """Finds frames in a byte stream, checks them and keeps statistics."""
+
+    def __init__(self):
+        self.buffer = bytearray()
+        self.frames = 0
+        self.samples = 0
+        self.lost = 0
+        self.bad = 0
+        self.last_seq = None
+        self.channels = {}                      # channel -> list of samples
+
+    def feed(self, data):
+        self.buffer += data
+        while True:
+            start = self.buffer.find(SYNC)
+            if start < 0:
+                del self.buffer[:-1]            # Keep a possible first sync byte
+                return
+            del self.buffer[:start]
+            if len(self.buffer) < HEADER_SIZE:
+                return
+            count = self.buffer[5]
+            size = HEADER_SIZE + (count + 1) // 2 * 3 + 1
+            if count == 0 or count & 1:
+                del self.buffer[:1]             # Not a real header, resync
+                continue
+            if len(self.buffer) < size:
+                return
+            frame = bytes(self.buffer[:size])
+            if sum(frame[2:-1]) & 0xFF != frame[-1]:
+                self.bad += 1
+                del self.buffer[:1]             # Sync bytes inside the data, resync
+                continue
+            del self.buffer[:size]
+            self.handle(frame, count)
+
+    def handle(self, frame, count):
+        seq = frame[2] | frame[3] << 8
+        if self.last_seq is not None:
+            self.lost += (seq - self.last_seq - 1) & 0xFFFF
+        self.last_seq = seq
+        self.frames += 1
+        self.samples += count
+
+        first = frame[4] >> 4
+        n_channels = frame[4] & 0x0F or 1
+        for i, value in enumerate(unpack_samples(frame[HEADER_SIZE:-1], count)):
+            self.channels.setdefault((first + i) % n_channels, []).append(value)
+
+
+def capture(port, baud, seconds, decoder, raw_file):
+    import serial  # pyserial
+    received = 0
+    with serial.Serial(port, baud, timeout=0.1) as ser:
+        ser.reset_input_buffer()
+        ser.write(b"s")
+        start = time.monotonic()
+        try:
+            while time.monotonic() - start < seconds:
+                chunk = ser.read(4096)
+                if chunk:
+                    received += len(chunk)
+                    decoder.feed(chunk)
+                    if raw_file:
+                        raw_file.write(chunk)
+        except KeyboardInterrupt:
+            pass
+        elapsed = time.monotonic() - start
+        ser.write(b"x")
+    return received, elapsed
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Capture and check the ADC_Stream binary frames")
+    src = parser.add_mutually_exclusive_group(required=True)
+    src.add_argument("--input", help="file with raw stream bytes")
+    src.add_argument("--port", help="serial port of the board")
+    parser.add_argument("--baud", type=int, default=500000)
+    parser.add_argument("--seconds", type=float, default=5.0, help="capture time with --port")
+    parser.add_argument("--raw", help="save the received bytes to this file")
+    parser.add_argument("--csv", help="write the samples as CSV, one column per channel")
+    args = parser.parse_args()
+
+    decoder = StreamDecoder()
+    if args.input:
+        data = open(args.input, "rb").read()
+        decoder.feed(data)
+        received, elapsed = len(data), None
+    else:
+        raw_file = open(args.raw, "wb") if args.raw else None
+        received, elapsed = capture(args.port, args.baud, args.seconds, decoder, raw_file)
+        if raw_file:
+            raw_file.close()
+
+    sys.stderr.write("%d frames, %d samples, %d frames lost (sequence gaps), %d checksum errors\n"
+                     % (decoder.frames, decoder.samples, decoder.lost, decoder.bad))
+    if elapsed:
+        sys.stderr.write("%.1f s: %.0f samples/s, %.1f kB/s (%.0f%% of %d baud)\n"
+                         % (elapsed, decoder.samples / elapsed, received / elapsed / 1000,
+                            received * 10 / elapsed / args.baud * 100, args.baud))
+    for ch in sorted(decoder.channels):
+        values = decoder.channels[ch]
+        sys.stderr.write("channel %d: %d samples, min %d, max %d, mean %.1f\n"
+                         % (ch, len(values), min(values), max(values), sum(values) / len(values)))
+
+    if args.csv:
+        columns = [decoder.channels[ch] for ch in sorted(decoder.channels)]
+        with open(args.csv, "w") as f:
+            f.write(",".join("ch%d" % ch for ch in sorted(decoder.channels)) + "\n")
+            for row in zip(*columns):
+                f.write(",".join(str(v) for v in row) + "\n")
+
+
+if __name__ == "__main__":
+    main()
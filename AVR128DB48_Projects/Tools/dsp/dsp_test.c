@@ -0,0 +1,160 @@
+/*
+ * dsp_test.c
+ *
+ * Checks DSP on the PC against double math: sine table, square root,
+ * Goertzel amplitudes for every whole bin (the accuracy stated in DSP.h)
+ * and FFT magnitudes.
+ *
+ *   cd Tools/dsp
+ *   gcc -O2 -Wall -I"../../ADC&USART/ADC_Light_Flicker/Includes/DSP" -o dsp_test \
+ *       dsp_test.c "../../ADC&USART/ADC_Light_Flicker/Includes/DSP/DSP.c" -lm
+ *   ./dsp_test
+ *
+ * Prints one line per check, exit status 0 if all passed.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "DSP.h"
+#include "../host_test.h"
+
+#define SAMPLE_HZ 1280								// ADC_Light_Flicker, every bin is a whole number of Hz up to N = 256
+#define MID 2048
+
+static const double Amplitudes[] = { 500, 1000, 1500, 2047 };
+
+#define AMPLITUDE_COUNT (sizeof(Amplitudes) / sizeof(Amplitudes[0]))
+#define PHASES 8
+
+static void make_tone(uint16_t *samples, uint16_t n, double cycles, double amplitude, double phase)
+{
+	for (uint16_t i = 0; i < n; i++)
+	{
+		samples[i] = (uint16_t)lround(MID + amplitude * sin(2.0 * M_PI * cycles * i / n + phase));
+	}
+}
+
+static void check_sine(void)
+{
+	double worst = 0;
+
+	for (uint32_t phase = 0; phase < 65536; phase++)
+	{
+		double err_sin = fabs(dsp_sin_q15((uint16_t)phase) - 32767.0 * sin(2.0 * M_PI * phase / 65536.0));
+		double err_cos = fabs(dsp_cos_q15((uint16_t)phase) - 32767.0 * cos(2.0 * M_PI * phase / 65536.0));
+
+		if (err_sin > worst) worst = err_sin;
+		if (err_cos > worst) worst = err_cos;
+	}
+	check(worst < 4, "dsp_sin_q15() / dsp_cos_q15() error < 4 LSB");
+}
+
+static void check_sqrt(void)
+{
+	int ok = 1;
+
+	srand(1);
+	for (long n = 0; n < 1000000; n++)
+	{
+		uint32_t x = (n < 100000) ? (uint32_t)n : ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+		uint32_t root = dsp_sqrt32(x);
+
+		ok &= (uint64_t)root * root <= x && (uint64_t)(root + 1) * (root + 1) > x;
+	}
+	ok &= dsp_sqrt32(0xFFFFFFFFUL) == 0xFFFF;
+	check(ok, "dsp_sqrt32() = floor(sqrt(x))");
+}
+
+/*
+	Worst relative Goertzel error in %, for the bins selected by edge:
+	edge bins are the 2 next to 0 and N / 2, the others the rest.
+*/
+static double goertzel_error(uint16_t n, int edge)
+{
+	uint16_t samples[256];
+	double worst = 0;
+
+	for (uint16_t k = 1; k < n / 2; k++)
+	{
+		int is_edge = k <= 2 || k >= n / 2 - 2;
+
+		if (is_edge != edge)
+			continue;
+
+		for (uint8_t a = 0; a < AMPLITUDE_COUNT; a++)
+		{
+			for (uint8_t p = 0; p < PHASES; p++)
+			{
+				dsp_goertzel_t g;
+
+				make_tone(samples, n, k, Amplitudes[a], p * 0.7);
+				dsp_goertzel_init(&g, (uint16_t)(k * SAMPLE_HZ / n), SAMPLE_HZ);
+
+				double error = fabs(dsp_goertzel_run(&g, samples, n, MID) - Amplitudes[a]) * 100.0 / Amplitudes[a];
+
+				if (error > worst) worst = error;
+			}
+		}
+	}
+
+	return worst;
+}
+
+static void check_goertzel(void)
+{
+	check(goertzel_error(64, 0) <= 0.2 && goertzel_error(64, 1) <= 0.2, "Goertzel N = 64: all bins within 0.2%");
+	check(goertzel_error(128, 0) <= 0.3 && goertzel_error(256, 0) <= 0.3, "Goertzel N = 128, 256: within 0.3% off the edges");
+	check(goertzel_error(128, 1) <= 1.1 && goertzel_error(256, 1) <= 1.1, "Goertzel N = 128, 256: edge bins within 1.1%");
+
+	// Light flicker set-up: 100Hz tone, 120Hz detector must see (almost) nothing
+	uint16_t samples[256];
+	dsp_goertzel_t g100;
+	dsp_goertzel_t g120;
+
+	make_tone(samples, 256, 100.0 * 256 / SAMPLE_HZ, 1000, 0.3);
+	dsp_goertzel_init(&g100, 100, SAMPLE_HZ);
+	dsp_goertzel_init(&g120, 120, SAMPLE_HZ);
+	check(abs(dsp_goertzel_run(&g100, samples, 256, MID) - 1000) <= 2 && dsp_goertzel_run(&g120, samples, 256, MID) <= 2,
+		"100Hz tone: 1000 at 100Hz, ~0 at 120Hz");
+}
+
+static void check_fft(void)
+{
+	uint16_t samples[256];
+	int16_t re[256];
+	int16_t im[256];
+	int ok = 1;
+
+	for (uint8_t log2n = DSP_FFT_MIN_LOG2; log2n <= DSP_FFT_MAX_LOG2; log2n++)
+	{
+		uint16_t n = 1U << log2n;
+
+		for (uint16_t k = 1; k < n / 2; k += 3)
+		{
+			make_tone(samples, n, k, 2000, 1.0);
+			for (uint16_t i = 0; i < n; i++)
+			{
+				re[i] = (int16_t)(samples[i] - MID);
+				im[i] = 0;
+			}
+			dsp_fft(re, im, log2n);
+
+			// A / 2 in the bin (1% + rounding of the log2(N) stages), little elsewhere
+			ok &= fabs(dsp_magnitude(re[k], im[k]) - 1000.0) <= 10 + log2n;
+			ok &= dsp_magnitude(re[(k + n / 4) & (n - 1)], im[(k + n / 4) & (n - 1)]) <= log2n;
+		}
+	}
+	check(ok, "FFT 64 ... 256: |X[k]| = A / 2, other bins near 0");
+}
+
+int main(void)
+{
+	check_sine();
+	check_sqrt();
+	check_goertzel();
+	check_fft();
+
+	return host_test_result();
+}
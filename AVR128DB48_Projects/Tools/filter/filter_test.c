@@ -0,0 +1,175 @@
+/*
+ * filter_test.c
+ *
+ * Checks Filter on the PC: the in-place sliding median against a sorted copy
+ * of the last samples, the EMA settling on its input from both sides, the
+ * deadband and quantizer hysteresis and a chain against its stages.
+ *
+ *   cd Tools/filter
+ *   gcc -O2 -Wall -I"../../ADC&USART/ADC_Photoresistor/Includes/Filter" -o filter_test \
+ *       filter_test.c "../../ADC&USART/ADC_Photoresistor/Includes/Filter/Filter.c"
+ *   ./filter_test
+ *
+ * Prints one line per check, exit status 0 if all passed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Filter.h"
+#include "../host_test.h"
+
+#define MEDIAN_SAMPLES 200000
+
+static int compare_u16(const void *a, const void *b)
+{
+	return (int)*(const uint16_t *)a - (int)*(const uint16_t *)b;
+}
+
+/*
+	@return Median of the last n samples before history[end] (all of them if fewer), by sorting
+*/
+static uint16_t reference_median(const uint16_t *history, long end, uint8_t size)
+{
+	uint16_t window[FILTER_MEDIAN_MAX];
+	uint8_t n = (end < size) ? (uint8_t)end : size;
+
+	memcpy(window, &history[end - n], n * sizeof(uint16_t));
+	qsort(window, n, sizeof(uint16_t), compare_u16);
+	return window[n / 2];
+}
+
+/*
+	@param range Sample values 0 ... range - 1, small ranges give many equal samples
+	@return true if every output matches the reference
+*/
+static int median_matches(uint8_t size, uint16_t range)
+{
+	static uint16_t history[MEDIAN_SAMPLES];
+	filter_median_t f;
+
+	filter_median_init(&f, size);
+	for (long i = 0; i < MEDIAN_SAMPLES; i++)
+	{
+		history[i] = (uint16_t)(rand() % range);
+		if (filter_median_update(&f, history[i]) != reference_median(history, i + 1, size))
+			return 0;
+	}
+	return 1;
+}
+
+static void check_median(void)
+{
+	filter_median_t f;
+	int ok = 1;
+
+	srand(1);
+	for (uint8_t size = 3; size <= FILTER_MEDIAN_MAX; size += 2)
+	{
+		ok &= median_matches(size, 65535);
+		ok &= median_matches(size, 4);
+	}
+	check(ok, "median 3/5/7 = sorted window, random and repeated");
+
+	check(!filter_median_init(&f, 0) && !filter_median_init(&f, 4) && !filter_median_init(&f, 9),
+		"median init rejects 0, even and too large windows");
+
+	// A single spike never reaches the output
+	filter_median_init(&f, 3);
+	ok = 1;
+	for (int i = 0; i < 20; i++)
+		ok &= filter_median_update(&f, (i == 10) ? 4000 : 100) == 100;
+	check(ok, "median 3 removes a single spike");
+}
+
+static void check_ema(void)
+{
+	filter_ema_t f;
+	int ok = 1;
+
+	for (uint8_t shift = 0; shift <= 8; shift++)
+	{
+		for (uint16_t start = 0; start <= 4000; start += 4000)
+		{
+			uint16_t y = 0;
+
+			filter_ema_init(&f, shift);
+			ok &= filter_ema_update(&f, start) == start;	// First sample primes
+			for (int i = 0; i < 5000; i++)
+				y = filter_ema_update(&f, 1234);
+			ok &= y == 1234;
+		}
+	}
+	check(ok, "EMA settles exactly on the input from above and below");
+
+	filter_ema_init(&f, 2);
+	filter_ema_update(&f, 0);
+	check(filter_ema_update(&f, 1000) == 250, "EMA 1/4: first step is a quarter");
+}
+
+static void check_deadband(void)
+{
+	filter_deadband_t f;
+	int ok = 1;
+
+	filter_deadband_init(&f, 4);
+	ok &= filter_deadband_update(&f, 100) == 100;
+	for (uint16_t x = 96; x <= 104; x++)
+		ok &= filter_deadband_update(&f, x) == 100;
+	ok &= filter_deadband_update(&f, 110) == 106;
+	ok &= filter_deadband_update(&f, 103) == 106;
+	ok &= filter_deadband_update(&f, 90) == 94;
+	ok &= filter_deadband_update(&f, 0) == 4;
+	check(ok, "deadband 4: holds inside the band, follows at band");
+}
+
+static void check_quantize(void)
+{
+	filter_quantize_t f;
+	int ok = 1;
+
+	filter_quantize_init(&f, 4, 3);							// Steps of 16, hysteresis 3
+	ok &= filter_quantize_update(&f, 40) == 32;
+	ok &= filter_quantize_update(&f, 49) == 32;				// 1 past the boundary at 48
+	ok &= filter_quantize_update(&f, 51) == 48;				// 3 past
+	ok &= filter_quantize_update(&f, 46) == 48;				// 2 below 48
+	ok &= filter_quantize_update(&f, 44) == 32;				// 4 below
+	ok &= filter_quantize_update(&f, 100) == 96;			// More than one step: at once
+	check(ok, "quantize 16 with hysteresis 3");
+}
+
+static void check_chain(void)
+{
+	filter_median_t m1, m2;
+	filter_ema_t e1, e2;
+	filter_deadband_t d1, d2;
+	const filter_stage_t chain[] = { FILTER_MEDIAN_STAGE(&m1), FILTER_EMA_STAGE(&e1), FILTER_DEADBAND_STAGE(&d1) };
+	int ok = 1;
+
+	filter_median_init(&m1, 3);
+	filter_median_init(&m2, 3);
+	filter_ema_init(&e1, 2);
+	filter_ema_init(&e2, 2);
+	filter_deadband_init(&d1, 4);
+	filter_deadband_init(&d2, 4);
+
+	for (int i = 0; i < 10000; i++)
+	{
+		uint16_t x = (uint16_t)(rand() % 4096);
+		uint16_t y = filter_deadband_update(&d2, filter_ema_update(&e2, filter_median_update(&m2, x)));
+
+		ok &= filter_chain_update(chain, 3, x) == y;
+	}
+	check(ok, "chain = stages applied in order");
+}
+
+int main(void)
+{
+	check_median();
+	check_ema();
+	check_deadband();
+	check_quantize();
+	check_chain();
+
+	return host_test_result();
+}
@@ -0,0 +1,176 @@
+/*
+ * fixed_point_test.c
+ *
+ * Checks Fixed_Point on the PC against the formulas it replaced: fixed_scale()
+ * with every input of every scale the projects use (the temperature scale
+ * for every calibration value), FIXED_Q() / fixed_q_mul() against double math.
+ *
+ *   cd Tools/fixed_point
+ *   gcc -O2 -Wall -I"../../ADC&USART/ADC_Potantiometer/Includes/Fixed_Point" -o fixed_point_test \
+ *       fixed_point_test.c "../../ADC&USART/ADC_Potantiometer/Includes/Fixed_Point/Fixed_Point.c" -lm
+ *   ./fixed_point_test
+ *
+ * Prints one line per check, exit status 0 if all passed.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "Fixed_Point.h"
+#include "../host_test.h"
+
+#define RANDOM_Q_PAIRS 1000000
+
+/*
+	@return Number of inputs 0 ... x_max where fixed_scale() differs from the division
+*/
+static unsigned long mismatches(const fixed_scale_t *scale, uint16_t num, uint16_t den, uint16_t x_max)
+{
+	unsigned long count = 0;
+
+	for (uint32_t x = 0; x <= x_max; x++)
+	{
+		if (fixed_scale(scale, (uint16_t)x) != (uint16_t)(((uint32_t)x * num) / den))
+			count++;
+	}
+
+	return count;
+}
+
+/*
+	A constant scale (FIXED_SCALE()) and the same one made at run time, every input.
+*/
+static void check_scale(uint16_t num, uint16_t den, uint16_t x_max, const char *name)
+{
+	const fixed_scale_t constant = FIXED_SCALE(num, den);
+	fixed_scale_t runtime;
+	int ok = FIXED_SCALE_FITS(num, den, x_max) && fixed_scale_init(&runtime, num, den, x_max);
+
+	ok = ok && mismatches(&constant, num, den, x_max) == 0 && mismatches(&runtime, num, den, x_max) == 0;
+	check(ok, name);
+}
+
+/*
+	Internal temperature: K = x * 358 / cal for the 12-bit result and every
+	calibration value fixed_scale_init() accepts.
+*/
+static void check_temperature(void)
+{
+	unsigned long bad = 0;
+	unsigned long refused = 0;
+
+	for (uint32_t cal = 1; cal <= 0xFFFF; cal++)
+	{
+		fixed_scale_t scale;
+
+		if (!fixed_scale_init(&scale, 358, (uint16_t)cal, 4095))
+		{
+			refused++;
+			continue;
+		}
+		bad += mismatches(&scale, 358, (uint16_t)cal, 4095);
+	}
+
+	// 4095 * 358 / cal <= 65535 holds from cal = 23 on
+	check(bad == 0 && refused == 22, "358 / cal, cal 1 ... 65535, x 0 ... 4095");
+
+	fixed_scale_t scale;
+	check(!fixed_scale_init(&scale, 358, 0, 4095), "fixed_scale_init() refuses cal = 0");
+}
+
+/*
+	Dimming Red LED: compare value (p / 100) * 256 - 1, old double formula.
+*/
+static void check_duty(void)
+{
+	const fixed_scale_t duty = FIXED_SCALE(256, 100);
+	int ok = 1;
+
+	for (uint16_t p = 1; p <= 100; p++)
+	{
+		uint16_t old = (uint16_t)(((double)p / 100.0) * 256.0 - 1);
+
+		ok &= (uint16_t)(fixed_scale(&duty, p) - 1) == old;
+	}
+	check(ok, "256 / 100 duty cycle, same as the double formula");
+}
+
+/*
+	Gamma table of ADC_Fast_Path: i^2 * 1023 / 255^2, every input up to 255^2.
+*/
+static void check_gamma(void)
+{
+	check_scale(1023, 255U * 255U, 255U * 255U, "gamma 1023 / 65025, x 0 ... 65025");
+}
+
+static int16_t round_double(double value)
+{
+	return (int16_t)floor(value + 0.5);
+}
+
+/*
+	FIXED_Q() rounds like the old double constant, fixed_q_mul() like the
+	double product rounded to nearest (half up).
+*/
+static void check_q(void)
+{
+	int ok = 1;
+
+	// Constants: 0.001 steps from -1 to 1 in Q8 ... Q14
+	for (uint8_t frac = 8; frac <= 14; frac++)
+	{
+		for (int i = -1000; i <= 1000; i++)
+		{
+			double value = i / 1000.0;
+
+			ok &= FIXED_Q(value, frac) == (int16_t)lround(value * (1L << frac));
+		}
+	}
+	ok &= FIXED_Q(0.75, 8) == 192 && FIXED_Q(0.8, 8) == 205 && FIXED_Q(-0.5, 8) == -128;
+	check(ok, "FIXED_Q() matches lround(value * 2^frac)");
+
+	// Cycle_Benchmark: 14-bit ADC value (Q8 integer) * 0.8
+	ok = 1;
+	for (int16_t x = 0; x <= 16380; x++)
+	{
+		int16_t exact = round_double((double)x * FIXED_Q(0.8, 8) / 256.0);
+		int16_t q = fixed_q_mul(x, FIXED_Q(0.8, 8), 8);
+
+		ok &= q == exact;
+		ok &= fabs(q - x * 0.8) <= x * (0.5 / 256.0) + 0.5;		// Constant rounding + result rounding
+	}
+	check(ok, "fixed_q_mul(x, FIXED_Q(0.8, 8), 8), x 0 ... 16380");
+
+	// Random pairs whose product fits into int16
+	ok = 1;
+	srand(1);
+	for (long n = 0; n < RANDOM_Q_PAIRS; n++)
+	{
+		uint8_t frac = (uint8_t)(1 + rand() % 15);
+		int16_t a = (int16_t)(rand() % 65536 - 32768);
+		int16_t b = (int16_t)(rand() % 65536 - 32768);
+		double product = (double)a * b / (1L << frac);
+
+		if (product < -32768.0 || product >= 32767.0)
+			continue;
+
+		ok &= fixed_q_mul(a, b, frac) == round_double(product);
+	}
+	check(ok, "fixed_q_mul() random pairs, frac 1 ... 15");
+}
+
+int main(void)
+{
+	check_scale(3300, 4095, 4095, "3300 / 4095 (mV, 12-bit), x 0 ... 4095");
+	check_scale(3300, 16380, 16380, "3300 / 16380 (mV, 14-bit), x 0 ... 16380");
+	check_scale(100, 16380, 16380, "100 / 16380 (percent, 14-bit), x 0 ... 16380");
+	check_scale(100, 3600, 3600, "100 / 3600, x 0 ... 3600");
+	check_scale(100, 2900, 3300, "100 / 2900 (light percent), x 0 ... 3300 mV");
+	check_scale(2000, 4095, 4095, "servo 2000 / 4095 (0.5us counts), x 0 ... 4095");
+	check_temperature();
+	check_duty();
+	check_gamma();
+	check_q();
+
+	return host_test_result();
+}
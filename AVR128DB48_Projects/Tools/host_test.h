@@ -0,0 +1,33 @@
+/*
+ * host_test.h
+ *
+ * Result reporting shared by the PC test programs in Tools/ (one per test,
+ * include it once): check() prints one line per check, host_test_result()
+ * the summary and the exit status (0 if all checks passed).
+ *
+ *   #include "../host_test.h"
+ *   check(value == 42, "value is 42");
+ *   return host_test_result();
+ */
+
+#ifndef HOST_TEST_H_
+#define HOST_TEST_H_
+
+#include <stdio.h>
+
+static int Failures = 0;
+
+static void check(int ok, const char *name)
+{
+	printf("%-56s %s\n", name, ok ? "ok" : "FAILED");
+	if (!ok)
+		Failures++;
+}
+
+static int host_test_result(void)
+{
+	printf("%s\n", Failures == 0 ? "all checks passed" : "CHECKS FAILED");
+	return Failures == 0 ? 0 : 1;
+}
+
+#endif /* HOST_TEST_H_ */
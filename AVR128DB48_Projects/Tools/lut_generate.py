@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+"""
+lut_generate.py
+
+Generates a Lookup_Table (LUT) from sensor calibration points. The table has
+one entry every 2^shift input units from 0 to x_max, the firmware interpolates
+linearly between the entries (lut_interpolate()).
+
+    python3 lut_generate.py --x-max 3300 --shift 6 --interp loglog --name Lux 387:1 1320:10 2540:100
+    python3 lut_generate.py --x-max 16380 --shift 10 --csv calibration.csv --name Temp
+
+A point is "x:y" (e.g. mV:lux), a CSV file has one "x,y" pair per line.
+Between the calibration points the curve is interpolated linearly, or with
+--interp loglog as a straight line in log-log scale (power law sensors such
+as an LDR: lux ~ R^-1/gamma). Below the first point the curve goes linearly
+to (0, 0) with --from-zero, otherwise it stays at the first y; above the
+last point it stays at the last y. Outputs are rounded and limited to 0..65535.
+
+The C code for the table is printed to stdout, the largest difference
+between the interpolated table and the calibration curve to stderr.
+"""
+
+import argparse
+import math
+import sys
+
+
+def read_points(args):
+    points = []
+    for text in args.points:
+        x, y = text.split(":")
+        points.append((float(x), float(y)))
+    if args.csv:
+        with open(args.csv) as f:
+            for line in f:
+                line = line.split("#")[0].strip()
+                if line:
+                    x, y = line.split(",")[:2]
+                    points.append((float(x), float(y)))
+    points.sort()
+    if len(points) < 2:
+        sys.exit("at least 2 calibration points are needed")
+    if any(b[0] == a[0] for a, b in zip(points, points[1:])):
+        sys.exit("x values of the calibration points must be different")
+    if args.interp == "loglog" and any(x <= 0 or y <= 0 for x, y in points):
+        sys.exit("loglog interpolation needs x > 0 and y > 0")
+    return points
+
+
+def curve(points, interp, from_zero):
+    """Returns y(x) through the calibration points."""
+    def y_of(x):
+        x0, y0 = points[0]
+        if x <= x0:
+            return y0 * x / x0 if from_zero and x0 > 0 else y0
+        if x >= points[-1][0]:
+            return points[-1][1]
+        for (xa, ya), (xb, yb) in zip(points, points[1:]):
+            if x <= xb:
+                if interp == "loglog":
+                    t = (math.log(x) - math.log(xa)) / (math.log(xb) - math.log(xa))
+                    return math.exp(math.log(ya) + t * (math.log(yb) - math.log(ya)))
+                return ya + (yb - ya) * (x - xa) / (xb - xa)
+    return y_of
+
+
+def clamp(value):
+    return max(0, min(65535, int(round(value))))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate an interpolated lookup table for Lookup_Table")
+    parser.add_argument("points", nargs="*", help="calibration points x:y")
+    parser.add_argument("--csv", help="file with x,y calibration points")
+    parser.add_argument("--x-max", type=int, required=True, help="largest input value (e.g. 3300 mV or 16380)")
+    parser.add_argument("--shift", type=int, required=True, help="2^shift input units per table segment (1..15)")
+    parser.add_argument("--interp", choices=("linear", "loglog"), default="linear")
+    parser.add_argument("--from-zero", action="store_true", help="start the curve at (0, 0)")
+    parser.add_argument("--name", default="Sensor", help="prefix of the C names")
+    args = parser.parse_args()
+
+    if not 1 <= args.shift <= 15:
+        sys.exit("shift must be 1..15")
+    if not 0 < args.x_max <= 65535:
+        sys.exit("x_max must be 1..65535")
+
+    points = read_points(args)
+    y_of = curve(points, args.interp, args.from_zero)
+
+    step = 1 << args.shift
+    size = (args.x_max >> args.shift) + 2           # The last segment must reach x_max
+    table = [clamp(y_of(i * step)) for i in range(size)]
+
+    # Check the integer interpolation against the curve at every input value
+    worst = (0.0, 0)
+    for x in range(args.x_max + 1):
+        seg, frac = x >> args.shift, x & (step - 1)
+        if seg >= size - 1:
+            got = table[-1]
+        else:
+            y0, y1 = table[seg], table[seg + 1]     # Same rounding as lut_interpolate()
+            if y1 >= y0:
+                got = y0 + ((y1 - y0) * frac + step // 2 >> args.shift)
+            else:
+                got = y0 - ((y0 - y1) * frac + step // 2 >> args.shift)
+        error = abs(got - y_of(x))
+        if error > worst[0]:
+            worst = (error, x)
+
+    command = " ".join(a if " " not in a else '"%s"' % a for a in sys.argv[1:])
+    print("// Generated by Tools/lut_generate.py %s" % command)
+    print("// %d entries, %d input units per segment" % (size, step))
+    print("static const uint16_t %s_Table[%d] LUT_FLASH = {" % (args.name, size))
+    for i in range(0, size, 12):
+        print("\t" + ", ".join("%5d" % v for v in table[i:i + 12]) + ",")
+    print("};")
+    print("static const lut_t %s_Lut = LUT_INIT(%s_Table, %d);" % (args.name, args.name, args.shift))
+
+    sys.stderr.write("largest interpolation error: %.1f at x = %d (%d bytes of flash)\n"
+                     % (worst[0], worst[1], size * 2))
+
+
+if __name__ == "__main__":
+    main()
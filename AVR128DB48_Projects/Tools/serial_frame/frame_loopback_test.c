@@ -0,0 +1,223 @@
+/*
+ * frame_loopback_test.c
+ *
+ * Checks Frame_Codec and serial_frame_host without hardware: frames are
+ * sent through a pseudo terminal pair (master <-> slave) in both directions,
+ * including damaged, truncated and oversized frames and noise on the line.
+ *
+ *   cd Tools/serial_frame
+ *   gcc -O2 -Wall -I"../../ADC&USART/USART_Framed_Protocol/Includes/Frame_Codec" -o frame_loopback_test \
+ *       frame_loopback_test.c serial_frame_host.c "../../ADC&USART/USART_Framed_Protocol/Includes/Frame_Codec/Frame_Codec.c"
+ *   ./frame_loopback_test
+ *
+ * Prints one line per check, exit status 0 if all passed.
+ */
+
+#define _XOPEN_SOURCE 600
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "serial_frame_host.h"
+#include "../host_test.h"
+
+#define RANDOM_FRAMES 500
+
+static int open_pty_pair(int *master, int *slave)
+{
+	*master = posix_openpt(O_RDWR | O_NOCTTY);
+	if (*master < 0 || grantpt(*master) != 0 || unlockpt(*master) != 0)
+		return -1;
+
+	*slave = open(ptsname(*master), O_RDWR | O_NOCTTY);
+	if (*slave < 0)
+		return -1;
+
+	// Raw on both ends, otherwise the line discipline changes 0x00, CR, ...
+	if (sf_configure(*master, 0) != 0 || sf_configure(*slave, 0) != 0)
+		return -1;
+
+	return 0;
+}
+
+static void fill_random(uint8_t *data, int length)
+{
+	for (int i = 0; i < length; i++)
+	{
+		// Many zeros and 0xFF, the interesting bytes for COBS
+		int r = rand() % 4;
+		data[i] = (r == 0) ? 0 : (r == 1) ? 0xFF : (uint8_t)rand();
+	}
+}
+
+static int same_frame(const frame_t *frame, uint8_t type, uint8_t sequence, const uint8_t *payload, uint8_t length)
+{
+	frame_t copy = *frame;
+
+	return frame_type(&copy) == type && frame_sequence(&copy) == sequence
+		&& frame_payload_length(&copy) == length && memcmp(frame_payload(&copy), payload, length) == 0;
+}
+
+static void write_all(int fd, const uint8_t *data, int length)
+{
+	while (length > 0)
+	{
+		ssize_t n = write(fd, data, length);
+		if (n <= 0)
+		{
+			perror("write");
+			exit(2);
+		}
+		data += n;
+		length -= n;
+	}
+}
+
+static void test_codec(void)
+{
+	const uint8_t text[] = "123456789";
+	check(frame_crc(text, 9) == 0x29B1, "CRC-16/CCITT-FALSE check value 0x29B1");
+
+	// Every payload length, the encoded frame has no 0x00 except the delimiter
+	int ok = 1;
+	for (int length = 0; length <= FRAME_MAX_PAYLOAD; length++)
+	{
+		for (int round = 0; round < 50; round++)
+		{
+			frame_t frame, decoded;
+			frame_decoder_t decoder;
+			uint8_t payload[FRAME_MAX_PAYLOAD], encoded[FRAME_MAX_ENCODED];
+			frame_rx_result_t result = FRAME_RX_BUSY;
+
+			fill_random(payload, length);
+			memcpy(frame_payload(&frame), payload, length);
+			frame_finish(&frame, (uint8_t)rand(), (uint8_t)round, (uint8_t)length);
+
+			int size = sf_encode(&frame, encoded);
+			ok &= size <= FRAME_MAX_ENCODED && size == frame.size + 2 && encoded[size - 1] == 0;
+			ok &= memchr(encoded, 0, size - 1) == NULL;
+
+			frame_decoder_start(&decoder, &decoded);
+			for (int i = 0; i < size; i++)
+			{
+				result = frame_decoder_put(&decoder, encoded[i]);
+				ok &= (i == size - 1) || result == FRAME_RX_BUSY;
+			}
+			ok &= result == FRAME_RX_OK && decoded.size == frame.size && memcmp(decoded.data, frame.data, frame.size) == 0;
+		}
+	}
+	check(ok, "encode/decode all payload lengths (0 ... max)");
+
+	// Oversized payloads are refused
+	frame_t frame;
+	check(!frame_finish(&frame, 1, 0, FRAME_MAX_PAYLOAD + 1), "frame_finish() refuses a too long payload");
+}
+
+/*
+	Random frames from one end to the other, written in random pieces.
+*/
+static void test_transfer(int from_fd, int to_fd, const char *name)
+{
+	sf_link_t sender, receiver;
+	int ok = 1;
+
+	sf_init(&sender, from_fd);
+	sf_init(&receiver, to_fd);
+
+	for (int n = 0; n < RANDOM_FRAMES && ok; n++)
+	{
+		uint8_t payload[FRAME_MAX_PAYLOAD];
+		uint8_t length = (uint8_t)(rand() % (FRAME_MAX_PAYLOAD + 1));
+		uint8_t type = (uint8_t)(1 + rand() % 255);
+		uint8_t sequence = sender.tx_sequence;
+
+		fill_random(payload, length);
+		ok &= sf_send(&sender, type, payload, length) == 0;
+		ok &= sf_receive(&receiver, 1000) == 1;
+		ok &= same_frame(&receiver.rx_frame, type, sequence, payload, length);
+	}
+
+	ok &= receiver.rx_frames == RANDOM_FRAMES && receiver.crc_errors == 0 && receiver.format_errors == 0;
+	check(ok, name);
+}
+
+/*
+	Damaged data on the line: the bad frame is counted, the next one arrives.
+*/
+static void test_errors(int master, int slave)
+{
+	sf_link_t receiver;
+	frame_t frame;
+	uint8_t encoded[FRAME_MAX_ENCODED];
+	const uint8_t good_payload[] = { 0x11, 0x00, 0x22 };
+	int size;
+
+	sf_init(&receiver, slave);
+	memcpy(frame_payload(&frame), good_payload, sizeof(good_payload));
+	frame_finish(&frame, 0x42, 7, sizeof(good_payload));
+	size = sf_encode(&frame, encoded);
+
+	// One flipped bit in the payload
+	uint8_t bad[FRAME_MAX_ENCODED];
+	memcpy(bad, encoded, size);
+	bad[3] ^= 0x10;
+	write_all(master, bad, size);
+	write_all(master, encoded, size);
+	check(sf_receive(&receiver, 1000) == 1 && receiver.crc_errors == 1
+		&& same_frame(&receiver.rx_frame, 0x42, 7, good_payload, sizeof(good_payload)), "flipped bit: CRC error, next frame ok");
+
+	// Frame cut off (receiver joins in the middle), then a good one
+	write_all(master, &encoded[4], size - 4);
+	write_all(master, encoded, size);
+	check(sf_receive(&receiver, 1000) == 1 && receiver.crc_errors + receiver.format_errors == 2,
+		"truncated frame: rejected, resync at delimiter");
+
+	// Noise without delimiter in front of a frame that starts with 0x00
+	uint8_t noise[300];
+	for (int i = 0; i < (int)sizeof(noise); i++)
+	{
+		noise[i] = (uint8_t)(1 + rand() % 255);
+	}
+	unsigned long errors = receiver.crc_errors + receiver.format_errors;
+	write_all(master, noise, sizeof(noise));
+	uint8_t delimiter = 0;
+	write_all(master, &delimiter, 1);
+	write_all(master, encoded, size);
+	check(sf_receive(&receiver, 1000) == 1 && receiver.crc_errors + receiver.format_errors == errors + 1,
+		"300 noise bytes (too long): rejected, next frame ok");
+
+	// Empty frames between frames are ignored
+	uint8_t delimiters[4] = { 0, 0, 0, 0 };
+	errors = receiver.crc_errors + receiver.format_errors;
+	write_all(master, delimiters, sizeof(delimiters));
+	write_all(master, encoded, size);
+	check(sf_receive(&receiver, 1000) == 1 && receiver.crc_errors + receiver.format_errors == errors,
+		"empty frames (0x00 0x00) are ignored");
+
+	// Nothing on the line: timeout
+	check(sf_receive(&receiver, 50) == 0, "timeout without data");
+}
+
+int main(void)
+{
+	int master, slave;
+
+	srand(1);
+
+	if (open_pty_pair(&master, &slave) != 0)
+	{
+		perror("pseudo terminal");
+		return 2;
+	}
+
+	test_codec();
+	test_transfer(master, slave, "500 random frames master -> slave");
+	test_transfer(slave, master, "500 random frames slave -> master");
+	test_errors(master, slave);
+
+	close(slave);
+	close(master);
+
+	return host_test_result();
+}
@@ -0,0 +1,186 @@
+/*
+ * frame_tool.c
+ *
+ * Talks to USART_Framed_Protocol over the virtual COM port.
+ *
+ *   cd Tools/serial_frame
+ *   gcc -O2 -Wall -I"../../ADC&USART/USART_Framed_Protocol/Includes/Frame_Codec" -o frame_tool \
+ *       frame_tool.c serial_frame_host.c "../../ADC&USART/USART_Framed_Protocol/Includes/Frame_Codec/Frame_Codec.c"
+ *
+ *   ./frame_tool /dev/ttyACM0 ping hello        PONG with the same text
+ *   ./frame_tool /dev/ttyACM0 rgb FF8000         set the RGB LED
+ *   ./frame_tool /dev/ttyACM0 stats              frame counters of the board
+ *   ./frame_tool /dev/ttyACM0 telemetry 20       telemetry period in ms (0 = off)
+ *   ./frame_tool /dev/ttyACM0 monitor            print telemetry until Ctrl+C
+ *
+ * Default 115200 baud, other rates with -b (e.g. -b 500000) before the port.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "serial_frame_host.h"
+
+#define MSG_PING 0x01
+#define MSG_SET_RGB 0x02
+#define MSG_GET_STATS 0x03
+#define MSG_SET_TELEMETRY 0x04
+#define MSG_ACK 0x80
+#define MSG_PONG 0x81
+#define MSG_STATS 0x83
+#define MSG_TELEMETRY 0x90
+
+#define REPLY_TIMEOUT_MS 500
+
+static const char *Status_Names[] = { "ok", "bad length", "unknown type" };
+
+static const char *Stats_Names[] = {
+	"rx frames", "crc errors", "format errors", "rx dropped",
+	"sequence gaps", "line errors", "tx frames", "tx rejected"
+};
+
+static unsigned get_u16(const uint8_t *p)
+{
+	return p[0] | (unsigned)p[1] << 8;
+}
+
+static void usage(void)
+{
+	fprintf(stderr, "usage: frame_tool [-b baud] <port> ping [text] | rgb RRGGBB | stats | telemetry <ms> | monitor\n");
+	exit(2);
+}
+
+static void print_telemetry(frame_t *frame)
+{
+	const uint8_t *p = frame_payload(frame);
+
+	if (frame_payload_length(frame) < 6)
+		return;
+
+	unsigned long time_ms = p[0] | (unsigned long)p[1] << 8 | (unsigned long)p[2] << 16 | (unsigned long)p[3] << 24;
+	printf("seq %3u  t %8lu ms  pot %4u\n", frame_sequence(frame), time_ms, get_u16(&p[4]));
+}
+
+/*
+	Waits for the answer to a command, telemetry frames in between are skipped.
+*/
+static frame_t *wait_reply(sf_link_t *link, uint8_t type)
+{
+	while (sf_receive(link, REPLY_TIMEOUT_MS) == 1)
+	{
+		uint8_t received = frame_type(&link->rx_frame);
+
+		if (received == type || received == MSG_ACK)
+			return &link->rx_frame;
+	}
+
+	fprintf(stderr, "no answer (crc errors %lu, format errors %lu)\n", link->crc_errors, link->format_errors);
+	exit(1);
+}
+
+static int print_ack(frame_t *frame)
+{
+	const uint8_t *p = frame_payload(frame);
+	unsigned status = p[1];
+
+	printf("ACK seq %u: %s\n", p[0], status < 3 ? Status_Names[status] : "?");
+	return status == 0 ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+	long baud = 115200;
+	int arg = 1;
+
+	if (argc > 2 && strcmp(argv[1], "-b") == 0)
+	{
+		baud = atol(argv[2]);
+		arg = 3;
+	}
+
+	if (argc < arg + 2)
+		usage();
+
+	int fd = sf_open(argv[arg], baud);
+	if (fd < 0)
+	{
+		perror(argv[arg]);
+		return 1;
+	}
+
+	sf_link_t link;
+	sf_init(&link, fd);
+
+	const char *command = argv[arg + 1];
+	uint8_t payload[FRAME_MAX_PAYLOAD];
+	uint8_t zero = 0;
+	(void)!write(fd, &zero, 1);											// Ends any garbage the board has received
+
+	if (strcmp(command, "ping") == 0)
+	{
+		const char *text = (argc > arg + 2) ? argv[arg + 2] : "ping";
+		size_t length = strlen(text);
+
+		if (length > FRAME_MAX_PAYLOAD)
+			length = FRAME_MAX_PAYLOAD;
+
+		sf_send(&link, MSG_PING, (const uint8_t *)text, (uint8_t)length);
+		frame_t *reply = wait_reply(&link, MSG_PONG);
+
+		if (frame_type(reply) == MSG_ACK)
+			return print_ack(reply);
+
+		printf("PONG seq %u: %.*s\n", frame_sequence(reply), frame_payload_length(reply), (const char *)frame_payload(reply));
+	}
+	else if (strcmp(command, "rgb") == 0 && argc > arg + 2)
+	{
+		unsigned long rgb = strtoul(argv[arg + 2], NULL, 16);
+
+		payload[0] = (uint8_t)(rgb >> 16);
+		payload[1] = (uint8_t)(rgb >> 8);
+		payload[2] = (uint8_t)rgb;
+		sf_send(&link, MSG_SET_RGB, payload, 3);
+		return print_ack(wait_reply(&link, MSG_ACK));
+	}
+	else if (strcmp(command, "stats") == 0)
+	{
+		sf_send(&link, MSG_GET_STATS, NULL, 0);
+		frame_t *reply = wait_reply(&link, MSG_STATS);
+
+		if (frame_type(reply) == MSG_ACK)
+			return print_ack(reply);
+
+		for (int i = 0; i < 8 && 2 * i + 1 < frame_payload_length(reply); i++)
+		{
+			printf("%-14s %u\n", Stats_Names[i], get_u16(&frame_payload(reply)[2 * i]));
+		}
+	}
+	else if (strcmp(command, "telemetry") == 0 && argc > arg + 2)
+	{
+		unsigned period = (unsigned)atoi(argv[arg + 2]);
+
+		payload[0] = (uint8_t)period;
+		payload[1] = (uint8_t)(period >> 8);
+		sf_send(&link, MSG_SET_TELEMETRY, payload, 2);
+		return print_ack(wait_reply(&link, MSG_ACK));
+	}
+	else if (strcmp(command, "monitor") == 0)
+	{
+		while (sf_receive(&link, -1) == 1)
+		{
+			if (frame_type(&link.rx_frame) == MSG_TELEMETRY)
+			{
+				print_telemetry(&link.rx_frame);
+				fflush(stdout);
+			}
+		}
+	}
+	else
+	{
+		usage();
+	}
+
+	close(fd);
+	return 0;
+}
@@ -0,0 +1,196 @@
+/*
+ * serial_frame_host.c
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include "serial_frame_host.h"
+
+static speed_t to_speed(long baud)
+{
+	switch (baud)
+	{
+		case 9600: return B9600;
+		case 19200: return B19200;
+		case 38400: return B38400;
+		case 57600: return B57600;
+		case 115200: return B115200;
+		case 230400: return B230400;
+		case 460800: return B460800;
+		case 500000: return B500000;
+		case 921600: return B921600;
+		case 1000000: return B1000000;
+		default: return 0;
+	}
+}
+
+/*
+	Raw mode, 8N1, no flow control. A baud rate of 0 keeps the speed (pseudo terminals).
+
+	@return 0, -1 on error (errno set)
+*/
+int sf_configure(int fd, long baud)
+{
+	struct termios tio;
+
+	if (tcgetattr(fd, &tio) != 0)
+		return -1;
+
+	cfmakeraw(&tio);
+	tio.c_cflag |= CLOCAL | CREAD;
+	tio.c_cflag &= ~(CSTOPB | PARENB | CRTSCTS);
+	tio.c_cc[VMIN] = 0;
+	tio.c_cc[VTIME] = 0;
+
+	if (baud != 0)
+	{
+		speed_t speed = to_speed(baud);
+
+		if (speed == 0)
+		{
+			errno = EINVAL;
+			return -1;
+		}
+
+		cfsetispeed(&tio, speed);
+		cfsetospeed(&tio, speed);
+	}
+
+	return tcsetattr(fd, TCSANOW, &tio);
+}
+
+/*
+	@return File descriptor of the configured port, -1 on error
+*/
+int sf_open(const char *path, long baud)
+{
+	int fd = open(path, O_RDWR | O_NOCTTY);
+
+	if (fd < 0)
+		return -1;
+
+	if (sf_configure(fd, baud) != 0)
+	{
+		close(fd);
+		return -1;
+	}
+
+	tcflush(fd, TCIOFLUSH);
+	return fd;
+}
+
+void sf_init(sf_link_t *link, int fd)
+{
+	memset(link, 0, sizeof(*link));
+	link->fd = fd;
+	frame_decoder_start(&link->decoder, &link->rx_frame);
+}
+
+/*
+	COBS encodes a finished frame, out needs FRAME_MAX_ENCODED bytes.
+
+	@return Number of bytes in out, the last one is the 0x00 delimiter
+*/
+int sf_encode(const frame_t *frame, uint8_t *out)
+{
+	frame_encoder_t encoder;
+	int length = 0;
+
+	frame_encoder_start(&encoder, frame);
+
+	while (frame_encoder_next(&encoder, &out[length]))
+	{
+		length++;
+	}
+
+	return length;
+}
+
+/*
+	Sends one frame with the next sequence number.
+
+	@return 0, -1 on error (payload too long or write failed)
+*/
+int sf_send(sf_link_t *link, uint8_t type, const uint8_t *payload, uint8_t length)
+{
+	frame_t frame;
+	uint8_t encoded[FRAME_MAX_ENCODED];
+
+	if (length > FRAME_MAX_PAYLOAD)
+	{
+		errno = EINVAL;
+		return -1;
+	}
+
+	memcpy(frame_payload(&frame), payload, length);
+	frame_finish(&frame, type, link->tx_sequence++, length);
+
+	int size = sf_encode(&frame, encoded);
+	int sent = 0;
+
+	while (sent < size)
+	{
+		ssize_t n = write(link->fd, &encoded[sent], size - sent);
+
+		if (n < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+
+		sent += n;
+	}
+
+	return 0;
+}
+
+/*
+	Reads until a valid frame has arrived (then in link->rx_frame) or
+	nothing arrived for timeout_ms. Damaged frames are counted and skipped.
+
+	@return 1 frame received, 0 timeout, -1 error
+*/
+int sf_receive(sf_link_t *link, int timeout_ms)
+{
+	struct pollfd pfd = { link->fd, POLLIN, 0 };
+
+	while (1)
+	{
+		uint8_t byte;
+		ssize_t n = read(link->fd, &byte, 1);
+
+		if (n == 1)
+		{
+			switch (frame_decoder_put(&link->decoder, byte))
+			{
+				case FRAME_RX_OK:
+					link->rx_frames++;
+					return 1;
+				case FRAME_RX_CRC_ERROR:
+					link->crc_errors++;
+					break;
+				case FRAME_RX_FORMAT_ERROR:
+					link->format_errors++;
+					break;
+				default:
+					break;
+			}
+			continue;
+		}
+
+		if (n < 0 && errno != EAGAIN && errno != EINTR)
+			return -1;
+
+		int ready = poll(&pfd, 1, timeout_ms);
+
+		if (ready < 0 && errno != EINTR)
+			return -1;
+		if (ready == 0)
+			return 0;
+	}
+}
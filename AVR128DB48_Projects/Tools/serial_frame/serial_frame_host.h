@@ -0,0 +1,35 @@
+/*
+ * serial_frame_host.h
+ *
+ * PC side (Linux) of the framed serial protocol: the same Frame_Codec as the
+ * firmware (ADC&USART/USART_Framed_Protocol/Includes/Frame_Codec) on a
+ * serial port or pseudo terminal file descriptor.
+ *
+ * Build together with Frame_Codec.c, see frame_tool.c and frame_loopback_test.c.
+ */
+
+#ifndef SERIAL_FRAME_HOST_H_
+#define SERIAL_FRAME_HOST_H_
+
+#include <stdint.h>
+#include "Frame_Codec.h"
+
+typedef struct {
+	int fd;
+	uint8_t tx_sequence;				// Sequence number of the next frame sent
+	frame_t rx_frame;					// Last received frame
+	frame_decoder_t decoder;
+	unsigned long rx_frames;
+	unsigned long crc_errors;
+	unsigned long format_errors;
+} sf_link_t;
+
+int sf_open(const char *path, long baud);
+int sf_configure(int fd, long baud);
+
+void sf_init(sf_link_t *link, int fd);
+int sf_encode(const frame_t *frame, uint8_t *out);
+int sf_send(sf_link_t *link, uint8_t type, const uint8_t *payload, uint8_t length);
+int sf_receive(sf_link_t *link, int timeout_ms);
+
+#endif /* SERIAL_FRAME_HOST_H_ */
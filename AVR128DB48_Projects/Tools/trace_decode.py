@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+"""
+trace_decode.py
+
+Turns a binary dump of the Trace module into a Chrome trace (JSON) timeline.
+Open the output in chrome://tracing or https://ui.perfetto.dev.
+
+The dump is requested by sending 't' to the board. Either capture it yourself
+(e.g. with a terminal that can log raw bytes) or let this script do it:
+
+    python3 trace_decode.py --port /dev/ttyACM0 --source ../Interrupts\&Timer/Programmable_Timer/main_programmable_timer.c -o trace.json
+    python3 trace_decode.py --input dump.bin --source main_adc_photoresistor.c -o trace.json
+
+Event names are read from the TRC_* enum in the firmware source (--source).
+Ids whose name ends in _BEGIN/_END are paired into spans, everything else is an instant event.
+Reading from a serial port needs pyserial (pip install pyserial).
+"""
+
+import argparse
+import json
+import re
+import struct
+import sys
+
+HEADER = struct.Struct("<4sIHB")        # magic, F_CPU, total written, record count
+RECORD = struct.Struct("<BBHI")         # id, seq, arg, cycles
+MAX_RECORDS = 128                       # TRACE_BUFFER_SIZE limit of the firmware
+MIN_F_CPU = 32768                       # Plausible F_CPU range, rejects "TRC1" inside record data
+MAX_F_CPU = 48000000
+
+
+def parse_names(source_path):
+    """Reads 'TRC_NAME = n' / 'TRC_NAME' enum entries from a C file and returns {id: name}."""
+    names = {}
+    text = open(source_path, encoding="utf-8", errors="replace").read()
+    for body in re.findall(r"enum\s*\{([^}]*)\}", text):
+        value = -1
+        found = False
+        for line in body.split("\n"):
+            line = line.split("//")[0].strip().rstrip(",")
+            m = re.match(r"(TRC_\w+)\s*(?:=\s*(\w+))?$", line)
+            if not m:
+                continue
+            found = True
+            value = int(m.group(2), 0) if m.group(2) else value + 1
+            names[value] = m.group(1)[len("TRC_"):]
+        if found:
+            break
+    return names
+
+
+def parse_block(data, start):
+    """Returns (f_cpu, written, records) if a valid dump starts at data[start], else None."""
+    if len(data) < start + HEADER.size:
+        return None
+    magic, f_cpu, written, count = HEADER.unpack_from(data, start)
+    offset = start + HEADER.size
+    if count > MAX_RECORDS or written < count or not MIN_F_CPU <= f_cpu <= MAX_F_CPU:
+        return None
+    if len(data) < offset + count * RECORD.size:
+        return None
+    records = [RECORD.unpack_from(data, offset + i * RECORD.size) for i in range(count)]
+    for (_, seq, _, _), (_, next_seq, _, _) in zip(records, records[1:]):
+        if next_seq != (seq + 1) & 0xFF:                # One dump has consecutive write indices
+            return None
+    return f_cpu, written, records
+
+
+def read_dump(data):
+    """Finds the newest 'TRC1' block in data and returns (f_cpu, written, records).
+
+    Scans forward and continues after the end of every valid block, so "TRC1"
+    bytes inside record data are never taken for a header.
+    """
+    found = None
+    position = data.find(b"TRC1")
+    while position >= 0:
+        block = parse_block(data, position)
+        if block:
+            found = block
+            position += HEADER.size + len(block[2]) * RECORD.size
+        else:
+            position += 1
+        position = data.find(b"TRC1", position)
+    if found is None:
+        if b"TRC1" in data:
+            raise ValueError("no complete TRC1 dump found in the input (truncated?)")
+        raise ValueError("no TRC1 header found in the input")
+    return found
+
+
+def capture(port, baud, timeout):
+    import serial  # pyserial
+    with serial.Serial(port, baud, timeout=timeout) as ser:
+        ser.reset_input_buffer()
+        ser.write(b"t")
+        data = b""
+        while True:
+            chunk = ser.read(4096)
+            if not chunk:
+                break
+            data += chunk
+    return data
+
+
+def to_chrome_trace(f_cpu, records, names):
+    cycles_per_us = f_cpu / 1e6
+    events = []
+    wrap = 0
+    last = None
+    gaps = 0
+    prev_seq = None
+    for rec_id, seq, arg, cycles in records:
+        if last is not None and last - cycles > 1 << 31:
+            wrap += 1 << 32                           # 32-bit cycle counter wrapped (not just a small step back)
+        last = cycles
+        if prev_seq is not None and seq != ((prev_seq + 1) & 0xFF):
+            gaps += 1
+        prev_seq = seq
+
+        ts = (cycles + wrap) / cycles_per_us
+        name = names.get(rec_id, "id%d" % rec_id)
+        if name.endswith("_BEGIN"):
+            phase, name = "B", name[:-len("_BEGIN")]
+        elif name.endswith("_END"):
+            phase, name = "E", name[:-len("_END")]
+        else:
+            phase = "i"
+        event = {"name": name, "ph": phase, "ts": ts, "pid": 0, "tid": 0, "args": {"arg": arg, "seq": seq}}
+        if phase == "i":
+            event["s"] = "t"
+        events.append(event)
+    return events, gaps
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode a Trace module dump into Chrome trace JSON")
+    src = parser.add_mutually_exclusive_group(required=True)
+    src.add_argument("--input", help="file with the raw dump")
+    src.add_argument("--port", help="serial port to request the dump from")
+    parser.add_argument("--baud", type=int, default=9600)
+    parser.add_argument("--timeout", type=float, default=2.0, help="serial read timeout in s")
+    parser.add_argument("--source", help="firmware C file with the TRC_* enum")
+    parser.add_argument("-o", "--output", default="-", help="output JSON file (default stdout)")
+    args = parser.parse_args()
+
+    data = open(args.input, "rb").read() if args.input else capture(args.port, args.baud, args.timeout)
+    f_cpu, written, records = read_dump(data)
+    names = parse_names(args.source) if args.source else {}
+    events, gaps = to_chrome_trace(f_cpu, records, names)
+
+    lost = max(0, written - len(records))
+    at_least = ">=" if written == 0xFFFF else ""          # The firmware counter stops at 65535
+    sys.stderr.write("F_CPU %d Hz, %d records (%s%d written, %s%d overwritten), %d sequence gaps\n"
+                     % (f_cpu, len(records), at_least, written, at_least, lost, gaps))
+    if records:
+        span_us = ((records[-1][3] - records[0][3]) & 0xFFFFFFFF) * 1e6 / f_cpu
+        sys.stderr.write("time span %.1f us\n" % span_us)
+
+    out = json.dumps({"traceEvents": events, "displayTimeUnit": "ns"}, indent=1)
+    if args.output == "-":
+        print(out)
+    else:
+        with open(args.output, "w") as f:
+            f.write(out)
+
+
+if __name__ == "__main__":
+    main()
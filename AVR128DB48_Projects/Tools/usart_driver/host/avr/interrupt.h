@@ -0,0 +1,17 @@
+/*
+ * interrupt.h
+ *
+ * Host stand-in for <avr/interrupt.h>: cli() and sei() change the I bit of
+ * the simulated SREG, so the test can check that every critical section
+ * restores it.
+ */
+
+#ifndef HOST_AVR_INTERRUPT_H_
+#define HOST_AVR_INTERRUPT_H_
+
+#include "io.h"
+
+#define cli() (SREG &= (uint8_t)~CPU_I_bm)
+#define sei() (SREG |= CPU_I_bm)
+
+#endif /* HOST_AVR_INTERRUPT_H_ */
@@ -0,0 +1,59 @@
+/*
+ * io.h
+ *
+ * Host stand-in for <avr/io.h>, only what USART_Driver needs: the USART
+ * registers as plain RAM (bit positions as on the AVR128DB48) and SREG.
+ * The test plays the hardware by writing RXDATAL/RXDATAH and reading TXDATAL.
+ */
+
+#ifndef HOST_AVR_IO_H_
+#define HOST_AVR_IO_H_
+
+#include <stdint.h>
+
+typedef struct {
+	volatile uint8_t RXDATAL;
+	volatile uint8_t RXDATAH;
+	volatile uint8_t TXDATAL;
+	volatile uint8_t TXDATAH;
+	volatile uint8_t STATUS;
+	volatile uint8_t CTRLA;
+	volatile uint8_t CTRLB;
+	volatile uint8_t CTRLC;
+	volatile uint16_t BAUD;
+	volatile uint8_t CTRLD;
+} USART_t;
+
+// RXDATAH
+#define USART_BUFOVF_bm 0x40
+#define USART_FERR_bm 0x04
+#define USART_PERR_bm 0x02
+
+// STATUS
+#define USART_RXCIF_bm 0x80
+#define USART_TXCIF_bm 0x40
+#define USART_DREIF_bm 0x20
+
+// CTRLA
+#define USART_RXCIE_bm 0x80
+#define USART_TXCIE_bm 0x40
+#define USART_DREIE_bm 0x20
+
+// CTRLB
+#define USART_RXEN_bm 0x80
+#define USART_TXEN_bm 0x40
+#define USART_RXMODE_gm 0x06
+#define USART_RXMODE_NORMAL_gc 0x00
+#define USART_RXMODE_CLK2X_gc 0x02
+
+// CTRLC
+#define USART_CMODE_ASYNCHRONOUS_gc 0x00
+#define USART_PMODE_DISABLED_gc 0x00
+#define USART_SBMODE_1BIT_gc 0x00
+#define USART_CHSIZE_8BIT_gc 0x03
+
+#define CPU_I_bm 0x80
+
+extern volatile uint8_t SREG;
+
+#endif /* HOST_AVR_IO_H_ */
@@ -0,0 +1,378 @@
+/*
+ * usart_driver_test.c
+ *
+ * Checks USART_Driver on the PC. The USART is a struct in RAM (host/avr/io.h),
+ * the test plays the hardware: it puts bytes and error flags into RXDATAL /
+ * RXDATAH and calls the RXC ISR, it calls the DRE ISR and takes TXDATAL.
+ * cli() clears the I bit of a simulated SREG, so every call also checks that
+ * the critical sections restore it.
+ *
+ *   cd Tools/usart_driver
+ *   gcc -O2 -Wall -Ihost -I"../../ADC&USART/USART_Buttons/Includes/USART_Driver" -o usart_driver_test \
+ *       usart_driver_test.c "../../ADC&USART/USART_Buttons/Includes/USART_Driver/USART_Driver.c"
+ *   ./usart_driver_test
+ *
+ * Prints one line per check, exit status 0 if all passed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "USART_Driver.h"
+#include "../host_test.h"
+
+#define RANDOM_STEPS 1000000L
+
+volatile uint8_t SREG = CPU_I_bm;					// Interrupts enabled, as in main after sei()
+
+static USART_t Hw;
+
+USART_DRIVER_DEFINE(Serial, 128, 128);				// Largest rings: the 8-bit indices wrap at twice the size
+USART_DRIVER_DEFINE(Small, 4, 4);
+
+static void setup(usart_driver_t *usart)
+{
+	memset((void *)&Hw, 0, sizeof(Hw));
+	usart_driver_init(usart, &Hw, USART_BAUD_VALUE(115200), USART_NORMAL_SPEED);
+}
+
+/*
+	The USART received a byte: RXDATAH holds the error flags, then the RXC ISR runs.
+*/
+static void receive(usart_driver_t *usart, uint8_t data, uint8_t flags)
+{
+	Hw.RXDATAL = data;
+	Hw.RXDATAH = flags;
+	usart_driver_rx_isr(usart);
+}
+
+/*
+	Runs the DRE ISR while DREIE is set, as the hardware would (at most 1000
+	times, a DREIE that is never cleared shows up as a wrong count).
+	@return Number of bytes sent, copied to data (up to max_length)
+*/
+static uint16_t transmit(usart_driver_t *usart, uint8_t *data, uint16_t max_length)
+{
+	uint16_t count = 0;
+
+	for (uint16_t calls = 0; calls < 1000 && (Hw.CTRLA & USART_DREIE_bm); calls++)
+	{
+		uint8_t tail = usart->tx_tail;
+
+		usart_driver_dre_isr(usart);
+		if (usart->tx_tail != tail)
+		{
+			if (count < max_length)
+				data[count] = Hw.TXDATAL;
+			count++;
+		}
+	}
+
+	return count;
+}
+
+static int errors_are(const usart_driver_t *usart, uint16_t overflows, uint16_t overruns,
+	uint16_t frame, uint16_t parity, uint16_t rejected)
+{
+	usart_errors_t e;
+
+	usart_driver_get_errors(usart, &e);
+	return e.rx_overflows == overflows && e.hw_overruns == overruns && e.frame_errors == frame
+		&& e.parity_errors == parity && e.tx_rejected == rejected;
+}
+
+static void check_init(void)
+{
+	setup(&Serial);
+	check(Hw.BAUD == USART_BAUD_VALUE(115200) && Hw.CTRLA == USART_RXCIE_bm
+		&& Hw.CTRLB == (USART_RXEN_bm | USART_TXEN_bm) && Hw.CTRLC == USART_CHSIZE_8BIT_gc,
+		"init: BAUD, RXCIE only, RXEN | TXEN, 8N1");
+
+	usart_driver_init(&Serial, &Hw, USART_BAUD_VALUE_2X(500000), USART_DOUBLE_SPEED);
+	check((Hw.CTRLB & USART_RXMODE_gm) == USART_RXMODE_CLK2X_gc, "init: CLK2X for USART_DOUBLE_SPEED");
+
+	check(usart_driver_tx_free(&Serial) == 128 && usart_driver_rx_available(&Serial) == 0
+		&& errors_are(&Serial, 0, 0, 0, 0, 0), "init: rings empty, counters zero");
+}
+
+/*
+	Pushes 1000 bytes through both 128 byte rings in uneven chunks, so head
+	and tail wrap at 128 (slot) and 256 (index) at every possible offset.
+*/
+static void check_wrap(void)
+{
+	uint8_t out[128];
+	uint8_t next_tx = 0;
+	uint8_t expect_tx = 0;
+	uint8_t next_rx = 0;
+	uint8_t expect_rx = 0;
+	int tx_ok = 1;
+	int rx_ok = 1;
+	int full_ok = 1;
+
+	setup(&Serial);
+
+	for (uint16_t total = 0; total < 1000; )
+	{
+		uint8_t chunk = (uint8_t)(1 + total % 97);
+		uint8_t data[128];
+
+		for (uint8_t i = 0; i < chunk; i++)
+		{
+			data[i] = next_tx++;
+		}
+		tx_ok &= usart_driver_write(&Serial, data, chunk);
+
+		uint16_t sent = transmit(&Serial, out, sizeof(out));
+
+		tx_ok &= sent == chunk && !(Hw.CTRLA & USART_DREIE_bm);
+		for (uint8_t i = 0; i < chunk; i++)
+		{
+			tx_ok &= out[i] == expect_tx++;
+		}
+
+		for (uint8_t i = 0; i < chunk; i++)
+		{
+			receive(&Serial, next_rx++, 0);
+		}
+		rx_ok &= usart_driver_rx_available(&Serial) == chunk;
+		rx_ok &= usart_driver_read(&Serial, data, sizeof(data)) == chunk;
+		for (uint8_t i = 0; i < chunk; i++)
+		{
+			rx_ok &= data[i] == expect_rx++;
+		}
+
+		total += chunk;
+	}
+
+	// Completely full rings at an index offset that is not a multiple of 128
+	uint8_t fill[128];
+
+	for (uint8_t i = 0; i < 128; i++)
+	{
+		fill[i] = (uint8_t)(i ^ 0x5A);
+		receive(&Serial, fill[i], 0);
+	}
+	full_ok &= usart_driver_write(&Serial, fill, 128) && usart_driver_tx_free(&Serial) == 0;
+	full_ok &= usart_driver_rx_available(&Serial) == 128;
+	full_ok &= transmit(&Serial, out, sizeof(out)) == 128 && memcmp(out, fill, 128) == 0;
+	full_ok &= usart_driver_read(&Serial, out, sizeof(out)) == 128 && memcmp(out, fill, 128) == 0;
+
+	check(tx_ok, "TX ring 128: 1000 bytes in order across the wrap");
+	check(rx_ok, "RX ring 128: 1000 bytes in order across the wrap");
+	check(full_ok && errors_are(&Serial, 0, 0, 0, 0, 0), "128 bytes fill each ring completely");
+}
+
+/*
+	A write that does not fit changes nothing but the rejected counter.
+*/
+static void check_all_or_nothing(void)
+{
+	uint8_t data[128];
+	uint8_t out[128];
+
+	memset(data, 'x', sizeof(data));
+	setup(&Serial);
+
+	usart_driver_write(&Serial, data, 100);
+	uint8_t head = Serial.tx_head;
+
+	check(!usart_driver_write(&Serial, data, 29) && Serial.tx_head == head
+		&& usart_driver_tx_free(&Serial) == 28 && errors_are(&Serial, 0, 0, 0, 0, 29),
+		"write 29 with 28 free: refused, ring unchanged");
+	check(usart_driver_write(&Serial, data, 28) && usart_driver_tx_free(&Serial) == 0,
+		"write 28 with 28 free: accepted");
+	check(!usart_driver_put_char(&Serial, 'y') && errors_are(&Serial, 0, 0, 0, 0, 30),
+		"put_char on a full ring: refused and counted");
+	check(transmit(&Serial, out, sizeof(out)) == 128, "exactly the accepted 128 bytes are sent");
+
+	char long_string[300];
+
+	memset(long_string, 's', sizeof(long_string) - 1);
+	long_string[sizeof(long_string) - 1] = '\0';
+	check(!usart_driver_put_string(&Serial, long_string) && usart_driver_tx_free(&Serial) == 128
+		&& errors_are(&Serial, 0, 0, 0, 0, 30 + 299),
+		"put_string of 299 bytes: refused, not truncated");
+
+	setup(&Small);
+	check(usart_driver_put_string(&Small, "abcd") && !usart_driver_put_string(&Small, "e")
+		&& errors_are(&Small, 0, 0, 0, 0, 1), "ring 4: \"abcd\" fits, then \"e\" is refused");
+
+	check(SREG == CPU_I_bm, "interrupts enabled again after the refused writes");
+}
+
+static void check_rx_overflow(void)
+{
+	uint8_t out[4];
+
+	setup(&Small);
+	for (uint8_t i = 0; i < 6; i++)
+	{
+		receive(&Small, (uint8_t)('a' + i), 0);
+	}
+	check(usart_driver_rx_available(&Small) == 4 && errors_are(&Small, 2, 0, 0, 0, 0),
+		"ring 4: 6 bytes received, 2 overflows counted");
+	check(usart_driver_read(&Small, out, 4) == 4 && memcmp(out, "abcd", 4) == 0,
+		"the first 4 bytes are kept, the ring is not overwritten");
+
+	receive(&Small, 'g', 0);
+	char c = 0;
+	check(usart_driver_get_char(&Small, &c) && c == 'g' && !usart_driver_get_char(&Small, &c),
+		"after reading, the next byte is stored again");
+
+	usart_driver_clear_errors(&Small);
+	check(errors_are(&Small, 0, 0, 0, 0, 0), "clear_errors resets the counters");
+}
+
+static void check_rx_errors(void)
+{
+	uint8_t data = 0;
+
+	setup(&Small);
+	receive(&Small, 'A', USART_BUFOVF_bm);
+	receive(&Small, 'B', USART_FERR_bm);
+	receive(&Small, 'C', USART_PERR_bm);
+	receive(&Small, 'D', USART_FERR_bm | USART_PERR_bm);
+	receive(&Small, 'E', 0);
+
+	char c1 = 0;
+	char c2 = 0;
+	check(usart_driver_get_char(&Small, &c1) && usart_driver_get_char(&Small, &c2)
+		&& c1 == 'A' && c2 == 'E' && usart_driver_rx_available(&Small) == 0,
+		"BUFOVF byte kept, FERR / PERR bytes dropped");
+	check(errors_are(&Small, 0, 1, 2, 1, 0), "1 overrun, 2 frame errors, 1 parity error");
+
+	Hw.RXDATAL = 'F';
+	Hw.RXDATAH = USART_BUFOVF_bm;
+	check(usart_driver_rx_read(&Small, &data) && data == 'F', "rx_read: BUFOVF returns the byte");
+	Hw.RXDATAL = 'G';
+	Hw.RXDATAH = USART_PERR_bm;
+	check(!usart_driver_rx_read(&Small, &data) && errors_are(&Small, 0, 2, 2, 2, 0),
+		"rx_read: PERR returns false, counters shared");
+	check(usart_driver_rx_available(&Small) == 0, "rx_read does not use the ring");
+}
+
+static void check_dre(void)
+{
+	setup(&Small);
+	usart_driver_dre_isr(&Small);
+	check(!(Hw.CTRLA & USART_DREIE_bm) && Hw.TXDATAL == 0, "DRE on an empty ring: nothing sent");
+
+	usart_driver_write(&Small, (const uint8_t *)"ab", 2);
+	check((Hw.CTRLA & (USART_DREIE_bm | USART_RXCIE_bm)) == (USART_DREIE_bm | USART_RXCIE_bm),
+		"write sets DREIE, RXCIE stays");
+
+	usart_driver_dre_isr(&Small);
+	usart_driver_dre_isr(&Small);
+	check((Hw.CTRLA & USART_DREIE_bm) && Hw.TXDATAL == 'b', "DREIE stays set while the last byte goes out");
+
+	usart_driver_dre_isr(&Small);
+	check(!(Hw.CTRLA & USART_DREIE_bm) && (Hw.CTRLA & USART_RXCIE_bm), "DRE on the empty ring clears DREIE only");
+
+	Hw.STATUS = 0;												// RAM model: TXCIF is not set by hardware
+	check(!usart_driver_tx_done(&Small), "tx_done waits for TXCIF");
+	Hw.STATUS = USART_TXCIF_bm;
+	check(usart_driver_tx_done(&Small), "tx_done with an empty ring and TXCIF");
+}
+
+/*
+	Random interleaving of main (write, read) and the ISRs against a model of
+	the byte streams.
+*/
+static void check_random(void)
+{
+	uint8_t tx_next = 0;
+	uint8_t tx_expect = 0;
+	uint8_t rx_next = 0;
+	uint8_t rx_expect = 0;
+	uint16_t tx_queued = 0;
+	uint16_t rx_queued = 0;
+	uint32_t overflows = 0;
+	int ok = 1;
+
+	setup(&Serial);
+	srand(1);
+
+	for (long step = 0; step < RANDOM_STEPS && ok; step++)
+	{
+		switch (rand() % 4)
+		{
+		case 0:												// main writes
+		{
+			uint8_t data[128];
+			uint8_t length = (uint8_t)(1 + rand() % 40);
+			bool fits = length <= 128 - tx_queued;
+
+			for (uint8_t i = 0; i < length; i++)
+			{
+				data[i] = (uint8_t)(tx_next + i);
+			}
+			ok &= usart_driver_write(&Serial, data, length) == fits;
+			if (fits)
+			{
+				tx_next += length;
+				tx_queued += length;
+			}
+			break;
+		}
+		case 1:												// DRE ISR
+			if (Hw.CTRLA & USART_DREIE_bm)
+			{
+				usart_driver_dre_isr(&Serial);
+				if (tx_queued > 0)
+				{
+					ok &= Hw.TXDATAL == tx_expect++;
+					tx_queued--;
+				}
+			}
+			break;
+		case 2:												// RXC ISR
+			receive(&Serial, rx_next, 0);
+			if (rx_queued < 128)
+			{
+				rx_next++;
+				rx_queued++;
+			}
+			else
+			{
+				overflows++;
+			}
+			break;
+		default:											// main reads
+		{
+			uint8_t data[64];
+			uint8_t count = usart_driver_read(&Serial, data, (uint8_t)(rand() % 64));
+
+			for (uint8_t i = 0; i < count; i++)
+			{
+				ok &= data[i] == rx_expect++;
+			}
+			rx_queued -= count;
+			break;
+		}
+		}
+
+		ok &= usart_driver_tx_free(&Serial) == 128 - tx_queued;
+		ok &= usart_driver_rx_available(&Serial) == rx_queued;
+		ok &= (tx_queued == 0) || (Hw.CTRLA & USART_DREIE_bm);
+	}
+
+	usart_errors_t e;
+	usart_driver_get_errors(&Serial, &e);
+	ok &= e.rx_overflows == (uint16_t)overflows;
+
+	check(ok && SREG == CPU_I_bm, "1000000 random ISR / main steps against a model");
+}
+
+int main(void)
+{
+	check_init();
+	check_wrap();
+	check_all_or_nothing();
+	check_rx_overflow();
+	check_rx_errors();
+	check_dre();
+	check_random();
+
+	return host_test_result();
+}